@@ -1,159 +1,190 @@
-#pragma once
-#include "VulkanAppBase.h"
-#include <glm/glm.hpp>
-#include <array>
-#include "Camera.h"
-
-class CubemapRenderingApp : public VulkanAppBase
-{
-public:
-  CubemapRenderingApp();
-
-  virtual void Prepare();
-  virtual void Cleanup();
-  virtual void Render();
-
-  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
-  virtual bool OnMouseButtonDown(int button);
-  virtual bool OnMouseButtonUp(int button);
-  virtual bool OnMouseMove(int dx, int dy);
-
-private:
-  // {AvŎgp郌CAEg(fBXNv^CAEg/pCvCCAEg)쐬.
-  void CreateSampleLayouts();
-
-  void PrepareFramebuffers();
-  
-  void PrepareSceneResource();
- 
-  VkPipeline CreateRenderTeapotPipeline(
-    const std::string& renderPass,
-    uint32_t width, uint32_t height,
-    const std::string& layoutName,
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStages);
-
-  ImageObject LoadCubeTextureFromFile(const char* faceFiles[6]);
-
-  void PrepareRenderTargetForMultiPass();
-  void PrepareRenderTargetForSinglePass();
-
-  void PrepareCenterTeapotDescriptors();
-  void PrepareAroundTeapotDescriptors();
-
-  void RenderCubemapFaces(VkCommandBuffer command);
-  void RenderCubemapOnce(VkCommandBuffer command);
-  void RenderToMain(VkCommandBuffer command);
-  void RenderHUD(VkCommandBuffer command);
-
-  // \[XoA̐ݒ.
-  void BarrierRTToTexture(VkCommandBuffer command);
-  void BarrierTextureToRT(VkCommandBuffer command);
-
-private:
-  ImageObject m_depthBuffer;
-  std::vector<VkFramebuffer> m_framebuffers;
-
-  struct FrameCommandBuffer
-  {
-    VkCommandBuffer commandBuffer;
-    VkFence fence;
-  };
-  std::vector<FrameCommandBuffer> m_commandBuffers;
- 
-  uint32_t m_imageIndex;
-
-  Camera m_camera;
-  ModelData m_teapot;
-  ImageObject m_staticCubemap;
-  ImageObject m_cubemapRendered;
-  VkSampler m_cubemapSampler;
-
-  struct ShaderParameters
-  {
-    glm::mat4 world;
-    glm::mat4 view;
-    glm::mat4 proj;
-    glm::vec4 lightDir;
-    glm::vec4 cameraPos;
-  };
-
-  struct TeapotInstanceParameters {
-    glm::mat4 world[6];
-    glm::vec4 colors[6];
-  };
-  struct ViewProjMatrices
-  {
-    glm::mat4 view;
-    glm::mat4 proj;
-    glm::vec4 lightDir;
-  };
-  struct MultiViewProjMatrices
-  {
-    glm::mat4 view[6];
-    glm::mat4 proj;
-    glm::vec4 lightDir;
-  };
-  BufferObject m_cubemapEnvUniform;
-
-
-  // ӃeB[|bg:(To Main)
-  struct AroundTeapotsToMainScene
-  {
-    VkPipeline pipeline;
-    std::vector<BufferObject> cameraViewUniform;
-    std::vector<VkDescriptorSet> descriptors;
-
-  } m_aroundTeapotsToMain;
-  // ӃeB[|bg:(To CubemapFace)
-  struct AroundTeapotsToCubeFaceScene
-  {
-    VkPipeline pipeline;
-    std::vector<BufferObject> cameraViewUniform[6];
-    std::vector<VkDescriptorSet> descriptors[6];
-  } m_aroundTeapotsToFace;
-
-  // ӃeB[|bg:(To CubemapOnce)
-  struct AroundTeapotsToCubeScene
-  {
-    VkPipeline pipeline;
-    std::vector<BufferObject> cameraViewUniform;
-    std::vector<VkDescriptorSet> descriptors;
-  } m_aroundTeapotsToCubemap;
-
-  // S̃eB[|bg.
-  struct CenterTeapot
-  {
-    std::vector<VkDescriptorSet> dsCubemapStatic;
-    std::vector<VkDescriptorSet> dsCubemapRendered;
-    std::vector<BufferObject> sceneUBO;
-    VkPipeline pipeline;
-  } m_centerTeapot;
-
-  struct CubeFaceScene
-  {
-    VkImageView viewFaces[6];
-    ImageObject depth;
-    VkFramebuffer fbFaces[6];
-    VkRenderPass  renderPass;
-  } m_cubeFaceScene;
-
-  struct CubemapSingleScene
-  {
-    VkImageView view;
-    ImageObject depth;
-    VkFramebuffer framebuffer;
-    VkRenderPass renderPass;
-  } m_cubeScene;
-
-
-  const uint32_t CubeEdge = 512;
-  const VkFormat CubemapFormat = VK_FORMAT_R8G8B8A8_UNORM;
-  glm::mat4 m_projection;
-
-  enum Mode {
-    Mode_StaticCubemap,
-    Mode_MultiPassCubemap,
-    Mode_SinglePassCubemap,
-  };
-  Mode m_mode;
+#pragma once
+#include "VulkanAppBase.h"
+#include <glm/glm.hpp>
+#include <array>
+#include "Camera.h"
+
+class CubemapRenderingApp : public VulkanAppBase
+{
+public:
+  CubemapRenderingApp();
+
+  virtual void Prepare();
+  virtual void Cleanup();
+  virtual void Render();
+
+  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
+  virtual bool OnMouseButtonDown(int button);
+  virtual bool OnMouseButtonUp(int button);
+  virtual bool OnMouseMove(int dx, int dy);
+
+  // ベンチマーク用の設定の切り替えとカメラ経路.
+  virtual std::vector<BenchmarkVariant> GetBenchmarkVariants();
+  virtual void SetBenchmarkPose(float t);
+  virtual std::vector<uint32_t> GetUniformWriteSizes();
+
+  // 使用するデバイスの機能.
+  virtual CapabilityProfile GetCapabilityProfile();
+  // 記録/再生するフレームの入力.
+  virtual void SerializeFrameInputs(FrameArchive& archive);
+
+private:
+  // 本アプリで使用するレイアウト(ディスクリプタレイアウト/パイプラインレイアウト)を作成.
+  void CreateSampleLayouts();
+
+  // フレームの描画グラフを組み立て、グラフのイメージを使うフレームバッファを作る.
+  // モードやサイズが変わったら GPU の完了を待って作り直す.
+  void BuildRenderGraph();
+  void DestroyGraphFramebuffers();
+  
+  void PrepareSceneResource();
+ 
+  VkPipeline CreateRenderTeapotPipeline(
+    const std::string& renderPass,
+    uint32_t width, uint32_t height,
+    VkPipelineLayout layout,
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages);
+
+  ImageObject LoadCubeTextureFromFile(const char* faceFiles[6]);
+
+  void PrepareRenderTargetForMultiPass();
+  void PrepareRenderTargetForSinglePass();
+
+  void PrepareCenterTeapotDescriptors();
+  void PrepareAroundTeapotDescriptors();
+  // バインドレス描画用のパイプラインとリソースの番号.
+  void PrepareBindlessResources();
+  BindlessDescriptorTable::DrawIndices GetAroundTeapotIndices(uint32_t viewOffset) const;
+
+  void RenderCubemapFaces(VkCommandBuffer command);
+  void RenderCubemapOnce(VkCommandBuffer command);
+  void RenderMainPass(VkCommandBuffer command);
+  void RenderToMain(VkCommandBuffer command);
+  void RenderHUD(VkCommandBuffer command);
+
+private:
+  std::vector<VkFramebuffer> m_framebuffers;
+  // 描画ループで引くものは登録時の Handle を保持する.
+  RenderPassHandle m_renderPass;
+  PipelineLayoutHandle m_layoutU1T1;
+  PipelineLayoutHandle m_layoutU2;
+  DescriptorUpdateTemplateHandle m_templateU1T1;
+  DescriptorUpdateTemplateHandle m_templateU2;
+ 
+  uint32_t m_imageIndex;
+
+  Camera m_camera;
+  ModelData m_teapot;
+  ImageObject m_staticCubemap;
+  ImageObject m_cubemapRendered;
+  VkSampler m_cubemapSampler;
+
+  struct ShaderParameters
+  {
+    glm::mat4 world;
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec4 lightDir;
+    glm::vec4 cameraPos;
+  };
+
+  struct TeapotInstanceParameters {
+    glm::mat4 world[6];
+    glm::vec4 colors[6];
+  };
+  struct ViewProjMatrices
+  {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec4 lightDir;
+  };
+  struct MultiViewProjMatrices
+  {
+    glm::mat4 view[6];
+    glm::mat4 proj;
+    glm::vec4 lightDir;
+  };
+  BufferObject m_cubemapEnvUniform;
+
+  // 毎フレーム更新するユニフォームはリングバッファから切り出してダイナミックオフセットで参照する.
+  UniformRingBuffer* m_uniformRing;
+  // 周辺ティーポット(To Main / To CubemapFace)共通のディスクリプタ.
+  VkDescriptorSet m_dsAroundTeapots;
+
+  // 周辺ティーポット:(To Main)
+  struct AroundTeapotsToMainScene
+  {
+    VkPipeline pipeline;
+    uint32_t cameraViewOffset;
+  } m_aroundTeapotsToMain;
+  // 周辺ティーポット:(To CubemapFace)
+  struct AroundTeapotsToCubeFaceScene
+  {
+    VkPipeline pipeline;
+    uint32_t cameraViewOffset[6];
+  } m_aroundTeapotsToFace;
+
+  // 周辺ティーポット:(To CubemapOnce)
+  struct AroundTeapotsToCubeScene
+  {
+    VkPipeline pipeline;
+    uint32_t cameraViewOffset;
+    VkDescriptorSet descriptor;
+  } m_aroundTeapotsToCubemap;
+
+  // バインドレス描画. デバイスが対応していない場合は m_bindless が null.
+  // 全体共通のセットはフレームの先頭で 1 度だけバインドし、描画ごとにプッシュ定数で番号を渡す.
+  BindlessDescriptorTable* m_bindless;
+  bool m_useBindless;
+  struct BindlessScene
+  {
+    uint32_t ringBuffer;
+    uint32_t envBuffer;
+    uint32_t staticCubemap;
+    uint32_t renderedCubemap;
+    VkPipeline centerTeapot;
+    VkPipeline aroundTeapotsToMain;
+    VkPipeline aroundTeapotsToFace;
+    VkPipeline aroundTeapotsToCubemap;
+  } m_bindlessScene;
+
+  // 中心のティーポット.
+  struct CenterTeapot
+  {
+    VkDescriptorSet dsCubemapStatic;
+    VkDescriptorSet dsCubemapRendered;
+    uint32_t sceneOffset;
+    VkPipeline pipeline;
+  } m_centerTeapot;
+
+  struct CubeFaceScene
+  {
+    VkImageView viewFaces[6];
+    VkFramebuffer fbFaces[6];
+    VkRenderPass  renderPass;
+  } m_cubeFaceScene;
+
+  struct CubemapSingleScene
+  {
+    VkImageView view;
+    VkFramebuffer framebuffer;
+    VkRenderPass renderPass;
+  } m_cubeScene;
+
+
+  const uint32_t CubeEdge = 512;
+  const VkFormat CubemapFormat = VK_FORMAT_R8G8B8A8_UNORM;
+  glm::mat4 m_projection;
+
+  enum Mode {
+    Mode_StaticCubemap,
+    Mode_MultiPassCubemap,
+    Mode_SinglePassCubemap,
+  };
+  Mode m_mode;
+
+  // デプスバッファはグラフの一時イメージ. 描画先のキューブマップはモードをまたいで使うため取り込む.
+  RenderGraph* m_graph;
+  RenderGraph::ResourceHandle m_graphCubemap;
+  Mode m_graphMode;   // グラフを組み立てたモード. フレーム内の描画はこちらに従う.
 };
\ No newline at end of file
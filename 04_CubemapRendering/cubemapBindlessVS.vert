@@ -0,0 +1,30 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "../common/Bindless.glsl"
+
+layout(location=0) in vec4 inPos;
+layout(location=1) in vec3 inNormal;
+
+layout(location=0) out vec3 outColor;
+layout(location=1) out vec3 outNormal;
+
+out gl_PerVertex
+{
+  vec4 gl_Position;
+};
+
+// buffers[0]: CubemapEnvParameters(world[6], colors[6]).
+// buffers[1]: ViewMatrices(view[6], proj, lightDir).
+void main()
+{
+  mat4 world = LoadMatrix(0, gl_InstanceIndex * 4);
+  vec4 color = LoadVector(0, 24 + gl_InstanceIndex);
+  vec4 lightDir = LoadVector(1, 28);
+
+  gl_Position = world * inPos;
+  
+  vec3 worldNormal = mat3(world) * inNormal;
+  float l = dot(worldNormal, normalize(lightDir.xyz)) * 0.5 + 0.5;
+  outColor = color.xyz * l;
+  outNormal = worldNormal;
+}
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "../common/Bindless.glsl"
+
+layout(location=0) in vec3 inColor;
+layout(location=1) in vec3 inNormal;
+layout(location=2) in vec3 inWorldPos;
+
+layout(location=0) out vec4 outColor;
+
+// buffers[0]: SceneParameters, textures[0]: L[u}bv.
+void main()
+{
+  vec4 cameraPos = LoadVector(0, 13);
+
+  vec3 incident = normalize(inWorldPos.xyz - cameraPos.xyz);
+  vec3 r = reflect(incident, inNormal);
+  vec4 color = texture(bindlessTexturesCube[draw.textures[0]], r) * vec4(inColor,1);
+  outColor = color;
+}
@@ -0,0 +1,33 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#include "../common/Bindless.glsl"
+
+layout(location=0) in vec4 inPos;
+layout(location=1) in vec3 inNormal;
+
+layout(location=0) out vec3 outColor;
+layout(location=1) out vec3 outNormal;
+layout(location=2) out vec4 outWorldPos;
+
+
+out gl_PerVertex
+{
+  vec4 gl_Position;
+};
+
+// buffers[0]: SceneParameters(world, view, proj, lightDir, cameraPos).
+void main()
+{
+  mat4 world = LoadMatrix(0, 0);
+  mat4 view = LoadMatrix(0, 4);
+  mat4 proj = LoadMatrix(0, 8);
+  vec4 lightDir = LoadVector(0, 12);
+
+  gl_Position = proj * view * world * inPos;
+  
+  vec3 worldNormal = mat3(world) * inNormal;
+  float l = dot(worldNormal, normalize(lightDir.xyz)) * 0.5 + 0.5;
+  outColor = vec3(l);
+  outNormal = worldNormal;
+  outWorldPos = world * inPos;
+}
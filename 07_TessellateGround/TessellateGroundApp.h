@@ -1,84 +1,104 @@
-#pragma once
-#include "VulkanAppBase.h"
-#include <glm/glm.hpp>
-#include <array>
-#include "Camera.h"
-
-class TessellateGroundApp : public VulkanAppBase
-{
-public:
-  TessellateGroundApp();
-
-  virtual void Prepare();
-  virtual void Cleanup();
-  virtual void Render();
-
-  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
-  virtual bool OnMouseButtonDown(int button);
-  virtual bool OnMouseButtonUp(int button);
-  virtual bool OnMouseMove(int dx, int dy);
-
-  struct ShaderParameters
-  {
-    glm::mat4 world;
-    glm::mat4 view;
-    glm::mat4 proj;
-    glm::vec4 lightPos;
-    glm::vec4 cameraPos;
-  };
-
-private:
-  // {AvŎgp郌CAEg(fBXNv^CAEg/pCvCCAEg)쐬.
-  void CreateSampleLayouts();
-
-  void PrepareFramebuffers();
-  
-  void PrepareSceneResource();
-
-  struct Vertex
-  {
-    glm::vec3 Position;
-    glm::vec2 UV;
-  };
-
-  ImageObject Load2DTextureFromFile(const char* fileName);
-  ImageObject LoadCubeTextureFromFile(const char* faceFiles[6]);
-
-  void PreparePrimitiveResource();
-
-  void RenderHUD(VkCommandBuffer command);
-private:
-  ImageObject m_depthBuffer;
-  std::vector<VkFramebuffer> m_framebuffers;
-
-  struct FrameCommandBuffer
-  {
-    VkCommandBuffer commandBuffer;
-    VkFence fence;
-  };
-  std::vector<FrameCommandBuffer> m_commandBuffers;
-
-  Camera m_camera;
-  VkSampler m_texSampler;
-
-  glm::mat4 m_projection;
-
-  struct TessellationShaderParameters
-  {
-    glm::mat4 world;
-    glm::mat4 view;
-    glm::mat4 proj;
-    glm::vec4 lightPos;
-    glm::vec4 cameraPos;
-  };
-  ModelData m_quad;
-  ImageObject m_heightMap;
-  ImageObject m_normalMap;
-
-  std::vector<BufferObject> m_tessUniform;
-  std::vector<VkDescriptorSet> m_dsTessSample;
-  VkPipeline m_tessGroundPipeline;
-  VkPipeline m_tessGroundWired;
-
-  bool m_isWireframe;
+#pragma once
+#include "VulkanAppBase.h"
+#include <glm/glm.hpp>
+#include <array>
+#include "Camera.h"
+
+class TessellateGroundApp : public VulkanAppBase
+{
+public:
+  TessellateGroundApp();
+
+  virtual void Prepare();
+  virtual void Cleanup();
+  virtual void Render();
+
+  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
+  virtual bool OnMouseButtonDown(int button);
+  virtual bool OnMouseButtonUp(int button);
+  virtual bool OnMouseMove(int dx, int dy);
+
+  // ベンチマーク用の設定の切り替えとカメラ経路.
+  virtual std::vector<BenchmarkVariant> GetBenchmarkVariants();
+  virtual void SetBenchmarkPose(float t);
+
+  // 使用するデバイスの機能.
+  virtual CapabilityProfile GetCapabilityProfile();
+  // 記録/再生するフレームの入力.
+  virtual void SerializeFrameInputs(FrameArchive& archive);
+
+  struct ShaderParameters
+  {
+    glm::mat4 world;
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec4 lightPos;
+    glm::vec4 cameraPos;
+  };
+
+private:
+  // 本アプリで使用するレイアウト(ディスクリプタレイアウト/パイプラインレイアウト)を作成.
+  void CreateSampleLayouts();
+
+  void PrepareFramebuffers();
+  
+  void PrepareSceneResource();
+
+  struct Vertex
+  {
+    glm::vec3 Position;
+    glm::vec2 UV;
+  };
+
+  ImageObject Load2DTextureFromFile(const char* fileName);
+  ImageObject LoadCubeTextureFromFile(const char* faceFiles[6]);
+
+  void PreparePrimitiveResource();
+  // バインドレス描画用のパイプラインとリソースの番号.
+  void PrepareBindlessResources(VkGraphicsPipelineCreateInfo pipelineCI, VkPipelineRasterizationStateCreateInfo rasterizerState);
+
+  void RenderHUD(VkCommandBuffer command);
+private:
+  ImageObject m_depthBuffer;
+  std::vector<VkFramebuffer> m_framebuffers;
+  // 描画ループで引くものは登録時の Handle を保持する.
+  RenderPassHandle m_renderPass;
+  PipelineLayoutHandle m_pipelineLayout;
+  DescriptorUpdateTemplateHandle m_templateU1T2;
+
+  Camera m_camera;
+  VkSampler m_texSampler;
+
+  glm::mat4 m_projection;
+
+  struct TessellationShaderParameters
+  {
+    glm::mat4 world;
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec4 lightPos;
+    glm::vec4 cameraPos;
+  };
+  ModelData m_quad;
+  ImageObject m_heightMap;
+  ImageObject m_normalMap;
+
+  std::vector<BufferObject> m_tessUniform;
+  std::vector<VkDescriptorSet> m_dsTessSample;
+  VkPipeline m_tessGroundPipeline;
+  VkPipeline m_tessGroundWired;
+
+  // バインドレス描画. デバイスが対応していない場合は m_bindless が null.
+  BindlessDescriptorTable* m_bindless;
+  bool m_useBindless;
+  struct BindlessGround
+  {
+    std::vector<uint32_t> tessUniform;  // フレームごと.
+    uint32_t heightMap;
+    uint32_t normalMap;
+    VkPipeline pipeline;
+    VkPipeline wired;
+  } m_bindlessGround;
+
+  bool m_isWireframe;
 };
\ No newline at end of file
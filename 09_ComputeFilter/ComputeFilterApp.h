@@ -1,74 +1,89 @@
-#pragma once
-#include "VulkanAppBase.h"
-#include <glm/glm.hpp>
-#include <array>
-#include "Camera.h"
-
-class ComputeFilterApp : public VulkanAppBase
-{
-public:
-  ComputeFilterApp();
-
-  virtual void Prepare();
-  virtual void Cleanup();
-  virtual void Render();
-
-  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
-
-  struct ShaderParameters
-  {
-    glm::mat4 proj;
-  };
-
-private:
-  void PrepareFramebuffers();
-  
-  void PrepareSceneResource();
-  
-  void PrepareComputeResource();
-  void CreatePrimitiveResource();
-
-  struct Vertex
-  {
-    glm::vec3 Position;
-    glm::vec2 UV;
-  };
-
-  ImageObject Load2DTextureFromFile(const char* fileName, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-
-  void RenderHUD(VkCommandBuffer command);
-private:
-  // {AvŎgp郌CAEg(fBXNv^CAEg/pCvCCAEg)쐬.
-  void CreateSampleLayouts();
-
-  ImageObject m_depthBuffer;
-  std::vector<VkFramebuffer> m_framebuffers;
-
-  struct FrameCommandBuffer
-  {
-    VkCommandBuffer commandBuffer;
-    VkFence fence;
-  };
-  std::vector<FrameCommandBuffer> m_commandBuffers;
-
-  std::vector<VkDescriptorSet> m_dsDrawTextures[2];
-  
-  VkDescriptorSet m_dsWriteToTexture;
-
-  std::vector<BufferObject> m_shaderUniforms;
-  VkPipeline   m_pipeline;
-  VkPipeline   m_compSepiaPipeline;
-  VkPipeline   m_compSobelPipeline;
-
-  VkSampler m_texSampler;
-  glm::mat4 m_projection;
-  ModelData m_quad, m_quad2;
-  int m_selectedFilter;
-
-  ImageObject m_destBuffer;
-  ImageObject m_sourceBuffer;
-  
-  BufferObject CreateStorageBuffer(size_t bufferSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
-  VkImageMemoryBarrier CreateImageMemoryBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
+#pragma once
+#include "VulkanAppBase.h"
+#include <glm/glm.hpp>
+#include <array>
+#include "Camera.h"
+
+class ComputeFilterApp : public VulkanAppBase
+{
+public:
+  ComputeFilterApp();
+
+  virtual void Prepare();
+  virtual void Cleanup();
+  virtual void Render();
+
+  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
+
+  // ベンチマーク用のフィルタの切り替え.
+  virtual std::vector<BenchmarkVariant> GetBenchmarkVariants();
+  virtual std::vector<uint32_t> GetUniformWriteSizes() { return { uint32_t(sizeof(ShaderParameters)) }; }
+  // 記録/再生するフレームの入力.
+  virtual void SerializeFrameInputs(FrameArchive& archive);
+
+  struct ShaderParameters
+  {
+    glm::mat4 proj;
+  };
+
+private:
+  void PrepareFramebuffers();
+  
+  void PrepareSceneResource();
+  
+  void PrepareComputeResource();
+  void CreatePrimitiveResource();
+  // フィルタと描画の間の受け渡し(レイアウトとキューファミリーの所有権)をグラフに任せる.
+  void PrepareRenderGraph();
+
+  void RenderFilterPass(VkCommandBuffer command);
+  void RenderDrawPass(VkCommandBuffer command);
+
+  struct Vertex
+  {
+    glm::vec3 Position;
+    glm::vec2 UV;
+  };
+
+  ImageObject Load2DTextureFromFile(const char* fileName, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+
+  void RenderHUD(VkCommandBuffer command);
+private:
+  // 本アプリで使用するレイアウト(ディスクリプタレイアウト/パイプラインレイアウト)を作成.
+  void CreateSampleLayouts();
+
+  ImageObject m_depthBuffer;
+  std::vector<VkFramebuffer> m_framebuffers;
+  // 描画ループで引くものは登録時の Handle を保持する.
+  RenderPassHandle m_renderPass;
+  PipelineLayoutHandle m_drawLayout;
+  PipelineLayoutHandle m_filterLayout;
+
+  // フィルタ処理はコンピュートキューで実行する(専用キューが無ければグラフィックスキュー).
+  // 完了はフレームのフェンスで確認できるため、フェンスは持たない.
+  std::vector<VkCommandBuffer> m_computeCommands;
+  VkSemaphore m_computeCompletedSem;  // フィルタ -> 描画.
+  VkSemaphore m_graphicsCompletedSem; // 描画 -> 次のフィルタ.
+  bool m_isGraphicsSubmitted;
+  RenderGraph* m_graph;
+  uint32_t m_imageIndex;
+
+  std::vector<VkDescriptorSet> m_dsDrawTextures[2];
+  VkDescriptorSet m_dsWriteToTexture;
+
+  std::vector<BufferObject> m_shaderUniforms;
+  VkPipeline   m_pipeline;
+  VkPipeline   m_compSepiaPipeline;
+  VkPipeline   m_compSobelPipeline;
+
+  VkSampler m_texSampler;
+  glm::mat4 m_projection;
+  ModelData m_quad, m_quad2;
+  int m_selectedFilter;
+
+  ImageObject m_destBuffer;
+  ImageObject m_sourceBuffer;
+  
+  BufferObject CreateStorageBuffer(size_t bufferSize, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+// oChX`p̐錾. BindlessDescriptorTable ƑΉ.
+// gpVF[_[ł #extension GL_GOOGLE_include_directive : require ̌ɃCN[h.
+#extension GL_EXT_nonuniform_qualifier : require
+
+// binding 0 ̓eNX`̔z.  binding ނ̈قȂTv[ƂĐ錾.
+layout(set=0, binding=0)
+uniform sampler2D bindlessTextures2D[];
+layout(set=0, binding=0)
+uniform samplerCube bindlessTexturesCube[];
+
+// binding 1 ̓Xg[Wobt@̔z. jtH[Ɠe vec4 Pʂœǂ.
+layout(set=0, binding=1, std430)
+readonly buffer BindlessBuffer
+{
+  vec4 data[];
+} bindlessBuffers[];
+
+// `悲Ƃɓnԍ. BindlessDescriptorTable::DrawIndices Ɠ.
+layout(push_constant)
+uniform BindlessIndices
+{
+  uint buffers[4];
+  uint offsets[4];   // obt@̈ʒu(vec4 P).
+  uint textures[4];
+} draw;
+
+vec4 LoadVector(uint slot, uint index)
+{
+  return bindlessBuffers[draw.buffers[slot]].data[draw.offsets[slot] + index];
+}
+
+mat4 LoadMatrix(uint slot, uint index)
+{
+  return mat4(
+    LoadVector(slot, index + 0),
+    LoadVector(slot, index + 1),
+    LoadVector(slot, index + 2),
+    LoadVector(slot, index + 3));
+}
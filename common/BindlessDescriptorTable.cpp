@@ -0,0 +1,141 @@
+#include "BindlessDescriptorTable.h"
+#include "VulkanBookUtil.h"
+
+enum BindlessBinding
+{
+  BindlessBinding_Textures = 0,
+  BindlessBinding_Buffers = 1,
+};
+
+BindlessDescriptorTable::BindlessDescriptorTable(VkDevice device, uint32_t maxTextures, uint32_t maxBuffers)
+  : m_device(device), m_maxTextures(maxTextures), m_maxBuffers(maxBuffers), m_stats()
+{
+  m_textureSlots = Slots{ 0, maxTextures };
+  m_bufferSlots = Slots{ 0, maxBuffers };
+
+  VkDescriptorSetLayoutBinding bindings[] = {
+    { BindlessBinding_Textures, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxTextures, VK_SHADER_STAGE_ALL },
+    { BindlessBinding_Buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers, VK_SHADER_STAGE_ALL },
+  };
+  // 使っていない要素は未登録のままでよく、描画で参照していない要素は実行中でも書き換えてよい.
+  VkDescriptorBindingFlagsEXT bindingFlag =
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+    VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+  VkDescriptorBindingFlagsEXT bindingFlags[] = { bindingFlag, bindingFlag };
+  VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT, nullptr,
+    _countof(bindingFlags), bindingFlags
+  };
+  VkDescriptorSetLayoutCreateInfo dsLayoutCI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    &bindingFlagsCI,
+    VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT,
+    _countof(bindings), bindings,
+  };
+  auto result = vkCreateDescriptorSetLayout(m_device, &dsLayoutCI, nullptr, &m_setLayout);
+  ThrowIfFailed(result, "vkCreateDescriptorSetLayout Failed.");
+
+  VkPushConstantRange pushConstantRange{
+    VK_SHADER_STAGE_ALL, 0, uint32_t(sizeof(DrawIndices))
+  };
+  VkPipelineLayoutCreateInfo layoutCI{
+    VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0,
+    1, &m_setLayout,
+    1, &pushConstantRange
+  };
+  result = vkCreatePipelineLayout(m_device, &layoutCI, nullptr, &m_pipelineLayout);
+  ThrowIfFailed(result, "vkCreatePipelineLayout Failed.");
+
+  VkDescriptorPoolSize poolSizes[] = {
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxTextures },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers },
+  };
+  VkDescriptorPoolCreateInfo descPoolCI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    nullptr, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT,
+    1, // maxSets
+    _countof(poolSizes), poolSizes,
+  };
+  result = vkCreateDescriptorPool(m_device, &descPoolCI, nullptr, &m_descriptorPool);
+  ThrowIfFailed(result, "vkCreateDescriptorPool Failed.");
+
+  VkDescriptorSetAllocateInfo dsAI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr,
+    m_descriptorPool,
+    1, &m_setLayout
+  };
+  result = vkAllocateDescriptorSets(m_device, &dsAI, &m_descriptorSet);
+  ThrowIfFailed(result, "vkAllocateDescriptorSets Failed.");
+}
+
+BindlessDescriptorTable::~BindlessDescriptorTable()
+{
+  vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+}
+
+uint32_t BindlessDescriptorTable::RegisterTexture(VkSampler sampler, VkImageView view, VkImageLayout layout)
+{
+  auto index = AcquireSlot(m_textureSlots);
+  VkDescriptorImageInfo imageInfo{ sampler, view, layout };
+  auto write = book_util::CreateWriteDescriptorSet(m_descriptorSet, BindlessBinding_Textures, &imageInfo);
+  write.dstArrayElement = index;
+  vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  m_stats.textures++;
+  m_stats.descriptorWrites++;
+  return index;
+}
+
+uint32_t BindlessDescriptorTable::RegisterBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+  auto index = AcquireSlot(m_bufferSlots);
+  VkDescriptorBufferInfo bufferInfo{ buffer, offset, range };
+  auto write = book_util::CreateWriteDescriptorSet(m_descriptorSet, BindlessBinding_Buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bufferInfo);
+  write.dstArrayElement = index;
+  vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  m_stats.buffers++;
+  m_stats.descriptorWrites++;
+  return index;
+}
+
+void BindlessDescriptorTable::ReleaseTexture(uint32_t index)
+{
+  // PARTIALLY_BOUND のため、要素は書き換えずに参照されないままにしておく.
+  m_textureSlots.freeList.push_back(index);
+  m_stats.textures--;
+}
+
+void BindlessDescriptorTable::ReleaseBuffer(uint32_t index)
+{
+  m_bufferSlots.freeList.push_back(index);
+  m_stats.buffers--;
+}
+
+void BindlessDescriptorTable::Bind(VkCommandBuffer command, VkPipelineBindPoint bindPoint)
+{
+  vkCmdBindDescriptorSets(command, bindPoint, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
+  m_stats.setBinds++;
+}
+
+void BindlessDescriptorTable::PushIndices(VkCommandBuffer command, const DrawIndices& indices)
+{
+  vkCmdPushConstants(command, m_pipelineLayout, VK_SHADER_STAGE_ALL, 0, uint32_t(sizeof(DrawIndices)), &indices);
+  m_stats.indexPushes++;
+}
+
+uint32_t BindlessDescriptorTable::AcquireSlot(Slots& slots)
+{
+  if (!slots.freeList.empty())
+  {
+    auto index = slots.freeList.back();
+    slots.freeList.pop_back();
+    return index;
+  }
+  if (slots.next == slots.capacity)
+  {
+    throw book_util::VulkanException("BindlessDescriptorTable is full.");
+  }
+  return slots.next++;
+}
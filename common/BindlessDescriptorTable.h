@@ -0,0 +1,71 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+
+// ディスクリプタインデックス(VK_EXT_descriptor_indexing)による全体共通のディスクリプタセット.
+// binding 0: テクスチャ(+サンプラー)の配列, binding 1: ストレージバッファの配列.
+// 描画ではセットをフレームに 1 度だけバインドし、使うリソースの番号をプッシュ定数で渡す.
+// 配列は未登録の要素を許し(PARTIALLY_BOUND)、バインド中のセットへの登録も許す(UPDATE_AFTER_BIND).
+// シェーダー側の宣言は common/Bindless.glsl.
+class BindlessDescriptorTable
+{
+public:
+  // プッシュ定数で渡す番号. Bindless.glsl の BindlessIndices と同じ並び.
+  struct DrawIndices
+  {
+    uint32_t buffers[4];
+    uint32_t offsets[4];    // バッファ内の位置(vec4 単位).
+    uint32_t textures[4];
+  };
+  struct Statistics
+  {
+    uint32_t textures;
+    uint32_t buffers;
+    uint32_t descriptorWrites;
+    uint32_t setBinds;
+    uint32_t indexPushes;
+  };
+  static const uint32_t InvalidIndex = ~0u;
+
+  BindlessDescriptorTable(VkDevice device, uint32_t maxTextures, uint32_t maxBuffers);
+  ~BindlessDescriptorTable();
+
+  // 返した番号は Release するまで変わらない.
+  uint32_t RegisterTexture(VkSampler sampler, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  uint32_t RegisterBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+  // 番号は再利用する. 参照する描画の完了を待ってから呼ぶこと.
+  void ReleaseTexture(uint32_t index);
+  void ReleaseBuffer(uint32_t index);
+
+  VkDescriptorSetLayout GetSetLayout() const { return m_setLayout; }
+  // セット 0 が全体共通のセットで、プッシュ定数に DrawIndices を持つ.
+  VkPipelineLayout GetPipelineLayout() const { return m_pipelineLayout; }
+  VkDescriptorSet GetDescriptorSet() const { return m_descriptorSet; }
+  uint32_t GetMaxTextures() const { return m_maxTextures; }
+  uint32_t GetMaxBuffers() const { return m_maxBuffers; }
+
+  void Bind(VkCommandBuffer command, VkPipelineBindPoint bindPoint);
+  void PushIndices(VkCommandBuffer command, const DrawIndices& indices);
+
+  const Statistics& GetStatistics() const { return m_stats; }
+
+private:
+  struct Slots
+  {
+    uint32_t next;
+    uint32_t capacity;
+    std::vector<uint32_t> freeList;
+  };
+  static uint32_t AcquireSlot(Slots& slots);
+
+  VkDevice m_device;
+  VkDescriptorSetLayout m_setLayout;
+  VkPipelineLayout m_pipelineLayout;
+  VkDescriptorPool m_descriptorPool;
+  VkDescriptorSet m_descriptorSet;
+  uint32_t m_maxTextures;
+  uint32_t m_maxBuffers;
+  Slots m_textureSlots;
+  Slots m_bufferSlots;
+  Statistics m_stats;
+};
@@ -0,0 +1,161 @@
+#include "CpuProfiler.h"
+#include "TraceRecorder.h"
+#include "imgui.h"
+
+#include <fstream>
+#include <algorithm>
+
+// HUD のパーセンタイルを更新する間隔(フレーム数).
+static const uint32_t DisplayRefreshInterval = 30;
+
+CpuProfiler::CpuProfiler()
+  : m_isFrameActive(false), m_trace(nullptr), m_current(), m_samples(), m_writeIndex(0), m_sampleCount(0), m_displayed(), m_framesSinceRefresh(0)
+{
+  m_scratch.reserve(SampleCapacity);
+}
+
+void CpuProfiler::NewFrame()
+{
+  auto now = Clock::now();
+  if (m_isFrameActive)
+  {
+    m_current[Phase_Frame] = std::chrono::duration<double, std::milli>(now - m_frameStart).count();
+    if (m_trace)
+    {
+      m_trace->AddCpuEvent(GetPhaseName(Phase_Frame), m_frameStart, now);
+    }
+    for (int i = 0; i < Phase_Count; ++i)
+    {
+      m_samples[i][m_writeIndex] = float(m_current[i]);
+      m_current[i] = 0.0;
+    }
+    m_writeIndex = (m_writeIndex + 1) % SampleCapacity;
+    m_sampleCount = (std::min)(m_sampleCount + 1, uint32_t(SampleCapacity));
+  }
+  m_frameStart = now;
+  m_lapStart = now;
+  m_isFrameActive = true;
+}
+
+void CpuProfiler::Lap(Phase phase)
+{
+  auto now = Clock::now();
+  m_current[phase] += std::chrono::duration<double, std::milli>(now - m_lapStart).count();
+  if (m_trace)
+  {
+    m_trace->AddCpuEvent(GetPhaseName(phase), m_lapStart, now);
+  }
+  m_lapStart = now;
+}
+
+CpuProfiler::Percentiles CpuProfiler::ComputePercentiles(Phase phase) const
+{
+  Percentiles result{};
+  if (m_sampleCount == 0)
+  {
+    return result;
+  }
+  m_scratch.assign(m_samples[phase], m_samples[phase] + m_sampleCount);
+  auto at = [&](double ratio) {
+    auto index = size_t(ratio * (m_scratch.size() - 1) + 0.5);
+    std::nth_element(m_scratch.begin(), m_scratch.begin() + index, m_scratch.end());
+    return double(m_scratch[index]);
+  };
+  result.p50 = at(0.50);
+  result.p95 = at(0.95);
+  result.p99 = at(0.99);
+  return result;
+}
+
+CpuProfiler::Phase CpuProfiler::GetDominantPhase() const
+{
+  Phase dominant = Phase_FenceWait;
+  double maxMs = -1.0;
+  for (int i = 0; i < Phase_Frame; ++i)
+  {
+    auto p = ComputePercentiles(Phase(i));
+    if (p.p50 > maxMs)
+    {
+      maxMs = p.p50;
+      dominant = Phase(i);
+    }
+  }
+  return dominant;
+}
+
+const char* CpuProfiler::GetPhaseName(Phase phase)
+{
+  static const char* names[] = {
+    "FenceWait", "Acquire", "Update", "Record", "Submit", "Present", "Frame",
+  };
+  return names[phase];
+}
+
+void CpuProfiler::DrawImGui()
+{
+  if (++m_framesSinceRefresh >= DisplayRefreshInterval)
+  {
+    m_framesSinceRefresh = 0;
+    for (int i = 0; i < Phase_Count; ++i)
+    {
+      m_displayed[i] = ComputePercentiles(Phase(i));
+    }
+  }
+
+  ImGui::Begin("CPU Phases");
+  ImGui::Columns(4, "cpu_phases");
+  ImGui::Text("Phase"); ImGui::NextColumn();
+  ImGui::Text("p50(ms)"); ImGui::NextColumn();
+  ImGui::Text("p95(ms)"); ImGui::NextColumn();
+  ImGui::Text("p99(ms)"); ImGui::NextColumn();
+  ImGui::Separator();
+  for (int i = 0; i < Phase_Count; ++i)
+  {
+    ImGui::Text("%s", GetPhaseName(Phase(i))); ImGui::NextColumn();
+    ImGui::Text("%.3f", m_displayed[i].p50); ImGui::NextColumn();
+    ImGui::Text("%.3f", m_displayed[i].p95); ImGui::NextColumn();
+    ImGui::Text("%.3f", m_displayed[i].p99); ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+  ImGui::Text("Samples: %u", m_sampleCount);
+  ImGui::End();
+}
+
+bool CpuProfiler::ExportJson(const char* fileName) const
+{
+  std::ofstream outfile(fileName);
+  if (!outfile)
+  {
+    return false;
+  }
+  outfile << "{" << std::endl;
+  outfile << "  \"samples\": " << m_sampleCount << "," << std::endl;
+  outfile << "  \"dominant\": \"" << GetPhaseName(GetDominantPhase()) << "\"," << std::endl;
+  outfile << "  \"phases\": {" << std::endl;
+  for (int i = 0; i < Phase_Count; ++i)
+  {
+    auto p = ComputePercentiles(Phase(i));
+    outfile << "    \"" << GetPhaseName(Phase(i)) << "\": { "
+      << "\"p50\": " << p.p50 << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99 << " }"
+      << (i + 1 < Phase_Count ? "," : "") << std::endl;
+  }
+  outfile << "  }" << std::endl;
+  outfile << "}" << std::endl;
+  return bool(outfile);
+}
+
+bool CpuProfiler::ExportCsv(const char* fileName) const
+{
+  std::ofstream outfile(fileName);
+  if (!outfile)
+  {
+    return false;
+  }
+  outfile << "phase,p50_ms,p95_ms,p99_ms" << std::endl;
+  for (int i = 0; i < Phase_Count; ++i)
+  {
+    auto p = ComputePercentiles(Phase(i));
+    outfile << GetPhaseName(Phase(i)) << "," << p.p50 << "," << p.p95 << "," << p.p99 << std::endl;
+  }
+  return bool(outfile);
+}
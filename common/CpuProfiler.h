@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+class TraceRecorder;
+
+// フレーム内の CPU 処理をフェーズごとに計測する.
+// 各フェーズは直前の Lap からの経過時間とし、直近 SampleCapacity フレーム分を固定長のリングに保持する.
+// 計測中はメモリ確保を行わない.
+class CpuProfiler
+{
+public:
+  enum Phase
+  {
+    Phase_FenceWait,  // フレームのフェンス待ち.
+    Phase_Acquire,    // スワップチェインイメージの取得.
+    Phase_Update,     // ユニフォーム等の更新.
+    Phase_Record,     // コマンドの記録.
+    Phase_Submit,     // vkQueueSubmit.
+    Phase_Present,    // vkQueuePresentKHR.
+    Phase_Frame,      // フレーム全体(NewFrame の間隔).
+    Phase_Count,
+  };
+  static const uint32_t SampleCapacity = 1024;
+
+  struct Percentiles
+  {
+    double p50;
+    double p95;
+    double p99;
+  };
+
+  CpuProfiler();
+
+  // 前のフレームの計測値を確定し、次のフレームの計測を開始する.
+  void NewFrame();
+  void Lap(Phase phase);
+  // 記録中の TraceRecorder へ各フェーズの区間を渡す. null で解除.
+  void SetTraceRecorder(TraceRecorder* trace) { m_trace = trace; }
+
+  uint32_t GetSampleCount() const { return m_sampleCount; }
+  Percentiles ComputePercentiles(Phase phase) const;
+  // p50 が最も大きいフェーズ(フレーム全体を除く).
+  Phase GetDominantPhase() const;
+  static const char* GetPhaseName(Phase phase);
+
+  void DrawImGui();
+  bool ExportJson(const char* fileName) const;
+  bool ExportCsv(const char* fileName) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point m_frameStart;
+  Clock::time_point m_lapStart;
+  bool m_isFrameActive;
+  TraceRecorder* m_trace;
+
+  double m_current[Phase_Count];
+  float m_samples[Phase_Count][SampleCapacity];
+  uint32_t m_writeIndex;
+  uint32_t m_sampleCount;
+
+  // パーセンタイル計算用の作業領域(事前に確保しておく).
+  mutable std::vector<float> m_scratch;
+  // HUD 表示用. 毎フレームは計算しない.
+  Percentiles m_displayed[Phase_Count];
+  uint32_t m_framesSinceRefresh;
+};
@@ -0,0 +1,274 @@
+#include "DescriptorAllocator.h"
+#include "VulkanBookUtil.h"
+
+#include <algorithm>
+
+// 最初のプールのセット数. 追加するたびに倍にし、MaxSetsPerPool で止める.
+static const uint32_t InitialSetsPerPool = 32;
+static const uint32_t MaxSetsPerPool = 1024;
+
+// セットあたりの種類ごとのディスクリプタ数の見積もり.
+static const struct
+{
+  VkDescriptorType type;
+  uint32_t countPerSet;
+} PoolRatios[] = {
+  { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+  { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+  { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+  { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+  { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+};
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device)
+  : m_device(device), m_persistent(), m_frameIndex(0), m_stats()
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+  auto destroy = [&](Arena& arena) {
+    for (auto pool : arena.pools)
+    {
+      vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    arena.pools.clear();
+  };
+  destroy(m_persistent);
+  for (auto& arena : m_frames)
+  {
+    destroy(arena);
+  }
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+  auto it = m_freeSets.find(layout);
+  if (it != m_freeSets.end() && !it->second.empty())
+  {
+    auto descriptorSet = it->second.back();
+    it->second.pop_back();
+    m_stats.reusedSets++;
+    return descriptorSet;
+  }
+  m_stats.persistentSets++;
+  return AllocateFrom(m_persistent, layout);
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateFrame(VkDescriptorSetLayout layout)
+{
+  if (m_frames.size() <= m_frameIndex)
+  {
+    m_frames.resize(m_frameIndex + 1);
+  }
+  auto& arena = m_frames[m_frameIndex];
+  m_stats.frameSets++;
+  auto descriptorSet = AllocateFrom(arena, layout);
+  m_stats.peakFrameSets = (std::max)(m_stats.peakFrameSets, arena.setCount);
+  return descriptorSet;
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+  m_frameIndex = frameIndex;
+  if (m_frames.size() <= frameIndex)
+  {
+    m_frames.resize(frameIndex + 1);
+    return;
+  }
+  auto& arena = m_frames[frameIndex];
+  if (arena.setCount == 0)
+  {
+    return;
+  }
+  // 個別に解放せず、プールごとまとめて戻す.
+  for (auto pool : arena.pools)
+  {
+    vkResetDescriptorPool(m_device, pool, 0);
+    m_stats.poolResets++;
+  }
+  arena.current = 0;
+  arena.setCount = 0;
+}
+
+VkDescriptorSet DescriptorAllocator::GetOrCreate(VkDescriptorSetLayout layout, std::vector<VkWriteDescriptorSet> writes)
+{
+  auto key = MakeKey(layout, writes);
+  auto it = m_cache.find(key);
+  if (it != m_cache.end())
+  {
+    m_stats.cacheHits++;
+    return it->second.descriptorSet;
+  }
+  m_stats.cacheMisses++;
+
+  auto descriptorSet = Insert(std::move(key), layout, writes);
+  for (auto& w : writes)
+  {
+    w.dstSet = descriptorSet;
+  }
+  vkUpdateDescriptorSets(m_device, uint32_t(writes.size()), writes.data(), 0, nullptr);
+  return descriptorSet;
+}
+
+VkDescriptorSet DescriptorAllocator::GetOrCreate(VkDescriptorSetLayout layout, VkDescriptorUpdateTemplate updateTemplate,
+  const std::vector<VkDescriptorUpdateTemplateEntry>& entries, const void* data)
+{
+  auto writes = book_util::CreateWriteDescriptorSets(VK_NULL_HANDLE, entries, data);
+  auto key = MakeKey(layout, writes);
+  auto it = m_cache.find(key);
+  if (it != m_cache.end())
+  {
+    m_stats.cacheHits++;
+    return it->second.descriptorSet;
+  }
+  m_stats.cacheMisses++;
+
+  auto descriptorSet = Insert(std::move(key), layout, writes);
+  vkUpdateDescriptorSetWithTemplate(m_device, descriptorSet, updateTemplate, data);
+  return descriptorSet;
+}
+
+VkDescriptorSet DescriptorAllocator::Insert(std::string key, VkDescriptorSetLayout layout, const std::vector<VkWriteDescriptorSet>& writes)
+{
+  CacheEntry entry{ Allocate(layout), layout };
+  for (const auto& w : writes)
+  {
+    for (uint32_t i = 0; i < w.descriptorCount; ++i)
+    {
+      if (w.pImageInfo)
+      {
+        entry.handles.push_back(HandleValue(w.pImageInfo[i].sampler));
+        entry.handles.push_back(HandleValue(w.pImageInfo[i].imageView));
+      }
+      if (w.pBufferInfo)
+      {
+        entry.handles.push_back(HandleValue(w.pBufferInfo[i].buffer));
+      }
+      if (w.pTexelBufferView)
+      {
+        entry.handles.push_back(HandleValue(w.pTexelBufferView[i]));
+      }
+    }
+  }
+  auto descriptorSet = entry.descriptorSet;
+  m_cache.emplace(std::move(key), std::move(entry));
+  return descriptorSet;
+}
+
+void DescriptorAllocator::EvictHandle(uint64_t handle)
+{
+  if (handle == 0)
+  {
+    return;
+  }
+  // 破棄は準備処理とサイズ変更時のみで、キャッシュも小さいため全体を調べる.
+  for (auto it = m_cache.begin(); it != m_cache.end();)
+  {
+    const auto& handles = it->second.handles;
+    if (std::find(handles.begin(), handles.end(), handle) == handles.end())
+    {
+      ++it;
+      continue;
+    }
+    m_freeSets[it->second.layout].push_back(it->second.descriptorSet);
+    m_stats.evictedSets++;
+    it = m_cache.erase(it);
+  }
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateFrom(Arena& arena, VkDescriptorSetLayout layout)
+{
+  auto isNewPool = false;
+  if (arena.pools.empty())
+  {
+    arena.pools.push_back(CreatePool(InitialSetsPerPool));
+    arena.current = 0;
+    isNewPool = true;
+  }
+  for (;;)
+  {
+    VkDescriptorSetAllocateInfo dsAI{
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr,
+      arena.pools[arena.current],
+      1, &layout
+    };
+    VkDescriptorSet descriptorSet;
+    auto result = vkAllocateDescriptorSets(m_device, &dsAI, &descriptorSet);
+    if (result == VK_SUCCESS)
+    {
+      arena.setCount++;
+      return descriptorSet;
+    }
+    // 新しく作ったプールでも確保できない場合は見積もりを超えるレイアウト.
+    if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || isNewPool)
+    {
+      ThrowIfFailed(result, "vkAllocateDescriptorSets Failed.");
+    }
+    // 残りのプールを順に使い、無ければ追加する.
+    arena.current++;
+    if (arena.current == arena.pools.size())
+    {
+      auto maxSets = (std::min)(InitialSetsPerPool << (std::min)(uint32_t(arena.pools.size()), 5u), MaxSetsPerPool);
+      arena.pools.push_back(CreatePool(maxSets));
+      isNewPool = true;
+    }
+  }
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t maxSets)
+{
+  std::vector<VkDescriptorPoolSize> poolSizes;
+  for (const auto& ratio : PoolRatios)
+  {
+    poolSizes.push_back({ ratio.type, ratio.countPerSet * maxSets });
+  }
+  VkDescriptorPoolCreateInfo descPoolCI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    nullptr, 0,
+    maxSets,
+    uint32_t(poolSizes.size()), poolSizes.data(),
+  };
+  VkDescriptorPool pool;
+  auto result = vkCreateDescriptorPool(m_device, &descPoolCI, nullptr, &pool);
+  ThrowIfFailed(result, "vkCreateDescriptorPool Failed.");
+  m_stats.poolCount++;
+  return pool;
+}
+
+std::string DescriptorAllocator::MakeKey(VkDescriptorSetLayout layout, const std::vector<VkWriteDescriptorSet>& writes)
+{
+  // 構造体のパディングを含めないよう、メンバごとに詰める.
+  std::string key;
+  auto append = [&](const auto& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  append(layout);
+  for (const auto& w : writes)
+  {
+    append(w.dstBinding);
+    append(w.dstArrayElement);
+    append(w.descriptorType);
+    append(w.descriptorCount);
+    for (uint32_t i = 0; i < w.descriptorCount; ++i)
+    {
+      if (w.pImageInfo)
+      {
+        append(w.pImageInfo[i].sampler);
+        append(w.pImageInfo[i].imageView);
+        append(w.pImageInfo[i].imageLayout);
+      }
+      if (w.pBufferInfo)
+      {
+        append(w.pBufferInfo[i].buffer);
+        append(w.pBufferInfo[i].offset);
+        append(w.pBufferInfo[i].range);
+      }
+      if (w.pTexelBufferView)
+      {
+        append(w.pTexelBufferView[i]);
+      }
+    }
+  }
+  return key;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+
+// ディスクリプタセットの確保.
+// 個別の解放は行わず、プールが足りなくなれば大きめのプールを追加する.
+// - 永続: 終了時にまとめて破棄する. キャッシュから外したセットは再利用リストに戻し、同じレイアウトの確保で使い回す.
+// - フレーム: 処理中のフレームごとのプールから確保し、そのスロットの次の BeginFrame でまとめてリセットする.
+// 永続のセットはレイアウトと書き込む内容をキーにキャッシュし、同じものは 1 度だけ作る.
+class DescriptorAllocator
+{
+public:
+  struct Statistics
+  {
+    uint32_t poolCount;
+    uint32_t persistentSets;
+    uint32_t frameSets;       // フレーム用に確保した総数.
+    uint32_t peakFrameSets;   // 1 フレームで確保した最大数.
+    uint32_t poolResets;
+    uint32_t cacheHits;
+    uint32_t cacheMisses;
+    uint32_t evictedSets;     // リソースの破棄でキャッシュから外したセット数.
+    uint32_t reusedSets;      // 再利用リストから確保したセット数.
+  };
+
+  explicit DescriptorAllocator(VkDevice device);
+  ~DescriptorAllocator();
+
+  VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+  VkDescriptorSet AllocateFrame(VkDescriptorSetLayout layout);
+  // フレームの開始時(フェンス待ちの後)に呼ぶ. このスロットのプールをリセットする.
+  void BeginFrame(uint32_t frameIndex);
+
+  // writes の dstSet は無視する. 同じレイアウトと内容のセットがあればそれを返す.
+  // キーはハンドルの値なので、参照するリソースを破棄したら Evict でキャッシュから外す.
+  VkDescriptorSet GetOrCreate(VkDescriptorSetLayout layout, std::vector<VkWriteDescriptorSet> writes);
+  // 更新テンプレートで書き込む. 同じ内容なら書き込みの配列で作ったセットと共有する.
+  VkDescriptorSet GetOrCreate(VkDescriptorSetLayout layout, VkDescriptorUpdateTemplate updateTemplate,
+    const std::vector<VkDescriptorUpdateTemplateEntry>& entries, const void* data);
+  // handle (VkBuffer, VkImageView, VkSampler) を参照するセットをキャッシュから外し、再利用リストへ戻す.
+  // GPU がそれらのセットを使い終えた後(リソースを破棄できる時点)で呼ぶこと.
+  template<class T>
+  void Evict(T handle) { EvictHandle(HandleValue(handle)); }
+
+  const Statistics& GetStatistics() const { return m_stats; }
+
+private:
+  struct Arena
+  {
+    std::vector<VkDescriptorPool> pools;
+    uint32_t current;
+    uint32_t setCount;
+  };
+  struct CacheEntry
+  {
+    VkDescriptorSet descriptorSet;
+    VkDescriptorSetLayout layout;
+    std::vector<uint64_t> handles;  // 参照しているリソースのハンドル.
+  };
+  template<class T>
+  static uint64_t HandleValue(T handle)
+  {
+    // 非ディスパッチャブルハンドルは環境によりポインタか uint64_t.
+    uint64_t value = 0;
+    memcpy(&value, &handle, sizeof(handle));
+    return value;
+  }
+  void EvictHandle(uint64_t handle);
+  VkDescriptorSet Insert(std::string key, VkDescriptorSetLayout layout, const std::vector<VkWriteDescriptorSet>& writes);
+  VkDescriptorSet AllocateFrom(Arena& arena, VkDescriptorSetLayout layout);
+  VkDescriptorPool CreatePool(uint32_t maxSets);
+  static std::string MakeKey(VkDescriptorSetLayout layout, const std::vector<VkWriteDescriptorSet>& writes);
+
+  VkDevice m_device;
+  Arena m_persistent;
+  std::vector<Arena> m_frames;
+  uint32_t m_frameIndex;
+  std::unordered_map<std::string, CacheEntry> m_cache;
+  std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> m_freeSets;
+  Statistics m_stats;
+};
@@ -0,0 +1,432 @@
+#include "DeviceMemoryAllocator.h"
+#include "VulkanBookUtil.h"
+#include <algorithm>
+
+namespace
+{
+  const VkDeviceSize DefaultBlockSize = 64 * 1024 * 1024;
+  const VkDeviceSize MinBlockSize = 1 * 1024 * 1024;
+
+  VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+  VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment)
+  {
+    return value / alignment * alignment;
+  }
+}
+
+DeviceMemoryAllocator::DeviceMemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties& memProps, VkDeviceSize nonCoherentAtomSize)
+  : m_device(device), m_memProps(memProps), m_nonCoherentAtomSize(std::max<VkDeviceSize>(nonCoherentAtomSize, 1)),
+  m_dedicatedCount(0), m_dedicatedBytes(0),
+  m_allocationCount(0), m_bytesUsed(0), m_bytesWasted(0), m_categories()
+{
+}
+
+DeviceMemoryAllocator::~DeviceMemoryAllocator()
+{
+  Cleanup();
+}
+
+VkDeviceSize DeviceMemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+  // 小さいヒープ(ホストから見えるデバイスローカル領域など)を食い潰さないよう、ヒープの 1/8 までとする.
+  auto heapIndex = m_memProps.memoryTypes[memoryTypeIndex].heapIndex;
+  auto heapSize = m_memProps.memoryHeaps[heapIndex].size;
+  // nonCoherentAtomSize の倍数となるよう MinBlockSize 単位に丸めておく.
+  auto blockSize = AlignDown(std::min(DefaultBlockSize, heapSize / 8), MinBlockSize);
+  return std::max(blockSize, MinBlockSize);
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::Allocate(const VkMemoryRequirements& reqs, uint32_t memoryTypeIndex, ResourceKind kind, Category category)
+{
+  if (reqs.size >= GetDedicatedThreshold(memoryTypeIndex))
+  {
+    return AllocateDedicatedMemory(reqs, memoryTypeIndex, kind, VK_NULL_HANDLE, VK_NULL_HANDLE, category);
+  }
+
+  Allocation allocation{};
+  allocation.memoryTypeIndex = memoryTypeIndex;
+  allocation.kind = kind;
+
+  // 非コヒーレントなメモリでは Flush/Invalidate の範囲が隣の割り当てに掛からないよう
+  // nonCoherentAtomSize 単位で配置する.
+  auto size = reqs.size;
+  auto alignment = reqs.alignment;
+  if (IsHostVisible(memoryTypeIndex) && !IsHostCoherent(memoryTypeIndex))
+  {
+    size = AlignUp(size, m_nonCoherentAtomSize);
+    alignment = std::max(alignment, m_nonCoherentAtomSize);
+  }
+
+  auto& blocks = m_blocks[memoryTypeIndex][kind];
+  for (uint32_t i = 0; i < uint32_t(blocks.size()); ++i)
+  {
+    if (blocks[i] && AllocateFromBlock(*blocks[i], size, alignment, allocation))
+    {
+      allocation.blockIndex = i;
+      TrackCategory(allocation, category);
+      return allocation;
+    }
+  }
+
+  // 空きが無いので新しいブロックを確保する.
+  auto index = CreateBlock(blocks, memoryTypeIndex, GetBlockSize(memoryTypeIndex));
+  if (!AllocateFromBlock(*blocks[index], size, alignment, allocation))
+  {
+    throw book_util::VulkanException("DeviceMemoryAllocator: allocation does not fit in a new block.");
+  }
+  allocation.blockIndex = index;
+  TrackCategory(allocation, category);
+  return allocation;
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::AllocateDedicated(const VkMemoryRequirements& reqs, uint32_t memoryTypeIndex, VkImage image, VkBuffer buffer, Category category)
+{
+  auto kind = (image != VK_NULL_HANDLE) ? ResourceKind_Optimal : ResourceKind_Linear;
+  return AllocateDedicatedMemory(reqs, memoryTypeIndex, kind, image, buffer, category);
+}
+
+DeviceMemoryAllocator::Allocation DeviceMemoryAllocator::AllocateDedicatedMemory(const VkMemoryRequirements& reqs, uint32_t memoryTypeIndex, ResourceKind kind, VkImage image, VkBuffer buffer, Category category)
+{
+  VkMemoryDedicatedAllocateInfo dedicatedAI{
+    VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+    nullptr,
+    image, buffer
+  };
+  VkMemoryAllocateInfo info{
+    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    (image != VK_NULL_HANDLE || buffer != VK_NULL_HANDLE) ? &dedicatedAI : nullptr,
+    reqs.size,
+    memoryTypeIndex
+  };
+  Allocation allocation{};
+  auto result = vkAllocateMemory(m_device, &info, nullptr, &allocation.memory);
+  ThrowIfFailed(result, "vkAllocateMemory Failed.");
+
+  allocation.offset = 0;
+  allocation.size = reqs.size;
+  allocation.memoryTypeIndex = memoryTypeIndex;
+  allocation.kind = kind;
+  allocation.blockIndex = DedicatedBlock;
+  allocation.rangeOffset = 0;
+  allocation.rangeSize = reqs.size;
+  allocation.mapped = MapWhole(allocation.memory, memoryTypeIndex);
+
+  m_dedicatedMemories.push_back(allocation.memory);
+  m_dedicatedCount++;
+  m_dedicatedBytes += reqs.size;
+  m_allocationCount++;
+  m_bytesUsed += reqs.size;
+  TrackCategory(allocation, category);
+  return allocation;
+}
+
+void DeviceMemoryAllocator::TrackCategory(Allocation& allocation, Category category)
+{
+  allocation.category = category;
+  auto& stats = m_categories[category];
+  stats.allocationCount++;
+  stats.bytesUsed += allocation.size;
+  stats.peakBytes = std::max(stats.peakBytes, stats.bytesUsed);
+}
+
+void DeviceMemoryAllocator::Free(const Allocation& allocation)
+{
+  if (allocation.memory == VK_NULL_HANDLE)
+  {
+    return;
+  }
+  m_allocationCount--;
+  m_bytesUsed -= allocation.size;
+  m_categories[allocation.category].allocationCount--;
+  m_categories[allocation.category].bytesUsed -= allocation.size;
+
+  if (allocation.blockIndex == DedicatedBlock)
+  {
+    vkFreeMemory(m_device, allocation.memory, nullptr);
+    m_dedicatedMemories.erase(std::find(m_dedicatedMemories.begin(), m_dedicatedMemories.end(), allocation.memory));
+    m_dedicatedCount--;
+    m_dedicatedBytes -= allocation.size;
+    return;
+  }
+
+  m_bytesWasted -= allocation.rangeSize - allocation.size;
+
+  auto& blocks = m_blocks[allocation.memoryTypeIndex][allocation.kind];
+  auto& block = *blocks[allocation.blockIndex];
+  FreeRange(block, allocation.rangeOffset, allocation.rangeSize);
+  block.used -= allocation.rangeSize;
+  block.allocationCount--;
+  if (block.allocationCount == 0)
+  {
+    ReleaseEmptyBlocks(blocks, allocation.blockIndex);
+  }
+}
+
+void DeviceMemoryAllocator::Flush(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+  VkMappedMemoryRange range;
+  if (GetMappedRange(allocation, offset, size, range))
+  {
+    auto result = vkFlushMappedMemoryRanges(m_device, 1, &range);
+    ThrowIfFailed(result, "vkFlushMappedMemoryRanges Failed.");
+  }
+}
+
+void DeviceMemoryAllocator::Invalidate(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+  VkMappedMemoryRange range;
+  if (GetMappedRange(allocation, offset, size, range))
+  {
+    auto result = vkInvalidateMappedMemoryRanges(m_device, 1, &range);
+    ThrowIfFailed(result, "vkInvalidateMappedMemoryRanges Failed.");
+  }
+}
+
+bool DeviceMemoryAllocator::IsHostCoherent(uint32_t memoryTypeIndex) const
+{
+  return (m_memProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+uint32_t DeviceMemoryAllocator::FindMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestProps) const
+{
+  for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i)
+  {
+    if ((requestBits & (1u << i)) &&
+      (m_memProps.memoryTypes[i].propertyFlags & requestProps) == requestProps)
+    {
+      return i;
+    }
+  }
+  throw book_util::VulkanException("DeviceMemoryAllocator: no suitable memory type.");
+}
+
+bool DeviceMemoryAllocator::IsHostVisible(uint32_t memoryTypeIndex) const
+{
+  return (m_memProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+void DeviceMemoryAllocator::Cleanup()
+{
+  for (auto& kinds : m_blocks)
+  {
+    for (auto& blocks : kinds)
+    {
+      for (auto& block : blocks)
+      {
+        if (block)
+        {
+          vkFreeMemory(m_device, block->memory, nullptr);
+        }
+      }
+      blocks.clear();
+    }
+  }
+
+  if (!m_dedicatedMemories.empty())
+  {
+    std::stringstream ss;
+    ss << "[Memory] " << m_dedicatedMemories.size() << " dedicated allocations (" << m_dedicatedBytes / 1024 << " KB) were not freed." << std::endl;
+    book_util::WriteLog(ss.str().c_str());
+  }
+  for (auto memory : m_dedicatedMemories)
+  {
+    vkFreeMemory(m_device, memory, nullptr);
+  }
+  m_dedicatedMemories.clear();
+  m_dedicatedCount = 0;
+  m_dedicatedBytes = 0;
+}
+
+DeviceMemoryAllocator::Statistics DeviceMemoryAllocator::GetStatistics() const
+{
+  Statistics stats{};
+  stats.allocationCount = m_allocationCount;
+  stats.deviceMemoryCount = m_dedicatedCount;
+  stats.dedicatedCount = m_dedicatedCount;
+  stats.bytesReserved = m_dedicatedBytes;
+  stats.bytesUsed = m_bytesUsed;
+  stats.bytesWasted = m_bytesWasted;
+
+  for (const auto& kinds : m_blocks)
+  {
+    for (const auto& blocks : kinds)
+    {
+      for (const auto& block : blocks)
+      {
+        if (!block)
+        {
+          continue;
+        }
+        stats.deviceMemoryCount++;
+        stats.bytesReserved += block->size;
+        for (const auto& range : block->freeRanges)
+        {
+          stats.bytesFree += range.second;
+          stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+        }
+      }
+    }
+  }
+  if (stats.bytesFree > 0)
+  {
+    stats.fragmentation = 1.0f - float(double(stats.largestFreeRange) / double(stats.bytesFree));
+  }
+  return stats;
+}
+
+const char* DeviceMemoryAllocator::GetCategoryName(Category category)
+{
+  static const char* names[] = {
+    "Vertex", "Index", "Uniform", "Staging", "Texture", "RenderTarget", "Other",
+  };
+  return names[category];
+}
+
+bool DeviceMemoryAllocator::AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation)
+{
+  // 先頭から探して最初に収まる空き領域を使う(first-fit).
+  for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+  {
+    auto rangeOffset = it->first;
+    auto rangeSize = it->second;
+    auto alignedOffset = AlignUp(rangeOffset, alignment);
+    auto padding = alignedOffset - rangeOffset;
+    if (padding + size > rangeSize)
+    {
+      continue;
+    }
+
+    // 後ろの余りは空き領域として残す. 先頭のパディングは割り当てに含める.
+    auto usedSize = padding + size;
+    block.freeRanges.erase(it);
+    if (usedSize < rangeSize)
+    {
+      block.freeRanges[rangeOffset + usedSize] = rangeSize - usedSize;
+    }
+    block.used += usedSize;
+    block.allocationCount++;
+
+    allocation.memory = block.memory;
+    allocation.offset = alignedOffset;
+    allocation.size = size;
+    allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + alignedOffset : nullptr;
+    allocation.rangeOffset = rangeOffset;
+    allocation.rangeSize = usedSize;
+
+    m_allocationCount++;
+    m_bytesUsed += size;
+    m_bytesWasted += padding;
+    return true;
+  }
+  return false;
+}
+
+void DeviceMemoryAllocator::FreeRange(Block& block, VkDeviceSize offset, VkDeviceSize size)
+{
+  auto it = block.freeRanges.emplace(offset, size).first;
+
+  // 後ろの空き領域と結合.
+  auto next = std::next(it);
+  if (next != block.freeRanges.end() && it->first + it->second == next->first)
+  {
+    it->second += next->second;
+    block.freeRanges.erase(next);
+  }
+  // 前の空き領域と結合.
+  if (it != block.freeRanges.begin())
+  {
+    auto prev = std::prev(it);
+    if (prev->first + prev->second == it->first)
+    {
+      prev->second += it->second;
+      block.freeRanges.erase(it);
+    }
+  }
+}
+
+uint32_t DeviceMemoryAllocator::CreateBlock(BlockList& blocks, uint32_t memoryTypeIndex, VkDeviceSize size)
+{
+  auto block = std::make_unique<Block>();
+  VkMemoryAllocateInfo info{
+    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    nullptr,
+    size,
+    memoryTypeIndex
+  };
+  auto result = vkAllocateMemory(m_device, &info, nullptr, &block->memory);
+  ThrowIfFailed(result, "vkAllocateMemory Failed.");
+  block->size = size;
+  block->mapped = MapWhole(block->memory, memoryTypeIndex);
+  block->used = 0;
+  block->allocationCount = 0;
+  block->freeRanges[0] = size;
+
+  // 解放済みの枠があれば再利用する.
+  auto it = std::find(blocks.begin(), blocks.end(), nullptr);
+  if (it != blocks.end())
+  {
+    *it = std::move(block);
+    return uint32_t(std::distance(blocks.begin(), it));
+  }
+  blocks.push_back(std::move(block));
+  return uint32_t(blocks.size() - 1);
+}
+
+void DeviceMemoryAllocator::ReleaseEmptyBlocks(BlockList& blocks, uint32_t keepIndex)
+{
+  // ステージングバッファの確保/解放の繰り返しでブロックを作り直さないよう、
+  // 空ブロックは 1 つだけ残しておく.
+  for (uint32_t i = 0; i < uint32_t(blocks.size()); ++i)
+  {
+    if (i == keepIndex || !blocks[i] || blocks[i]->allocationCount > 0)
+    {
+      continue;
+    }
+    vkFreeMemory(m_device, blocks[i]->memory, nullptr);
+    blocks[i].reset();
+  }
+}
+
+void* DeviceMemoryAllocator::MapWhole(VkDeviceMemory memory, uint32_t memoryTypeIndex)
+{
+  // マップしたままの解放は vkFreeMemory が暗黙的にアンマップするので Unmap はしない.
+  if (!IsHostVisible(memoryTypeIndex))
+  {
+    return nullptr;
+  }
+  void* p = nullptr;
+  auto result = vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &p);
+  ThrowIfFailed(result, "vkMapMemory Failed.");
+  return p;
+}
+
+bool DeviceMemoryAllocator::GetMappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange& range) const
+{
+  if (allocation.mapped == nullptr || IsHostCoherent(allocation.memoryTypeIndex))
+  {
+    return false;
+  }
+  if (size == VK_WHOLE_SIZE)
+  {
+    size = allocation.size - offset;
+  }
+  auto memorySize = allocation.size;
+  if (allocation.blockIndex != DedicatedBlock)
+  {
+    memorySize = m_blocks[allocation.memoryTypeIndex][allocation.kind][allocation.blockIndex]->size;
+  }
+
+  // 範囲は nonCoherentAtomSize の倍数かメモリ末尾まででなければならない.
+  auto begin = AlignDown(allocation.offset + offset, m_nonCoherentAtomSize);
+  auto end = AlignUp(allocation.offset + offset + size, m_nonCoherentAtomSize);
+  range = VkMappedMemoryRange{
+    VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, nullptr,
+    allocation.memory,
+    begin,
+    end < memorySize ? end - begin : VK_WHOLE_SIZE
+  };
+  return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <map>
+#include <memory>
+
+// デバイスメモリのサブアロケータ.
+// メモリタイプごとに大きな VkDeviceMemory (ブロック) を確保し、
+// その中からリソースの領域を切り出して使用する.
+class DeviceMemoryAllocator
+{
+public:
+  // リソースの種類.
+  // バッファとイメージを別ブロックに置くことで bufferImageGranularity を考慮しなくて済むようにする.
+  enum ResourceKind
+  {
+    ResourceKind_Linear,    // バッファ.
+    ResourceKind_Optimal,   // イメージ(VK_IMAGE_TILING_OPTIMAL).
+    ResourceKind_Count,
+  };
+  // 用途による分類. 確保量の集計にのみ使い、配置には影響しない.
+  enum Category
+  {
+    Category_Vertex,
+    Category_Index,
+    Category_Uniform,
+    Category_Staging,
+    Category_Texture,
+    Category_RenderTarget,
+    Category_Other,
+    Category_Count,
+  };
+
+  struct Allocation
+  {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;      // memory 内のオフセット(アライメント済み).
+    VkDeviceSize size;
+    void* mapped;             // ホストから見えるメモリの場合、offset 位置を指す CPU 側ポインタ.
+
+    uint32_t memoryTypeIndex;
+    uint32_t kind;
+    uint32_t category;
+    uint32_t blockIndex;      // 専用割り当ての場合は DedicatedBlock.
+    VkDeviceSize rangeOffset; // ブロック内で占有している領域(パディング込み).
+    VkDeviceSize rangeSize;
+  };
+  static const uint32_t DedicatedBlock = ~0u;
+
+  struct Statistics
+  {
+    uint32_t allocationCount;     // 生存中のサブアロケーション数.
+    uint32_t deviceMemoryCount;   // vkAllocateMemory で確保中の数.
+    uint32_t dedicatedCount;
+    VkDeviceSize bytesReserved;   // ドライバから確保した総量.
+    VkDeviceSize bytesUsed;       // リソースが要求した総量.
+    VkDeviceSize bytesWasted;     // アライメントによるパディングの総量.
+    VkDeviceSize bytesFree;
+    VkDeviceSize largestFreeRange;
+    float fragmentation;          // 1 - (最大空き領域 / 空き領域総量).
+  };
+  struct CategoryStatistics
+  {
+    uint32_t allocationCount;
+    VkDeviceSize bytesUsed;
+    VkDeviceSize peakBytes;       // 起動からの最大値.
+  };
+
+  DeviceMemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties& memProps, VkDeviceSize nonCoherentAtomSize);
+  ~DeviceMemoryAllocator();
+
+  Allocation Allocate(const VkMemoryRequirements& reqs, uint32_t memoryTypeIndex, ResourceKind kind, Category category = Category_Other);
+  // イメージ専用のメモリを確保する(大きなレンダーターゲット等). 種類は image/buffer のどちらを渡したかで決まる.
+  Allocation AllocateDedicated(const VkMemoryRequirements& reqs, uint32_t memoryTypeIndex, VkImage image, VkBuffer buffer, Category category = Category_Other);
+  void Free(const Allocation& allocation);
+
+  // 非コヒーレントなメモリタイプの場合のみ実際に処理を行う. offset, size は割り当て先頭からの範囲.
+  void Flush(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+  void Invalidate(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+  bool IsHostCoherent(uint32_t memoryTypeIndex) const;
+  uint32_t FindMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestProps) const;
+  bool IsHostVisible(uint32_t memoryTypeIndex) const;
+
+  // 残っているブロックと専用割り当てを解放する. 専用割り当てが残っていた場合はログに出す.
+  void Cleanup();
+
+  Statistics GetStatistics() const;
+  CategoryStatistics GetCategoryStatistics(Category category) const { return m_categories[category]; }
+  static const char* GetCategoryName(Category category);
+
+  VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+  // この大きさ以上の要求は専用割り当てとする.
+  VkDeviceSize GetDedicatedThreshold(uint32_t memoryTypeIndex) const { return GetBlockSize(memoryTypeIndex) / 2; }
+
+private:
+  struct Block
+  {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void* mapped;     // ホストから見えるメモリは確保時に一度だけマップしておく.
+    VkDeviceSize used;
+    uint32_t allocationCount;
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges;  // オフセット -> サイズ.
+  };
+  using BlockList = std::vector<std::unique_ptr<Block>>;
+
+  Allocation AllocateDedicatedMemory(const VkMemoryRequirements& reqs, uint32_t memoryTypeIndex, ResourceKind kind, VkImage image, VkBuffer buffer, Category category);
+  bool AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, Allocation& allocation);
+  void FreeRange(Block& block, VkDeviceSize offset, VkDeviceSize size);
+  uint32_t CreateBlock(BlockList& blocks, uint32_t memoryTypeIndex, VkDeviceSize size);
+  void ReleaseEmptyBlocks(BlockList& blocks, uint32_t keepIndex);
+  void* MapWhole(VkDeviceMemory memory, uint32_t memoryTypeIndex);
+  bool GetMappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange& range) const;
+  void TrackCategory(Allocation& allocation, Category category);
+
+  VkDevice m_device;
+  VkPhysicalDeviceMemoryProperties m_memProps;
+  VkDeviceSize m_nonCoherentAtomSize;
+
+  BlockList m_blocks[VK_MAX_MEMORY_TYPES][ResourceKind_Count];
+
+  std::vector<VkDeviceMemory> m_dedicatedMemories;  // Cleanup で解放漏れを拾うため.
+  uint32_t m_dedicatedCount;
+  VkDeviceSize m_dedicatedBytes;
+  uint32_t m_allocationCount;
+  VkDeviceSize m_bytesUsed;
+  VkDeviceSize m_bytesWasted;
+  CategoryStatistics m_categories[Category_Count];
+};
@@ -0,0 +1,208 @@
+#include "FrameRecorder.h"
+#include "VulkanBookUtil.h"
+
+#include <iterator>
+#include <cstring>
+
+namespace
+{
+  const char Magic[4] = { 'V', 'B', 'F', 'R' };
+  const uint32_t FileVersion = 1;
+
+  void WriteU32(std::ofstream& outfile, uint32_t value)
+  {
+    outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  bool ReadU32(const std::vector<uint8_t>& data, size_t& offset, uint32_t& value)
+  {
+    if (offset + sizeof(value) > data.size())
+    {
+      return false;
+    }
+    memcpy(&value, &data[offset], sizeof(value));
+    offset += sizeof(value);
+    return true;
+  }
+}
+
+FrameArchive::FrameArchive(std::vector<uint8_t>& buffer, bool isLoading)
+  : m_buffer(buffer), m_readOffset(0), m_isLoading(isLoading), m_isValid(true)
+{
+}
+
+void FrameArchive::Bytes(void* data, size_t size)
+{
+  if (!m_isLoading)
+  {
+    auto p = static_cast<const uint8_t*>(data);
+    m_buffer.insert(m_buffer.end(), p, p + size);
+    return;
+  }
+  if (!m_isValid || m_readOffset + size > m_buffer.size())
+  {
+    m_isValid = false;
+    return;
+  }
+  memcpy(data, &m_buffer[m_readOffset], size);
+  m_readOffset += size;
+}
+
+FrameRecorder::FrameRecorder(const char* fileName, Mode mode, const std::string& appName, uint32_t width, uint32_t height)
+  : m_mode(mode), m_isFrameActive(false), m_replayIndex(0), m_stats()
+{
+  if (m_mode == Mode_Replay)
+  {
+    LoadReplay(fileName, appName, width, height);
+    return;
+  }
+
+  m_outfile.open(fileName, std::ios::binary);
+  if (!m_outfile)
+  {
+    throw book_util::VulkanException(std::string("FrameRecorder: cannot create ") + fileName);
+  }
+  m_outfile.write(Magic, sizeof(Magic));
+  WriteU32(m_outfile, FileVersion);
+  WriteU32(m_outfile, uint32_t(appName.size()));
+  m_outfile.write(appName.data(), appName.size());
+  WriteU32(m_outfile, width);
+  WriteU32(m_outfile, height);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+  if (m_outfile.is_open())
+  {
+    m_outfile.close();
+  }
+}
+
+void FrameRecorder::LoadReplay(const char* fileName, const std::string& appName, uint32_t width, uint32_t height)
+{
+  std::ifstream infile(fileName, std::ios::binary);
+  if (!infile)
+  {
+    throw book_util::VulkanException(std::string("FrameRecorder: cannot open ") + fileName);
+  }
+  m_data.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+
+  size_t offset = sizeof(Magic);
+  uint32_t version = 0, nameLength = 0;
+  if (m_data.size() < sizeof(Magic) || memcmp(m_data.data(), Magic, sizeof(Magic)) != 0 ||
+    !ReadU32(m_data, offset, version) || version != FileVersion ||
+    !ReadU32(m_data, offset, nameLength) || offset + nameLength > m_data.size())
+  {
+    throw book_util::VulkanException(std::string("FrameRecorder: invalid capture file ") + fileName);
+  }
+  std::string recordedName(reinterpret_cast<const char*>(&m_data[offset]), nameLength);
+  offset += nameLength;
+  uint32_t recordedWidth = 0, recordedHeight = 0;
+  ReadU32(m_data, offset, recordedWidth);
+  ReadU32(m_data, offset, recordedHeight);
+  // 別のアプリや別の大きさで記録したものはユニフォーム(射影行列)が一致しないため使わない.
+  if (recordedName != appName || recordedWidth != width || recordedHeight != height)
+  {
+    throw book_util::VulkanException("FrameRecorder: capture was recorded by " + recordedName +
+      " at " + std::to_string(recordedWidth) + "x" + std::to_string(recordedHeight));
+  }
+
+  FrameRange previous{};
+  for (;;)
+  {
+    FrameRange frame{};
+    if (!ReadU32(m_data, offset, frame.inputSize) || offset + frame.inputSize > m_data.size())
+    {
+      break;
+    }
+    frame.inputOffset = offset;
+    offset += frame.inputSize;
+    if (!ReadU32(m_data, offset, frame.uniformSize))
+    {
+      break;
+    }
+    if (frame.uniformSize == RepeatPrevious)
+    {
+      frame.uniformOffset = previous.uniformOffset;
+      frame.uniformSize = previous.uniformSize;
+    }
+    else
+    {
+      if (offset + frame.uniformSize > m_data.size())
+      {
+        break;
+      }
+      frame.uniformOffset = offset;
+      offset += frame.uniformSize;
+    }
+    m_frames.push_back(frame);
+    previous = frame;
+  }
+}
+
+bool FrameRecorder::BeginFrame()
+{
+  m_input.clear();
+  m_uniforms.clear();
+  if (m_mode == Mode_Replay)
+  {
+    if (m_replayIndex >= m_frames.size())
+    {
+      m_isFrameActive = false;
+      return false;
+    }
+    const auto& frame = m_frames[m_replayIndex];
+    m_input.assign(m_data.begin() + frame.inputOffset, m_data.begin() + frame.inputOffset + frame.inputSize);
+  }
+  m_isFrameActive = true;
+  return true;
+}
+
+void FrameRecorder::AddUniformData(const void* data, size_t size)
+{
+  if (!m_isFrameActive)
+  {
+    return;
+  }
+  auto p = static_cast<const uint8_t*>(data);
+  m_uniforms.insert(m_uniforms.end(), p, p + size);
+}
+
+void FrameRecorder::EndFrame()
+{
+  if (!m_isFrameActive)
+  {
+    return;
+  }
+  m_isFrameActive = false;
+  m_stats.frameCount++;
+  m_stats.uniformBytes += m_uniforms.size();
+
+  if (m_mode == Mode_Replay)
+  {
+    const auto& frame = m_frames[m_replayIndex];
+    auto isMatched = frame.uniformSize == m_uniforms.size() &&
+      (m_uniforms.empty() || memcmp(&m_data[frame.uniformOffset], m_uniforms.data(), m_uniforms.size()) == 0);
+    if (!isMatched)
+    {
+      if (m_stats.uniformMismatches == 0)
+      {
+        m_stats.firstMismatchFrame = m_replayIndex;
+      }
+      m_stats.uniformMismatches++;
+    }
+    m_replayIndex++;
+    return;
+  }
+
+  WriteU32(m_outfile, uint32_t(m_input.size()));
+  m_outfile.write(reinterpret_cast<const char*>(m_input.data()), m_input.size());
+  if (m_stats.frameCount > 1 && m_uniforms == m_previousUniforms)
+  {
+    WriteU32(m_outfile, RepeatPrevious);
+    return;
+  }
+  WriteU32(m_outfile, uint32_t(m_uniforms.size()));
+  m_outfile.write(reinterpret_cast<const char*>(m_uniforms.data()), m_uniforms.size());
+  m_previousUniforms.swap(m_uniforms);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <type_traits>
+
+// フレームごとのアプリの入力の読み書き.
+// 同じ関数で記録(値を書き出す)と再生(値を上書きする)の両方を行う.
+class FrameArchive
+{
+public:
+  FrameArchive(std::vector<uint8_t>& buffer, bool isLoading);
+
+  bool IsLoading() const { return m_isLoading; }
+  // 再生時に記録が足りなかった場合は false. 以降の値は変更しない.
+  bool IsValid() const { return m_isValid; }
+
+  template<class T>
+  void Value(T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "FrameArchive supports trivially copyable types only.");
+    Bytes(&value, sizeof(T));
+  }
+  void Bytes(void* data, size_t size);
+
+private:
+  std::vector<uint8_t>& m_buffer;
+  size_t m_readOffset;
+  bool m_isLoading;
+  bool m_isValid;
+};
+
+// フレームの入力とユニフォームの内容の記録と再生.
+// ファイルはヘッダの後に、フレームごとの [入力のサイズ, 入力, ユニフォームのサイズ, ユニフォーム] が続く.
+// ユニフォームが前のフレームと同じ場合はサイズを RepeatPrevious として内容を省く.
+// 再生時はファイル全体を最初に読み込み、フレーム中にファイルアクセスは行わない.
+class FrameRecorder
+{
+public:
+  enum Mode
+  {
+    Mode_Record,
+    Mode_Replay,
+  };
+  static const uint32_t RepeatPrevious = ~0u;
+
+  struct Statistics
+  {
+    uint32_t frameCount;          // 記録/再生したフレーム数.
+    uint32_t uniformMismatches;   // 再生時、ユニフォームが記録と異なったフレーム数.
+    uint32_t firstMismatchFrame;
+    uint64_t uniformBytes;        // 記録/再生したユニフォームの総量(省略分を含む).
+  };
+
+  // 再生時、appName とサーフェースの大きさが記録と異なる場合は例外とする.
+  FrameRecorder(const char* fileName, Mode mode, const std::string& appName, uint32_t width, uint32_t height);
+  ~FrameRecorder();
+
+  Mode GetMode() const { return m_mode; }
+  // 再生時は記録されているフレーム数.
+  uint32_t GetRecordedFrameCount() const { return uint32_t(m_frames.size()); }
+
+  // フレームの開始. 再生時は記録を使い切っていれば false を返し、入力は上書きしない.
+  bool BeginFrame();
+  FrameArchive GetInputArchive() { return FrameArchive(m_input, m_mode == Mode_Replay); }
+  // このフレームで書き込んだユニフォーム. BeginFrame と EndFrame の間以外では無視する.
+  void AddUniformData(const void* data, size_t size);
+  // 記録時はファイルへ書き出し、再生時は記録されたユニフォームと比較する.
+  void EndFrame();
+  // フレームを記録/比較せずに終える. 再生時は次の BeginFrame で同じフレームの入力を返す.
+  void DiscardFrame() { m_isFrameActive = false; }
+
+  const Statistics& GetStatistics() const { return m_stats; }
+
+private:
+  struct FrameRange
+  {
+    size_t inputOffset;
+    uint32_t inputSize;
+    size_t uniformOffset;
+    uint32_t uniformSize;
+  };
+  void LoadReplay(const char* fileName, const std::string& appName, uint32_t width, uint32_t height);
+
+  Mode m_mode;
+  bool m_isFrameActive;
+  std::ofstream m_outfile;
+
+  std::vector<uint8_t> m_input;
+  std::vector<uint8_t> m_uniforms;
+  std::vector<uint8_t> m_previousUniforms;
+
+  // 再生用. ファイルの内容と各フレームの位置.
+  std::vector<uint8_t> m_data;
+  std::vector<FrameRange> m_frames;
+  uint32_t m_replayIndex;
+
+  Statistics m_stats;
+};
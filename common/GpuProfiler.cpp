@@ -0,0 +1,350 @@
+#include "GpuProfiler.h"
+#include "TraceRecorder.h"
+#include "VulkanBookUtil.h"
+#include "imgui.h"
+
+#include <fstream>
+#include <algorithm>
+
+GpuProfiler::Scope::Scope(GpuProfiler* profiler, VkCommandBuffer command, const char* name, bool withStatistics)
+  : m_profiler(profiler), m_command(command), m_queryIndex(~0u), m_withStatistics(false)
+{
+  if (m_profiler)
+  {
+    m_withStatistics = withStatistics && m_profiler->IsStatisticsSupported();
+    m_queryIndex = m_profiler->BeginScope(command, name, m_withStatistics);
+  }
+}
+
+GpuProfiler::Scope::~Scope()
+{
+  if (m_profiler && m_queryIndex != ~0u)
+  {
+    m_profiler->EndScope(m_command, m_queryIndex, m_withStatistics);
+  }
+}
+
+GpuProfiler::GpuProfiler(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t frameCount, VkQueryPipelineStatisticFlags statisticsFlags)
+  : m_device(device), m_timestampPeriod(timestampPeriod),
+  m_timestampMask((timestampValidBits >= 64) ? ~uint64_t(0) : ((uint64_t(1) << timestampValidBits) - 1)),
+  m_isSupported(timestampValidBits != 0),
+  m_statisticsFlags(timestampValidBits != 0 ? statisticsFlags : 0), m_statisticsCount(0), m_frameIndex(0), m_trace(nullptr)
+{
+  for (uint32_t i = 0; i < Statistic_Count; ++i)
+  {
+    m_statisticsCount += (m_statisticsFlags & (1u << i)) ? 1 : 0;
+  }
+  m_results.resize((std::max)(MaxScopesPerFrame * 2, m_statisticsCount));
+  if (!m_isSupported)
+  {
+    return;
+  }
+  m_frames.resize(frameCount);
+  for (auto& frame : m_frames)
+  {
+    VkQueryPoolCreateInfo poolCI{
+      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      nullptr, 0,
+      VK_QUERY_TYPE_TIMESTAMP,
+      MaxScopesPerFrame * 2,
+      0
+    };
+    auto result = vkCreateQueryPool(m_device, &poolCI, nullptr, &frame.pool);
+    ThrowIfFailed(result, "vkCreateQueryPool Failed.");
+
+    frame.statisticsPool = VK_NULL_HANDLE;
+    if (m_statisticsFlags != 0)
+    {
+      VkQueryPoolCreateInfo statisticsCI{
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        nullptr, 0,
+        VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        MaxScopesPerFrame,
+        m_statisticsFlags
+      };
+      result = vkCreateQueryPool(m_device, &statisticsCI, nullptr, &frame.statisticsPool);
+      ThrowIfFailed(result, "vkCreateQueryPool Failed.");
+    }
+    frame.names.reserve(MaxScopesPerFrame);
+    frame.withStatistics.reserve(MaxScopesPerFrame);
+    frame.isRecorded = false;
+  }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+  for (auto& frame : m_frames)
+  {
+    vkDestroyQueryPool(m_device, frame.pool, nullptr);
+    if (frame.statisticsPool != VK_NULL_HANDLE)
+    {
+      vkDestroyQueryPool(m_device, frame.statisticsPool, nullptr);
+    }
+  }
+  m_frames.clear();
+}
+
+void GpuProfiler::NewFrame(uint32_t frameIndex)
+{
+  if (!m_isSupported)
+  {
+    return;
+  }
+  m_frameIndex = frameIndex;
+  auto& frame = m_frames[m_frameIndex];
+  if (frame.isRecorded && !frame.names.empty())
+  {
+    // フェンスは待機済みのため通常は揃っている. 揃っていなければこのフレームの結果は捨てる.
+    auto queryCount = uint32_t(frame.names.size() * 2);
+    auto result = vkGetQueryPoolResults(m_device, frame.pool, 0, queryCount,
+      sizeof(uint64_t) * queryCount, m_results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS)
+    {
+      for (size_t i = 0; i < frame.names.size(); ++i)
+      {
+        // 有効なビットより上は不定. 途中で一周しても差はマスク内で求まる.
+        auto beginTicks = m_results[i * 2] & m_timestampMask;
+        auto endTicks = m_results[i * 2 + 1] & m_timestampMask;
+        auto ticks = (endTicks - beginTicks) & m_timestampMask;
+        auto ms = double(ticks) * m_timestampPeriod / 1000000.0;
+
+        auto& timing = FindTiming(frame.names[i]);
+        timing.lastMs = ms;
+        timing.totalMs += ms;
+        timing.minMs = timing.sampleCount == 0 ? ms : (std::min)(timing.minMs, ms);
+        timing.maxMs = (std::max)(timing.maxMs, ms);
+        timing.sampleCount++;
+        timing.history[timing.historyOffset] = float(ms);
+        timing.historyOffset = (timing.historyOffset + 1) % HistoryLength;
+        if (m_trace)
+        {
+          m_trace->AddGpuEvent(frame.names[i], beginTicks, endTicks);
+        }
+      }
+      // 統計は区間ごとに取得する(統計を取らない区間のクエリは未使用のため).
+      for (size_t i = 0; i < frame.names.size(); ++i)
+      {
+        if (frame.withStatistics[i])
+        {
+          ReadStatistics(frame.statisticsPool, uint32_t(i), FindTiming(frame.names[i]));
+        }
+      }
+    }
+  }
+  frame.names.clear();
+  frame.withStatistics.clear();
+  frame.isRecorded = false;
+}
+
+void GpuProfiler::ReadStatistics(VkQueryPool pool, uint32_t scopeIndex, PassTiming& timing)
+{
+  auto result = vkGetQueryPoolResults(m_device, pool, scopeIndex, 1,
+    sizeof(uint64_t) * m_statisticsCount, m_results.data(), sizeof(uint64_t) * m_statisticsCount, VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS)
+  {
+    return;
+  }
+  // 結果は有効なビットの昇順に詰められている.
+  uint32_t resultIndex = 0;
+  for (uint32_t i = 0; i < Statistic_Count; ++i)
+  {
+    uint64_t value = 0;
+    if (m_statisticsFlags & (1u << i))
+    {
+      value = m_results[resultIndex++];
+    }
+    timing.lastStatistics[i] = value;
+    timing.totalStatistics[i] += double(value);
+  }
+  timing.hasStatistics = true;
+  timing.statisticsSampleCount++;
+}
+
+void GpuProfiler::CollectAll()
+{
+  auto frameIndex = m_frameIndex;
+  for (uint32_t i = 0; i < uint32_t(m_frames.size()); ++i)
+  {
+    NewFrame(i);
+  }
+  m_frameIndex = frameIndex;
+}
+
+void GpuProfiler::ResetQueries(VkCommandBuffer command)
+{
+  if (!m_isSupported)
+  {
+    return;
+  }
+  auto& frame = m_frames[m_frameIndex];
+  vkCmdResetQueryPool(command, frame.pool, 0, MaxScopesPerFrame * 2);
+  if (frame.statisticsPool != VK_NULL_HANDLE)
+  {
+    vkCmdResetQueryPool(command, frame.statisticsPool, 0, MaxScopesPerFrame);
+  }
+  frame.isRecorded = true;
+}
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer command, const char* name, bool withStatistics)
+{
+  if (!m_isSupported)
+  {
+    return ~0u;
+  }
+  auto& frame = m_frames[m_frameIndex];
+  if (!frame.isRecorded || frame.names.size() >= MaxScopesPerFrame)
+  {
+    return ~0u;
+  }
+  auto queryIndex = uint32_t(frame.names.size() * 2);
+  frame.names.push_back(name);
+  frame.withStatistics.push_back(withStatistics ? 1 : 0);
+  vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.pool, queryIndex);
+  if (withStatistics)
+  {
+    vkCmdBeginQuery(command, frame.statisticsPool, queryIndex / 2, 0);
+  }
+  return queryIndex;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer command, uint32_t queryIndex, bool withStatistics)
+{
+  auto& frame = m_frames[m_frameIndex];
+  if (withStatistics)
+  {
+    vkCmdEndQuery(command, frame.statisticsPool, queryIndex / 2);
+  }
+  vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.pool, queryIndex + 1);
+}
+
+VkQueryPipelineStatisticFlags GpuProfiler::GetStatisticsFlags(const VkPhysicalDeviceFeatures& enabledFeatures)
+{
+  if (!enabledFeatures.pipelineStatisticsQuery)
+  {
+    return 0;
+  }
+  VkQueryPipelineStatisticFlags flags =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+  // 対応する機能が無効なステージのビットは指定できない.
+  if (enabledFeatures.geometryShader)
+  {
+    flags |= VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT;
+  }
+  if (enabledFeatures.tessellationShader)
+  {
+    flags |= VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT | VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+  }
+  return flags;
+}
+
+const char* GpuProfiler::GetStatisticName(Statistic statistic)
+{
+  static const char* names[] = {
+    "IA vertices", "IA primitives", "VS invocations", "GS invocations", "GS primitives",
+    "Clip invocations", "Clip primitives", "FS invocations", "TCS patches", "TES invocations",
+  };
+  return names[statistic];
+}
+
+GpuProfiler::PassTiming& GpuProfiler::FindTiming(const char* name)
+{
+  auto it = std::find_if(m_timings.begin(), m_timings.end(),
+    [&](const PassTiming& t) { return t.name == name; });
+  if (it != m_timings.end())
+  {
+    return *it;
+  }
+  PassTiming timing{};
+  timing.name = name;
+  m_timings.push_back(timing);
+  return m_timings.back();
+}
+
+void GpuProfiler::DrawImGui()
+{
+  ImGui::Begin("GPU Profiler");
+  if (!m_isSupported)
+  {
+    ImGui::Text("Timestamp queries are not supported.");
+    ImGui::End();
+    return;
+  }
+  ImGui::Columns(4, "gpu_passes");
+  ImGui::Text("Pass"); ImGui::NextColumn();
+  ImGui::Text("Last(ms)"); ImGui::NextColumn();
+  ImGui::Text("Avg(ms)"); ImGui::NextColumn();
+  ImGui::Text("Max(ms)"); ImGui::NextColumn();
+  ImGui::Separator();
+  for (const auto& t : m_timings)
+  {
+    auto avg = t.sampleCount > 0 ? t.totalMs / t.sampleCount : 0.0;
+    ImGui::Text("%s", t.name.c_str()); ImGui::NextColumn();
+    ImGui::Text("%.3f", t.lastMs); ImGui::NextColumn();
+    ImGui::Text("%.3f", avg); ImGui::NextColumn();
+    ImGui::Text("%.3f", t.maxMs); ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+  ImGui::Separator();
+  for (const auto& t : m_timings)
+  {
+    ImGui::PlotLines(t.name.c_str(), t.history, int(HistoryLength), int(t.historyOffset),
+      nullptr, 0.0f, 3.4e38f, ImVec2(0, 40));
+  }
+  for (const auto& t : m_timings)
+  {
+    if (!t.hasStatistics || !ImGui::TreeNode(t.name.c_str()))
+    {
+      continue;
+    }
+    for (uint32_t i = 0; i < Statistic_Count; ++i)
+    {
+      if (m_statisticsFlags & (1u << i))
+      {
+        ImGui::Text("%-18s %llu", GetStatisticName(Statistic(i)), (unsigned long long)t.lastStatistics[i]);
+      }
+    }
+    ImGui::TreePop();
+  }
+  if (ImGui::Button("Export CSV"))
+  {
+    ExportCsv("gpu_profile.csv");
+  }
+  ImGui::End();
+}
+
+bool GpuProfiler::ExportCsv(const char* fileName) const
+{
+  std::ofstream outfile(fileName);
+  if (!outfile)
+  {
+    return false;
+  }
+  outfile << "pass,samples,last_ms,avg_ms,min_ms,max_ms";
+  for (uint32_t i = 0; i < Statistic_Count; ++i)
+  {
+    outfile << "," << GetStatisticName(Statistic(i));
+  }
+  outfile << std::endl;
+  for (const auto& t : m_timings)
+  {
+    auto avg = t.sampleCount > 0 ? t.totalMs / t.sampleCount : 0.0;
+    outfile << t.name << "," << t.sampleCount << "," << t.lastMs << ","
+      << avg << "," << t.minMs << "," << t.maxMs;
+    // 統計は 1 フレームあたりの平均.
+    for (uint32_t i = 0; i < Statistic_Count; ++i)
+    {
+      outfile << ",";
+      if (t.statisticsSampleCount > 0)
+      {
+        outfile << t.totalStatistics[i] / t.statisticsSampleCount;
+      }
+    }
+    outfile << std::endl;
+  }
+  return bool(outfile);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+
+class TraceRecorder;
+
+// タイムスタンプクエリによる GPU 時間の計測.
+// 処理中のフレームごとにクエリプールを持ち、結果はそのフレームの完了を待った後に待機せず取得する.
+// 指定した区間ではパイプライン統計クエリで各ステージの処理数も数える.
+class GpuProfiler
+{
+public:
+  // 計測区間. 生成時と破棄時にタイムスタンプを書き込む.
+  // withStatistics の区間はグラフィックスのコマンドバッファで、レンダーパスの内外をまたがないこと.
+  // name はコピーせずに保持するため、結果を取り込むまで(文字列リテラル等)有効であること.
+  class Scope
+  {
+  public:
+    Scope(GpuProfiler* profiler, VkCommandBuffer command, const char* name, bool withStatistics = false);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    GpuProfiler* m_profiler;
+    VkCommandBuffer m_command;
+    uint32_t m_queryIndex;
+    bool m_withStatistics;
+  };
+
+  // VkQueryPipelineStatisticFlagBits のビット順.
+  enum Statistic
+  {
+    Statistic_InputVertices,
+    Statistic_InputPrimitives,
+    Statistic_VertexInvocations,
+    Statistic_GeometryInvocations,
+    Statistic_GeometryPrimitives,
+    Statistic_ClippingInvocations,
+    Statistic_ClippingPrimitives,
+    Statistic_FragmentInvocations,
+    Statistic_TessControlPatches,
+    Statistic_TessEvaluationInvocations,
+    Statistic_Count,
+  };
+
+  static const uint32_t MaxScopesPerFrame = 32;
+  static const uint32_t HistoryLength = 120;
+
+  struct PassTiming
+  {
+    std::string name;
+    float history[HistoryLength]; // 直近の値(ms). historyOffset が次に書き込む位置.
+    uint32_t historyOffset;
+    uint32_t sampleCount;
+    double lastMs;
+    double totalMs;
+    double minMs;
+    double maxMs;
+
+    // パイプライン統計. 有効でないステージの値は 0 となる.
+    bool hasStatistics;
+    uint32_t statisticsSampleCount;
+    uint64_t lastStatistics[Statistic_Count];
+    double totalStatistics[Statistic_Count];
+  };
+
+  // timestampPeriod は VkPhysicalDeviceLimits の値(1 カウントあたりのナノ秒).
+  // timestampValidBits は区間を記録するキューのファミリーの値の最小値. 0 の場合は計測しない.
+  // statisticsFlags が 0 の場合はパイプライン統計を取らない.
+  GpuProfiler(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t frameCount, VkQueryPipelineStatisticFlags statisticsFlags);
+  ~GpuProfiler();
+
+  // フレームの開始時(フェンス待ちの後)に呼ぶ. 前回このスロットで計測した結果を取り込む.
+  void NewFrame(uint32_t frameIndex);
+  // このフレームで最初に発行するコマンドバッファに、レンダーパスの外で記録する.
+  void ResetQueries(VkCommandBuffer command);
+
+  // 全スロットの結果を取り込む. vkDeviceWaitIdle の後に呼ぶ.
+  void CollectAll();
+  void ResetTimings() { m_timings.clear(); }
+  // 取り込んだ各区間のタイムスタンプを TraceRecorder へ渡す. null で解除.
+  void SetTraceRecorder(TraceRecorder* trace) { m_trace = trace; }
+
+  const std::vector<PassTiming>& GetTimings() const { return m_timings; }
+  bool IsSupported() const { return m_isSupported; }
+  // タイムスタンプの有効なビット. 取り込んだ値はこのマスクを掛けてある.
+  uint64_t GetTimestampMask() const { return m_timestampMask; }
+  bool IsStatisticsSupported() const { return m_statisticsFlags != 0; }
+
+  // 有効なデバイスの機能で使用できる統計の種類(pipelineStatisticsQuery が無効なら 0).
+  static VkQueryPipelineStatisticFlags GetStatisticsFlags(const VkPhysicalDeviceFeatures& enabledFeatures);
+  static const char* GetStatisticName(Statistic statistic);
+
+  void DrawImGui();
+  bool ExportCsv(const char* fileName) const;
+
+private:
+  struct FrameQueries
+  {
+    VkQueryPool pool;
+    VkQueryPool statisticsPool;      // 区間 i はクエリ i を使う.
+    std::vector<const char*> names;  // 区間 i はクエリ 2i, 2i+1 を使う.
+    std::vector<uint8_t> withStatistics;
+    bool isRecorded;
+  };
+  uint32_t BeginScope(VkCommandBuffer command, const char* name, bool withStatistics);
+  void EndScope(VkCommandBuffer command, uint32_t queryIndex, bool withStatistics);
+  void ReadStatistics(VkQueryPool pool, uint32_t scopeIndex, PassTiming& timing);
+  PassTiming& FindTiming(const char* name);
+
+  VkDevice m_device;
+  float m_timestampPeriod;
+  uint64_t m_timestampMask;
+  bool m_isSupported;
+  VkQueryPipelineStatisticFlags m_statisticsFlags;
+  uint32_t m_statisticsCount;   // 1 クエリあたりの結果の数.
+  std::vector<FrameQueries> m_frames;
+  uint32_t m_frameIndex;
+  std::vector<uint64_t> m_results;
+  std::vector<PassTiming> m_timings;
+  TraceRecorder* m_trace;
+};
@@ -0,0 +1,698 @@
+#include "RenderGraph.h"
+#include "VulkanBookUtil.h"
+
+#include <algorithm>
+
+// 使い方ごとのステージ/アクセス/レイアウト. 書き込みのアクセスは読み書きの両方を含む.
+static const struct
+{
+  VkPipelineStageFlags stages;
+  VkAccessFlags readAccess;
+  VkAccessFlags writeAccess;
+  VkImageLayout layout;
+} UsageInfos[] = {
+  // Usage_ColorAttachment
+  {
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+  },
+  // Usage_DepthAttachment
+  {
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+  },
+  // Usage_SampledFragment
+  {
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+    VK_ACCESS_SHADER_READ_BIT,
+    0,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  },
+  // Usage_StorageCompute
+  {
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+    VK_ACCESS_SHADER_READ_BIT,
+    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    VK_IMAGE_LAYOUT_GENERAL,
+  },
+};
+static_assert(sizeof(UsageInfos) / sizeof(UsageInfos[0]) == RenderGraph::Usage_Count, "UsageInfos must match Usage.");
+
+static const VkAccessFlags WriteAccessMask =
+  VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+  VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+static VkImageAspectFlags GetAspect(VkFormat format)
+{
+  switch (format)
+  {
+  case VK_FORMAT_D16_UNORM:
+  case VK_FORMAT_X8_D24_UNORM_PACK32:
+  case VK_FORMAT_D32_SFLOAT:
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+  case VK_FORMAT_D16_UNORM_S8_UINT:
+  case VK_FORMAT_D24_UNORM_S8_UINT:
+  case VK_FORMAT_D32_SFLOAT_S8_UINT:
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+  default:
+    return VK_IMAGE_ASPECT_COLOR_BIT;
+  }
+}
+
+static void AddBarrier(std::vector<VkImageMemoryBarrier>& barriers, VkPipelineStageFlags& srcStages, VkPipelineStageFlags& dstStages,
+  VkPipelineStageFlags src, VkPipelineStageFlags dst, const VkImageMemoryBarrier& barrier)
+{
+  srcStages |= src;
+  dstStages |= dst;
+  barriers.push_back(barrier);
+}
+
+RenderGraph::RenderGraph(const char* name, VkDevice device, DeviceMemoryAllocator* allocator, uint32_t graphicsFamily, uint32_t computeFamily)
+  : m_name(name), m_device(device), m_allocator(allocator), m_families{ graphicsFamily, computeFamily },
+  m_firstFrame(), m_steady(), m_isCompiled(false), m_isExecuted(false), m_stats()
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+  Reset();
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportImage(const char* name, VkImage image, const VkImageSubresourceRange& range, const ImageState& initialState)
+{
+  Resource resource{};
+  resource.name = name;
+  resource.isTransient = false;
+  resource.image = image;
+  resource.range = range;
+  resource.initialState = initialState;
+  resource.firstStep = resource.lastStep = InvalidStep;
+  m_resources.push_back(resource);
+  return ResourceHandle{ uint32_t(m_resources.size() - 1) };
+}
+
+RenderGraph::ResourceHandle RenderGraph::CreateImage(const char* name, const ImageDesc& desc)
+{
+  Resource resource{};
+  resource.name = name;
+  resource.isTransient = true;
+  resource.desc = desc;
+  resource.range = { GetAspect(desc.format), 0, 1, 0, desc.arrayLayers };
+  resource.initialState = ImageState{ VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, Queue_Graphics };
+  resource.firstStep = resource.lastStep = InvalidStep;
+  m_resources.push_back(resource);
+  return ResourceHandle{ uint32_t(m_resources.size() - 1) };
+}
+
+uint32_t RenderGraph::AddPass(const char* name, Queue queue, ExecuteFunc func)
+{
+  m_passes.push_back(Pass{ name, queue, func, {}, false });
+  return uint32_t(m_passes.size() - 1);
+}
+
+void RenderGraph::Read(uint32_t pass, ResourceHandle resource, Usage usage)
+{
+  if (UsageInfos[usage].readAccess == 0)
+  {
+    throw book_util::VulkanException("RenderGraph: usage cannot be read.");
+  }
+  m_passes[pass].accesses.push_back(Access{ resource.index, usage, false });
+}
+
+void RenderGraph::Write(uint32_t pass, ResourceHandle resource, Usage usage)
+{
+  if (UsageInfos[usage].writeAccess == 0)
+  {
+    throw book_util::VulkanException("RenderGraph: usage cannot be written.");
+  }
+  m_passes[pass].accesses.push_back(Access{ resource.index, usage, true });
+}
+
+void RenderGraph::SetSideEffect(uint32_t pass)
+{
+  m_passes[pass].hasSideEffect = true;
+}
+
+void RenderGraph::Compile()
+{
+  if (m_isCompiled)
+  {
+    throw book_util::VulkanException("RenderGraph: already compiled.");
+  }
+  std::vector<bool> isAlive;
+  CullPasses(isAlive);
+  m_order = SortPasses(isAlive);
+
+  for (uint32_t step = 0; step < uint32_t(m_order.size()); ++step)
+  {
+    for (const auto& access : m_passes[m_order[step]].accesses)
+    {
+      auto& resource = m_resources[access.resource];
+      resource.firstStep = (std::min)(resource.firstStep, step);
+      resource.lastStep = (resource.lastStep == InvalidStep) ? step : (std::max)(resource.lastStep, step);
+    }
+  }
+  CreateTransientImages();
+
+  // 取り込んだイメージは初期状態から、一時イメージは同じメモリを前に使ったイメージの状態から始める.
+  std::vector<TrackedState> states(m_resources.size());
+  for (size_t i = 0; i < m_resources.size(); ++i)
+  {
+    const auto& initial = m_resources[i].initialState;
+    auto& state = states[i];
+    state = TrackedState{};
+    state.layout = initial.layout;
+    state.queue = initial.queue;
+    state.writeStages = (initial.access & WriteAccessMask) ? initial.stages : 0;
+    state.writeAccess = initial.access & WriteAccessMask;
+    state.readStages = initial.stages;
+    state.lastStep = InvalidStep;
+    state.isUsed = !m_resources[i].isTransient;
+  }
+  std::vector<TrackedState> slots(m_slots.size());
+  for (size_t i = 0; i < m_slots.size(); ++i)
+  {
+    slots[i] = TrackedState{};
+    slots[i].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    slots[i].queue = m_slots[i].queue;
+    slots[i].lastStep = InvalidStep;
+  }
+  m_firstFrame = BuildProgram(states, slots, false);
+  m_steady = BuildProgram(states, slots, true);
+  m_finalStates = states;
+  // 最初のフレームの終わりにも、次のフレームで他のキューが使うイメージを解放しておく.
+  for (int queue = 0; queue < Queue_Count; ++queue)
+  {
+    m_firstFrame.frameEnd[queue] = m_steady.frameEnd[queue];
+  }
+
+  m_stats.declaredPasses = uint32_t(m_passes.size());
+  m_stats.culledPasses = uint32_t(m_passes.size() - m_order.size());
+  m_stats.barrierBatches = 0;
+  m_stats.imageBarriers = 0;
+  auto count = [&](const Batch& batch) {
+    if (!batch.barriers.empty())
+    {
+      m_stats.barrierBatches++;
+      m_stats.imageBarriers += uint32_t(batch.barriers.size());
+    }
+  };
+  for (const auto& step : m_steady.steps)
+  {
+    count(step.before);
+    count(step.after);
+  }
+  for (const auto& batch : m_steady.frameEnd)
+  {
+    count(batch);
+  }
+  m_isCompiled = true;
+  m_isExecuted = false;
+}
+
+void RenderGraph::CullPasses(std::vector<bool>& isAlive) const
+{
+  // 出力から逆にたどり、使うイメージを書き込むパスを残す.
+  isAlive.assign(m_passes.size(), false);
+  std::vector<uint32_t> pending;
+  for (uint32_t i = 0; i < uint32_t(m_passes.size()); ++i)
+  {
+    if (m_passes[i].hasSideEffect)
+    {
+      isAlive[i] = true;
+      pending.push_back(i);
+    }
+  }
+  while (!pending.empty())
+  {
+    auto pass = pending.back();
+    pending.pop_back();
+    for (const auto& access : m_passes[pass].accesses)
+    {
+      for (uint32_t i = 0; i < uint32_t(m_passes.size()); ++i)
+      {
+        if (isAlive[i])
+        {
+          continue;
+        }
+        for (const auto& other : m_passes[i].accesses)
+        {
+          if (other.isWrite && other.resource == access.resource)
+          {
+            isAlive[i] = true;
+            pending.push_back(i);
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+std::vector<uint32_t> RenderGraph::SortPasses(const std::vector<bool>& isAlive) const
+{
+  // 書き込み同士は宣言順、書き込みは読み取りより前.
+  auto passCount = uint32_t(m_passes.size());
+  std::vector<std::vector<uint32_t>> edges(passCount);
+  std::vector<uint32_t> inDegree(passCount, 0);
+  auto addEdge = [&](uint32_t from, uint32_t to) {
+    if (std::find(edges[from].begin(), edges[from].end(), to) == edges[from].end())
+    {
+      edges[from].push_back(to);
+      inDegree[to]++;
+    }
+  };
+  for (uint32_t r = 0; r < uint32_t(m_resources.size()); ++r)
+  {
+    std::vector<uint32_t> writers, readers;
+    for (uint32_t i = 0; i < passCount; ++i)
+    {
+      if (!isAlive[i])
+      {
+        continue;
+      }
+      auto isWriter = false, isReader = false;
+      for (const auto& access : m_passes[i].accesses)
+      {
+        if (access.resource == r)
+        {
+          (access.isWrite ? isWriter : isReader) = true;
+        }
+      }
+      if (isWriter)
+      {
+        writers.push_back(i);
+      }
+      else if (isReader)
+      {
+        readers.push_back(i);
+      }
+    }
+    for (size_t i = 1; i < writers.size(); ++i)
+    {
+      addEdge(writers[i - 1], writers[i]);
+    }
+    for (auto writer : writers)
+    {
+      for (auto reader : readers)
+      {
+        addEdge(writer, reader);
+      }
+    }
+  }
+
+  // 実行できるもののうち宣言の早いものから並べる.
+  std::vector<uint32_t> order;
+  std::vector<bool> isPlaced(passCount, false);
+  auto aliveCount = uint32_t(std::count(isAlive.begin(), isAlive.end(), true));
+  while (uint32_t(order.size()) < aliveCount)
+  {
+    auto next = passCount;
+    for (uint32_t i = 0; i < passCount; ++i)
+    {
+      if (isAlive[i] && !isPlaced[i] && inDegree[i] == 0)
+      {
+        next = i;
+        break;
+      }
+    }
+    if (next == passCount)
+    {
+      throw book_util::VulkanException("RenderGraph: passes have a cyclic dependency.");
+    }
+    isPlaced[next] = true;
+    order.push_back(next);
+    for (auto to : edges[next])
+    {
+      inDegree[to]--;
+    }
+  }
+  return order;
+}
+
+void RenderGraph::CreateTransientImages()
+{
+  std::vector<uint32_t> transients;
+  std::vector<VkMemoryRequirements> reqs(m_resources.size());
+  std::vector<bool> isSingleQueue(m_resources.size(), true);
+  std::vector<Queue> queues(m_resources.size(), Queue_Graphics);
+  for (uint32_t r = 0; r < uint32_t(m_resources.size()); ++r)
+  {
+    auto& resource = m_resources[r];
+    if (!resource.isTransient || resource.firstStep == InvalidStep)
+    {
+      continue;
+    }
+    const auto& desc = resource.desc;
+    VkImageCreateInfo imageCI{
+      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, nullptr,
+      desc.flags,
+      VK_IMAGE_TYPE_2D,
+      desc.format,
+      { desc.extent.width, desc.extent.height, 1 },
+      1, desc.arrayLayers,
+      VK_SAMPLE_COUNT_1_BIT,
+      VK_IMAGE_TILING_OPTIMAL,
+      desc.usage,
+      VK_SHARING_MODE_EXCLUSIVE,
+      0, nullptr,
+      VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    auto result = vkCreateImage(m_device, &imageCI, nullptr, &resource.image);
+    ThrowIfFailed(result, "vkCreateImage Failed.");
+    vkGetImageMemoryRequirements(m_device, resource.image, &reqs[r]);
+
+    queues[r] = m_passes[m_order[resource.firstStep]].queue;
+    for (auto step = resource.firstStep; step <= resource.lastStep; ++step)
+    {
+      for (const auto& access : m_passes[m_order[step]].accesses)
+      {
+        if (access.resource == r && m_passes[m_order[step]].queue != queues[r])
+        {
+          isSingleQueue[r] = false;
+        }
+      }
+    }
+    transients.push_back(r);
+  }
+
+  // 大きいものから順に、使用期間の重ならないメモリへ詰める.
+  // キューをまたいで使うイメージは他と共有しない.
+  std::sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) { return reqs[a].size > reqs[b].size; });
+  auto isOverlapped = [&](uint32_t a, uint32_t b) {
+    return !(m_resources[a].lastStep < m_resources[b].firstStep || m_resources[b].lastStep < m_resources[a].firstStep);
+  };
+  std::vector<bool> isShareable;
+  for (auto r : transients)
+  {
+    auto slotIndex = uint32_t(m_slots.size());
+    for (uint32_t s = 0; s < uint32_t(m_slots.size()) && isSingleQueue[r]; ++s)
+    {
+      const auto& slot = m_slots[s];
+      if (!isShareable[s] || slot.queue != queues[r] || (slot.reqs.memoryTypeBits & reqs[r].memoryTypeBits) == 0)
+      {
+        continue;
+      }
+      auto isFree = std::none_of(slot.resources.begin(), slot.resources.end(), [&](uint32_t other) { return isOverlapped(r, other); });
+      if (isFree)
+      {
+        slotIndex = s;
+        break;
+      }
+    }
+    if (slotIndex == m_slots.size())
+    {
+      MemorySlot slot{};
+      slot.reqs = reqs[r];
+      slot.queue = queues[r];
+      m_slots.push_back(slot);
+      isShareable.push_back(isSingleQueue[r]);
+    }
+    auto& slot = m_slots[slotIndex];
+    slot.reqs.size = (std::max)(slot.reqs.size, reqs[r].size);
+    slot.reqs.alignment = (std::max)(slot.reqs.alignment, reqs[r].alignment);
+    slot.reqs.memoryTypeBits &= reqs[r].memoryTypeBits;
+    slot.resources.push_back(r);
+    m_resources[r].slot = slotIndex;
+    m_stats.unaliasedBytes += reqs[r].size;
+  }
+
+  for (auto& slot : m_slots)
+  {
+    auto memoryTypeIndex = m_allocator->FindMemoryTypeIndex(slot.reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    slot.allocation = m_allocator->Allocate(slot.reqs, memoryTypeIndex, DeviceMemoryAllocator::ResourceKind_Optimal, DeviceMemoryAllocator::Category_RenderTarget);
+    m_stats.transientBytes += slot.reqs.size;
+    for (auto r : slot.resources)
+    {
+      auto& resource = m_resources[r];
+      auto result = vkBindImageMemory(m_device, resource.image, slot.allocation.memory, slot.allocation.offset);
+      ThrowIfFailed(result, "vkBindImageMemory Failed.");
+
+      VkImageViewCreateInfo viewCI{
+        VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, nullptr, 0,
+        resource.image,
+        resource.desc.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D,
+        resource.desc.format,
+        book_util::DefaultComponentMapping(),
+        resource.range
+      };
+      result = vkCreateImageView(m_device, &viewCI, nullptr, &resource.view);
+      ThrowIfFailed(result, "vkCreateImageView Failed.");
+    }
+  }
+  m_stats.transientImages = uint32_t(transients.size());
+  m_stats.memorySlots = uint32_t(m_slots.size());
+}
+
+RenderGraph::Program RenderGraph::BuildProgram(std::vector<TrackedState>& entryStates, std::vector<TrackedState>& entrySlots, bool isSteady) const
+{
+  Program program{};
+  auto& states = entryStates;
+  auto& slots = entrySlots;
+  std::vector<bool> isTouched(m_resources.size(), false);
+  for (uint32_t step = 0; step < uint32_t(m_order.size()); ++step)
+  {
+    program.steps.push_back(Step{ m_order[step] });
+    const auto& pass = m_passes[m_order[step]];
+    for (const auto& access : pass.accesses)
+    {
+      const auto& resource = m_resources[access.resource];
+      auto& state = states[access.resource];
+      if (resource.isTransient && !isTouched[access.resource])
+      {
+        // 同じメモリを前に使ったイメージの後に続ける. 内容は引き継がない.
+        state = slots[resource.slot];
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+      }
+      isTouched[access.resource] = true;
+
+      const auto& info = UsageInfos[access.usage];
+      auto stages = info.stages;
+      auto accessMask = access.isWrite ? info.writeAccess : info.readAccess;
+      VkImageMemoryBarrier barrier{
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+        0, accessMask,
+        state.layout, info.layout,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        resource.image, resource.range
+      };
+      auto& before = program.steps[step].before;
+      auto isBarrierAdded = false;
+      auto isSynchronized = false;  // 以降の読み取りはこのバリアに続ける.
+      if (state.isUsed && state.queue != pass.queue)
+      {
+        // キュー間の実行順はセマフォで決まる. ファミリーが異なる場合はレイアウトの変更と所有権の移動を行う.
+        auto srcFamily = GetFamily(state.queue);
+        auto dstFamily = GetFamily(pass.queue);
+        if (srcFamily != dstFamily && state.layout != VK_IMAGE_LAYOUT_UNDEFINED)
+        {
+          barrier.srcQueueFamilyIndex = srcFamily;
+          barrier.dstQueueFamilyIndex = dstFamily;
+          // 解放は前に使ったキューで行う. 前のフレームからの受け渡しはフレームの終わりに、
+          // 最初のフレームの取り込んだイメージの分は RecordImportReleases で記録する.
+          auto& batch = (state.lastStep != InvalidStep) ? program.steps[state.lastStep].after
+            : isSteady ? program.frameEnd[state.queue] : program.imports[state.queue];
+          auto release = barrier;
+          release.srcAccessMask = state.writeAccess;
+          release.dstAccessMask = 0;
+          auto srcStages = state.writeStages | state.readStages;
+          AddBarrier(batch.barriers, batch.srcStages, batch.dstStages,
+            srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, release);
+          AddBarrier(before.barriers, before.srcStages, before.dstStages, stages, stages, barrier);
+          isBarrierAdded = true;
+        }
+        else if (srcFamily == dstFamily)
+        {
+          // 同じファミリーでは所有権の移動が無く、同じキューを共有する場合もあるため、
+          // 前の使い方からのメモリの依存を置く.
+          auto srcStages = state.writeStages | state.readStages;
+          barrier.srcAccessMask = state.writeAccess;
+          if (srcStages != 0 || state.layout != info.layout)
+          {
+            AddBarrier(before.barriers, before.srcStages, before.dstStages,
+              srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, stages, barrier);
+            isBarrierAdded = true;
+          }
+        }
+        else if (state.layout != info.layout)
+        {
+          // 内容の無いイメージはファミリーをまたいでも所有権の移動は不要.
+          AddBarrier(before.barriers, before.srcStages, before.dstStages, stages, stages, barrier);
+          isBarrierAdded = true;
+        }
+        isSynchronized = true;
+      }
+      else if (access.isWrite || state.layout != info.layout)
+      {
+        // 書き込みかレイアウトの変更の前は、それまでの読み書きの完了を待つ.
+        VkPipelineStageFlags srcStages;
+        if (state.visibleStages != 0)
+        {
+          // 前の書き込みは読み取り側へのバリアで待っているので、読み取りの完了だけ待てばよい.
+          srcStages = state.readStages;
+          barrier.srcAccessMask = 0;
+        }
+        else
+        {
+          srcStages = state.writeStages | state.readStages;
+          barrier.srcAccessMask = state.writeAccess;
+        }
+        if (srcStages != 0 || state.layout != info.layout)
+        {
+          AddBarrier(before.barriers, before.srcStages, before.dstStages,
+            srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, stages, barrier);
+          isBarrierAdded = true;
+        }
+        isSynchronized = state.layout != info.layout;
+      }
+      else if (state.writeStages != 0 &&
+        ((state.visibleStages & stages) != stages || (state.visibleAccess & accessMask) != accessMask))
+      {
+        // 同じレイアウトでの読み取りは、前の書き込みがまだ見えていないステージだけ待つ.
+        barrier.srcAccessMask = state.writeAccess;
+        AddBarrier(before.barriers, before.srcStages, before.dstStages, state.writeStages, stages, barrier);
+        isBarrierAdded = true;
+      }
+
+      if (access.isWrite)
+      {
+        state.writeStages = stages;
+        state.writeAccess = accessMask & WriteAccessMask;
+        state.readStages = 0;
+        state.visibleStages = 0;
+        state.visibleAccess = 0;
+      }
+      else if (isSynchronized)
+      {
+        state.writeStages = stages;
+        state.writeAccess = 0;
+        state.readStages = stages;
+        state.visibleStages = stages;
+        state.visibleAccess = accessMask;
+      }
+      else
+      {
+        state.readStages |= stages;
+        if (isBarrierAdded)
+        {
+          state.visibleStages |= stages;
+          state.visibleAccess |= accessMask;
+        }
+      }
+      state.layout = info.layout;
+      state.queue = pass.queue;
+      state.lastStep = step;
+      state.isUsed = true;
+      if (resource.isTransient)
+      {
+        slots[resource.slot] = state;
+      }
+    }
+  }
+
+  // 終わりの状態が次のフレームの始まりの状態になる.
+  for (auto& state : states)
+  {
+    state.lastStep = InvalidStep;
+  }
+  for (auto& slot : slots)
+  {
+    slot.lastStep = InvalidStep;
+  }
+  return program;
+}
+
+void RenderGraph::Execute(VkCommandBuffer graphicsCommand, VkCommandBuffer computeCommand)
+{
+  if (!m_isCompiled)
+  {
+    throw book_util::VulkanException("RenderGraph: not compiled.");
+  }
+  const auto& program = m_isExecuted ? m_steady : m_firstFrame;
+  VkCommandBuffer commands[Queue_Count] = { graphicsCommand, computeCommand };
+  for (const auto& step : program.steps)
+  {
+    const auto& pass = m_passes[step.pass];
+    auto command = commands[pass.queue];
+    RecordBatch(command, step.before);
+    pass.func(command);
+    RecordBatch(command, step.after);
+  }
+  for (int queue = 0; queue < Queue_Count; ++queue)
+  {
+    RecordBatch(commands[queue], program.frameEnd[queue]);
+  }
+  m_isExecuted = true;
+}
+
+void RenderGraph::RecordImportReleases(VkCommandBuffer command, Queue queue) const
+{
+  if (!m_isCompiled)
+  {
+    throw book_util::VulkanException("RenderGraph: not compiled.");
+  }
+  RecordBatch(command, m_firstFrame.imports[queue]);
+}
+
+void RenderGraph::RecordBatch(VkCommandBuffer command, const Batch& batch) const
+{
+  if (batch.barriers.empty())
+  {
+    return;
+  }
+  vkCmdPipelineBarrier(command,
+    batch.srcStages, batch.dstStages, 0,
+    0, nullptr, // memoryBarrier
+    0, nullptr, // bufferMemoryBarrier
+    uint32_t(batch.barriers.size()), batch.barriers.data());
+}
+
+void RenderGraph::Reset()
+{
+  for (auto& resource : m_resources)
+  {
+    if (resource.isTransient)
+    {
+      vkDestroyImageView(m_device, resource.view, nullptr);
+      vkDestroyImage(m_device, resource.image, nullptr);
+    }
+  }
+  for (auto& slot : m_slots)
+  {
+    m_allocator->Free(slot.allocation);
+  }
+  m_passes.clear();
+  m_resources.clear();
+  m_slots.clear();
+  m_order.clear();
+  m_firstFrame = Program{};
+  m_steady = Program{};
+  m_finalStates.clear();
+  m_isCompiled = false;
+  m_isExecuted = false;
+  m_stats = Statistics{};
+}
+
+RenderGraph::ImageState RenderGraph::GetImageState(ResourceHandle resource) const
+{
+  if (!m_isExecuted || !m_finalStates[resource.index].isUsed)
+  {
+    return m_resources[resource.index].initialState;
+  }
+  const auto& state = m_finalStates[resource.index];
+  return ImageState{ state.layout, state.writeStages | state.readStages, state.writeAccess, state.queue };
+}
+
+std::vector<std::string> RenderGraph::GetPassOrder() const
+{
+  std::vector<std::string> names;
+  for (auto pass : m_order)
+  {
+    names.push_back(m_passes[pass].name);
+  }
+  return names;
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "DeviceMemoryAllocator.h"
+
+// フレーム内のパスと、パスが読み書きするイメージを宣言して組み立てる描画グラフ.
+// Compile で以下を決め、毎フレームの Execute はその結果に沿ってバリアを発行しパスを呼ぶだけにする.
+// - 出力(SetSideEffect したパス)に寄与しないパスを除外する.
+// - 書き込むパスを読むパスより前に並べる. 依存の無いパス同士は宣言順.
+// - バリアはイメージの使い方からステージ/アクセス/レイアウトを求め、読み取りの連続など不要なものは省く.
+//   1 パスの前(後)のバリアは 1 回の vkCmdPipelineBarrier にまとめる.
+// - 一時イメージ(CreateImage)は使用期間が重ならないもの同士で同じメモリを共有する.
+// 最初のフレームは取り込んだ初期状態から、以降はフレームの終わりの状態から遷移するバリアを使う.
+class RenderGraph
+{
+public:
+  enum Queue
+  {
+    Queue_Graphics,
+    Queue_Compute,
+    Queue_Count,
+  };
+  // パスでのイメージの使い方.
+  enum Usage
+  {
+    Usage_ColorAttachment,
+    Usage_DepthAttachment,
+    Usage_SampledFragment,  // フラグメントシェーダーでのテクスチャ参照.
+    Usage_StorageCompute,   // コンピュートシェーダーでのストレージイメージ.
+    Usage_Count,
+  };
+  struct ResourceHandle
+  {
+    uint32_t index;
+  };
+  struct ImageDesc
+  {
+    VkImageCreateFlags flags;
+    VkFormat format;
+    VkExtent2D extent;
+    uint32_t arrayLayers;
+    VkImageUsageFlags usage;
+  };
+  // イメージを最後に使った状態. キューをまたぐ受け渡しのため、使ったキューも持つ.
+  struct ImageState
+  {
+    VkImageLayout layout;
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    Queue queue;
+  };
+  struct Statistics
+  {
+    uint32_t declaredPasses;
+    uint32_t culledPasses;
+    uint32_t barrierBatches;      // 1 フレームの vkCmdPipelineBarrier の呼び出し数(2 フレーム目以降).
+    uint32_t imageBarriers;
+    uint32_t transientImages;
+    uint32_t memorySlots;         // 一時イメージに確保したメモリの数.
+    VkDeviceSize transientBytes;  // 共有した結果の確保量.
+    VkDeviceSize unaliasedBytes;  // 共有しない場合の確保量.
+  };
+  using ExecuteFunc = std::function<void(VkCommandBuffer)>;
+
+  RenderGraph(const char* name, VkDevice device, DeviceMemoryAllocator* allocator, uint32_t graphicsFamily, uint32_t computeFamily);
+  ~RenderGraph();
+
+  // 外部で管理するイメージを使う. initialState はイメージの実際の状態(未使用なら UNDEFINED).
+  // initialState.queue が最初に使うキューとファミリーが異なる場合、その解放は RecordImportReleases で記録する.
+  ResourceHandle ImportImage(const char* name, VkImage image, const VkImageSubresourceRange& range, const ImageState& initialState);
+  // グラフが確保する一時イメージ. 内容はフレームをまたいで保持されない.
+  ResourceHandle CreateImage(const char* name, const ImageDesc& desc);
+
+  // パスの処理は Execute の中で、パスのキューのコマンドバッファを渡して呼ばれる.
+  uint32_t AddPass(const char* name, Queue queue, ExecuteFunc func);
+  void Read(uint32_t pass, ResourceHandle resource, Usage usage);
+  void Write(uint32_t pass, ResourceHandle resource, Usage usage);
+  // スワップチェインへの描画など、グラフの外に結果を残すパス. 除外しない.
+  void SetSideEffect(uint32_t pass);
+
+  void Compile();
+  // 取り込んだイメージを初期状態のキューから解放するバリアを記録する(Compile の後).
+  // queue で実行され、最初の Execute の受け取る側より前に完了するコマンドバッファに記録すること.
+  void RecordImportReleases(VkCommandBuffer command, Queue queue) const;
+  // 各キューのパスとバリアを記録する. キューをまたぐ場合、呼び出し側は受け取る側のパスのステージで
+  // セマフォを待つこと. 同じファミリーのキュー間でもバリアでメモリの依存を置くが、実行順はセマフォで決めること.
+  // パスの無いキューのコマンドバッファは VK_NULL_HANDLE でよい.
+  void Execute(VkCommandBuffer graphicsCommand, VkCommandBuffer computeCommand = VK_NULL_HANDLE);
+  // 宣言と一時イメージを破棄する. GPU が使い終えてから呼ぶこと.
+  void Reset();
+  bool IsCompiled() const { return m_isCompiled; }
+
+  VkImage GetImage(ResourceHandle resource) const { return m_resources[resource.index].image; }
+  VkImageView GetImageView(ResourceHandle resource) const { return m_resources[resource.index].view; }
+  // 直近の Execute の後の状態. 作り直したグラフへ取り込み直すときに使う.
+  ImageState GetImageState(ResourceHandle resource) const;
+
+  const std::string& GetName() const { return m_name; }
+  // 実行順に並べたパス名(除外したものは含まない).
+  std::vector<std::string> GetPassOrder() const;
+  const Statistics& GetStatistics() const { return m_stats; }
+
+private:
+  struct Access
+  {
+    uint32_t resource;
+    Usage usage;
+    bool isWrite;
+  };
+  struct Pass
+  {
+    std::string name;
+    Queue queue;
+    ExecuteFunc func;
+    std::vector<Access> accesses;
+    bool hasSideEffect;
+  };
+  struct Resource
+  {
+    std::string name;
+    bool isTransient;
+    ImageDesc desc;
+    VkImage image;
+    VkImageView view;
+    VkImageSubresourceRange range;
+    ImageState initialState;
+    uint32_t slot;          // 一時イメージが使うメモリ.
+    uint32_t firstStep;     // 実行順での使用期間.
+    uint32_t lastStep;
+  };
+  // バリアを決めるためのイメージの状態.
+  struct TrackedState
+  {
+    VkImageLayout layout;
+    Queue queue;
+    VkPipelineStageFlags writeStages;   // 最後の書き込み(レイアウト変更を含む).
+    VkAccessFlags writeAccess;
+    VkPipelineStageFlags readStages;    // 最後の書き込み以降に読んだステージ.
+    VkPipelineStageFlags visibleStages; // 最後の書き込みをバリアで見えるようにしたステージ.
+    VkAccessFlags visibleAccess;
+    uint32_t lastStep;                  // 前のフレームからの状態は InvalidStep.
+    bool isUsed;
+  };
+  struct Batch
+  {
+    VkPipelineStageFlags srcStages;
+    VkPipelineStageFlags dstStages;
+    std::vector<VkImageMemoryBarrier> barriers;
+  };
+  struct Step
+  {
+    uint32_t pass;
+    Batch before;
+    Batch after;    // 他のキューへの解放.
+  };
+  struct Program
+  {
+    std::vector<Step> steps;
+    Batch frameEnd[Queue_Count];  // 次のフレームで他のキューが使うイメージの解放.
+    Batch imports[Queue_Count];   // 最初のフレームの前の、取り込んだイメージの解放.
+  };
+  struct MemorySlot
+  {
+    DeviceMemoryAllocator::Allocation allocation;
+    VkMemoryRequirements reqs;
+    Queue queue;
+    std::vector<uint32_t> resources;
+  };
+  static const uint32_t InvalidStep = ~0u;
+
+  void CullPasses(std::vector<bool>& isAlive) const;
+  std::vector<uint32_t> SortPasses(const std::vector<bool>& isAlive) const;
+  void CreateTransientImages();
+  // entryStates/entrySlots から 1 フレーム分のバリアを求める. 終わりの状態で entry* を更新する.
+  Program BuildProgram(std::vector<TrackedState>& entryStates, std::vector<TrackedState>& entrySlots, bool isSteady) const;
+  void RecordBatch(VkCommandBuffer command, const Batch& batch) const;
+  uint32_t GetFamily(Queue queue) const { return m_families[queue]; }
+
+  std::string m_name;
+  VkDevice m_device;
+  DeviceMemoryAllocator* m_allocator;
+  uint32_t m_families[Queue_Count];
+
+  std::vector<Pass> m_passes;
+  std::vector<Resource> m_resources;
+  std::vector<MemorySlot> m_slots;
+  std::vector<uint32_t> m_order;    // 実行するパスの番号.
+
+  Program m_firstFrame;
+  Program m_steady;
+  std::vector<TrackedState> m_finalStates;
+  bool m_isCompiled;
+  bool m_isExecuted;
+  Statistics m_stats;
+};
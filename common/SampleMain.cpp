@@ -0,0 +1,187 @@
+#include "SampleMain.h"
+#include "VulkanBookUtil.h"
+
+namespace
+{
+  void KeyboardInputCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+  {
+    auto pApp = book_util::GetApplication<VulkanAppBase>(window);
+    if (pApp == nullptr)
+    {
+      return;
+    }
+    switch (action)
+    {
+    case GLFW_PRESS:
+      if (key == GLFW_KEY_ESCAPE)
+      {
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+      }
+      if (key == GLFW_KEY_ENTER && mods == GLFW_MOD_ALT)
+      {
+        pApp->SwitchFullscreen(window);
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+  void MouseMoveCallback(GLFWwindow* window, double x, double y)
+  {
+    static int lastPosX, lastPosY;
+    auto pApp = book_util::GetApplication<VulkanAppBase>(window);
+    if (pApp == nullptr)
+    {
+      return;
+    }
+    int dx = int(x) - lastPosX;
+    int dy = int(y) - lastPosY;
+    pApp->OnMouseMove(dx, dy);
+    lastPosX = int(x);
+    lastPosY = int(y);
+  }
+  void MouseInputCallback(GLFWwindow* window, int button, int action, int mods)
+  {
+    auto pApp = book_util::GetApplication<VulkanAppBase>(window);
+    if (pApp == nullptr)
+    {
+      return;
+    }
+    if (action == GLFW_PRESS)
+    {
+      pApp->OnMouseButtonDown(button);
+    }
+    if (action == GLFW_RELEASE)
+    {
+      pApp->OnMouseButtonUp(button);
+    }
+  }
+  void MouseWheelCallback(GLFWwindow* window, double xoffset, double yoffset)
+  {
+    auto pApp = book_util::GetApplication<VulkanAppBase>(window);
+    if (pApp == nullptr)
+    {
+      return;
+    }
+  }
+  void WindowResizeCallback(GLFWwindow* window, int width, int height)
+  {
+    auto pApp = book_util::GetApplication<VulkanAppBase>(window);
+    if (pApp == nullptr)
+    {
+      return;
+    }
+    pApp->OnSizeChanged(width, height);
+  }
+
+  // 記録/再生/トレースの開始. 再生時は記録されているフレーム数を返す.
+  uint32_t StartCaptures(VulkanAppBase& app, const book_util::HeadlessOptions& options, const char* appTitle)
+  {
+    uint32_t replayFrames = 0;
+    if (!options.recordFile.empty())
+    {
+      app.StartRecording(options.recordFile.c_str(), appTitle);
+    }
+    if (!options.replayFile.empty())
+    {
+      replayFrames = app.StartReplay(options.replayFile.c_str(), appTitle);
+    }
+    if (options.traceFrames > 0)
+    {
+      app.StartTraceCapture(options.traceFile, options.traceFrames);
+    }
+    return replayFrames;
+  }
+
+  // ウィンドウを作らずに指定フレーム数だけ描画する.
+  int RunHeadless(VulkanAppBase& app, const book_util::HeadlessOptions& options, const char* appTitle, int width, int height)
+  {
+    int exitCode = 0;
+    app.SetPreferredDevice(options.device);
+    try
+    {
+      app.InitializeHeadless(width, height, VK_FORMAT_B8G8R8A8_UNORM);
+      auto frameCount = options.frameCount;
+      auto replayFrames = StartCaptures(app, options, appTitle);
+      if (!options.replayFile.empty())
+      {
+        frameCount = replayFrames;
+      }
+      if (options.isRegression)
+      {
+        auto failures = app.RunRegression({
+          appTitle, options.referenceDir, options.warmupFrames, options.frameCount,
+          options.minPsnr, options.maxSlowdownPercent, options.updateReference });
+        exitCode = failures > 0 ? 2 : 0;
+      }
+      else if (options.isBenchmark)
+      {
+        app.RunBenchmark({ appTitle, options.warmupFrames, options.frameCount, options.reportFile });
+      }
+      else
+      {
+        app.RunHeadless(frameCount, options.readbackFile.empty() ? nullptr : options.readbackFile.c_str());
+      }
+      app.Terminate();
+    }
+    catch (const std::runtime_error& e)
+    {
+      book_util::WriteLog(e.what(), stderr);
+      book_util::WriteLog("\n", stderr);
+      return 1;
+    }
+    return exitCode;
+  }
+
+  int RunWindow(VulkanAppBase& app, const book_util::HeadlessOptions& options, const char* appTitle, int width, int height)
+  {
+    int exitCode = 0;
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+    auto window = glfwCreateWindow(width, height, appTitle, nullptr, nullptr);
+
+    // 各種コールバック登録.
+    glfwSetKeyCallback(window, KeyboardInputCallback);
+    glfwSetMouseButtonCallback(window, MouseInputCallback);
+    glfwSetCursorPosCallback(window, MouseMoveCallback);
+    glfwSetScrollCallback(window, MouseWheelCallback);
+    glfwSetWindowSizeCallback(window, WindowResizeCallback);
+
+    glfwSetWindowUserPointer(window, &app);
+    app.SetPreferredDevice(options.device);
+
+    try
+    {
+      VkFormat surfaceFormat = VK_FORMAT_B8G8R8A8_UNORM;
+      app.Initialize(window, surfaceFormat, false);
+      StartCaptures(app, options, appTitle);
+      while (glfwWindowShouldClose(window) == GLFW_FALSE)
+      {
+        glfwPollEvents();
+        app.Render();
+      }
+      app.Terminate();
+    }
+    catch (const std::runtime_error& e)
+    {
+      book_util::WriteLog(e.what(), stderr);
+      book_util::WriteLog("\n", stderr);
+      exitCode = 1;
+    }
+    glfwTerminate();
+    return exitCode;
+  }
+}
+
+int RunSample(VulkanAppBase& app, const std::vector<std::string>& args, const char* appTitle, int width, int height)
+{
+  auto options = book_util::ParseHeadlessOptions(args);
+  if (options.enabled)
+  {
+    return RunHeadless(app, options, appTitle, width, height);
+  }
+  return RunWindow(app, options, appTitle, width, height);
+}
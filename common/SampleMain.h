@@ -0,0 +1,9 @@
+#pragma once
+#include "VulkanAppBase.h"
+#include <string>
+#include <vector>
+
+// サンプル共通の起動処理.
+// args はプログラム名を除いたコマンドライン引数. -headless 等の指定があればウィンドウを作らずに実行する.
+// 戻り値はプロセスの終了コード. 0: 成功, 1: 例外で中断, 2: リグレッションテストで基準を満たさなかった.
+int RunSample(VulkanAppBase& app, const std::vector<std::string>& args, const char* appTitle, int width, int height);
@@ -0,0 +1,430 @@
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "ShaderLibrary.h"
+#include "VulkanBookUtil.h"
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+
+namespace
+{
+  // 読み込み中だけファイルをメモリマップしておく.
+#if defined(_WIN32)
+  class MappedFile
+  {
+  public:
+    explicit MappedFile(const char* fileName)
+      : m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr), m_data(nullptr), m_size(0)
+    {
+      m_file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (m_file == INVALID_HANDLE_VALUE)
+      {
+        throw book_util::VulkanException(std::string("Shader file not found: ") + fileName);
+      }
+      LARGE_INTEGER size;
+      GetFileSizeEx(m_file, &size);
+      m_size = size_t(size.QuadPart);
+      if (m_size == 0)
+      {
+        return;
+      }
+      m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (m_mapping != nullptr)
+      {
+        m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+      }
+      if (m_data == nullptr)
+      {
+        Close();
+        throw book_util::VulkanException(std::string("Shader file mapping failed: ") + fileName);
+      }
+    }
+    ~MappedFile() { Close(); }
+
+    // マップしたビューはページ境界から始まるため、uint32_t として参照してよい.
+    const uint32_t* GetCode() const { return static_cast<const uint32_t*>(m_data); }
+    size_t GetSize() const { return m_size; }
+
+  private:
+    void Close()
+    {
+      if (m_data) { UnmapViewOfFile(m_data); }
+      if (m_mapping) { CloseHandle(m_mapping); }
+      if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+      m_data = nullptr;
+      m_mapping = nullptr;
+      m_file = INVALID_HANDLE_VALUE;
+    }
+    HANDLE m_file;
+    HANDLE m_mapping;
+    const void* m_data;
+    size_t m_size;
+  };
+#else
+  class MappedFile
+  {
+  public:
+    explicit MappedFile(const char* fileName)
+      : m_file(-1), m_data(nullptr), m_size(0)
+    {
+      m_file = open(fileName, O_RDONLY);
+      if (m_file < 0)
+      {
+        throw book_util::VulkanException(std::string("Shader file not found: ") + fileName);
+      }
+      struct stat st;
+      fstat(m_file, &st);
+      m_size = size_t(st.st_size);
+      if (m_size == 0)
+      {
+        return;
+      }
+      auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+      if (data == MAP_FAILED)
+      {
+        Close();
+        throw book_util::VulkanException(std::string("Shader file mapping failed: ") + fileName);
+      }
+      m_data = data;
+    }
+    ~MappedFile() { Close(); }
+
+    const uint32_t* GetCode() const { return static_cast<const uint32_t*>(m_data); }
+    size_t GetSize() const { return m_size; }
+
+  private:
+    void Close()
+    {
+      if (m_data) { munmap(const_cast<void*>(m_data), m_size); }
+      if (m_file >= 0) { close(m_file); }
+      m_data = nullptr;
+      m_file = -1;
+    }
+    int m_file;
+    const void* m_data;
+    size_t m_size;
+  };
+#endif
+
+  // FNV-1a (64bit).
+  uint64_t HashCode(const void* data, size_t size)
+  {
+    auto bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // 動的オフセット版もシェーダー側からは同じ種類に見える.
+  bool IsCompatibleDescriptorType(VkDescriptorType shaderType, VkDescriptorType layoutType)
+  {
+    if (shaderType == layoutType)
+    {
+      return true;
+    }
+    if (shaderType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+    {
+      return layoutType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    }
+    if (shaderType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+    {
+      return layoutType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    }
+    return false;
+  }
+}
+
+ShaderLibrary::ShaderLibrary(VkDevice device) : m_device(device), m_stats()
+{
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+  Release();
+}
+
+VkPipelineShaderStageCreateInfo ShaderLibrary::Load(const char* fileName, VkShaderStageFlagBits stage)
+{
+  auto begin = std::chrono::high_resolution_clock::now();
+  m_stats.loadRequests++;
+
+  VkShaderModule module = VK_NULL_HANDLE;
+  auto itFile = m_fileHashes.find(fileName);
+  if (itFile != m_fileHashes.end())
+  {
+    module = m_modules[itFile->second].module;
+  }
+  else
+  {
+    MappedFile file(fileName);
+    m_stats.filesMapped++;
+
+    auto hash = HashCode(file.GetCode(), file.GetSize());
+    auto it = m_modules.find(hash);
+    if (it == m_modules.end())
+    {
+      VkShaderModuleCreateInfo ci{
+        VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        nullptr, 0,
+        file.GetSize(),
+        file.GetCode(),
+      };
+      Module entry;
+      auto result = vkCreateShaderModule(m_device, &ci, nullptr, &entry.module);
+      ThrowIfFailed(result, "vkCreateShaderModule Failed.");
+      entry.bindings = Reflect(file.GetCode(), file.GetSize() / sizeof(uint32_t));
+      it = m_modules.emplace(hash, std::move(entry)).first;
+      m_stats.modulesCreated++;
+    }
+    m_fileHashes[fileName] = hash;
+    module = it->second.module;
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+  m_stats.loadMs += std::chrono::duration<double, std::milli>(end - begin).count();
+
+  VkPipelineShaderStageCreateInfo shaderStageCI{
+    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+    nullptr, 0,
+    stage,
+    module,
+    "main",
+    nullptr
+  };
+  return shaderStageCI;
+}
+
+const std::vector<ShaderLibrary::DescriptorBinding>& ShaderLibrary::GetBindings(VkShaderModule module) const
+{
+  static const std::vector<DescriptorBinding> empty;
+  for (const auto& v : m_modules)
+  {
+    if (v.second.module == module)
+    {
+      return v.second.bindings;
+    }
+  }
+  return empty;
+}
+
+bool ShaderLibrary::ValidateLayout(
+  const VkPipelineShaderStageCreateInfo* stages, uint32_t stageCount,
+  uint32_t set, const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingCount) const
+{
+  std::stringstream ss;
+  for (uint32_t i = 0; i < stageCount; ++i)
+  {
+    for (const auto& used : GetBindings(stages[i].module))
+    {
+      if (used.set != set)
+      {
+        continue;
+      }
+      auto layout = std::find_if(bindings, bindings + bindingCount,
+        [&](const VkDescriptorSetLayoutBinding& b) { return b.binding == used.binding; });
+      if (layout == bindings + bindingCount)
+      {
+        ss << "[ShaderLibrary] set " << set << " binding " << used.binding << ": not in layout." << std::endl;
+      }
+      else if (!IsCompatibleDescriptorType(used.descriptorType, layout->descriptorType))
+      {
+        ss << "[ShaderLibrary] set " << set << " binding " << used.binding
+          << ": type mismatch (shader " << used.descriptorType << ", layout " << layout->descriptorType << ")." << std::endl;
+      }
+      else if ((layout->stageFlags & stages[i].stage) == 0)
+      {
+        ss << "[ShaderLibrary] set " << set << " binding " << used.binding << ": stage " << stages[i].stage << " is not visible." << std::endl;
+      }
+      else if (layout->descriptorCount < used.descriptorCount)
+      {
+        ss << "[ShaderLibrary] set " << set << " binding " << used.binding << ": descriptorCount too small." << std::endl;
+      }
+    }
+  }
+  auto message = ss.str();
+  if (!message.empty())
+  {
+    book_util::WriteLog(message.c_str());
+    return false;
+  }
+  return true;
+}
+
+void ShaderLibrary::Release()
+{
+  for (auto& v : m_modules)
+  {
+    vkDestroyShaderModule(m_device, v.second.module, nullptr);
+  }
+  m_modules.clear();
+  m_fileHashes.clear();
+}
+
+std::vector<ShaderLibrary::DescriptorBinding> ShaderLibrary::Reflect(const uint32_t* code, size_t wordCount)
+{
+  // 必要な命令だけを拾う. 番号は SPIR-V の仕様による.
+  enum
+  {
+    OpTypeImage = 25, OpTypeSampler = 26, OpTypeSampledImage = 27,
+    OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30,
+    OpTypePointer = 32, OpConstant = 43, OpVariable = 59, OpDecorate = 71,
+  };
+  enum { DecorationBlock = 2, DecorationBufferBlock = 3, DecorationBinding = 33, DecorationDescriptorSet = 34 };
+  enum { StorageClassUniformConstant = 0, StorageClassUniform = 2, StorageClassStorageBuffer = 12 };
+  enum { DimBuffer = 5, DimSubpassData = 6 };
+
+  struct TypeInfo
+  {
+    uint32_t opcode;
+    uint32_t operand[3];
+  };
+  std::unordered_map<uint32_t, TypeInfo> types;
+  std::unordered_map<uint32_t, uint32_t> constants;
+  std::unordered_map<uint32_t, uint32_t> sets, bindingNumbers, blockKinds;
+  std::vector<std::pair<uint32_t, uint32_t>> variables; // (結果 ID, ポインタ型 ID).
+
+  const uint32_t HeaderWords = 5;
+  if (wordCount < HeaderWords || code[0] != 0x07230203)
+  {
+    return {};
+  }
+  for (size_t pos = HeaderWords; pos < wordCount;)
+  {
+    auto opcode = code[pos] & 0xFFFF;
+    auto count = code[pos] >> 16;
+    if (count == 0 || pos + count > wordCount)
+    {
+      break;
+    }
+    auto op = code + pos;
+    switch (opcode)
+    {
+    case OpDecorate:
+      if (count >= 3)
+      {
+        if (op[2] == DecorationDescriptorSet && count >= 4) { sets[op[1]] = op[3]; }
+        if (op[2] == DecorationBinding && count >= 4) { bindingNumbers[op[1]] = op[3]; }
+        if (op[2] == DecorationBlock || op[2] == DecorationBufferBlock) { blockKinds[op[1]] = op[2]; }
+      }
+      break;
+    case OpTypeImage:
+      // 結果 ID, サンプル型, Dim, Depth, Arrayed, MS, Sampled.
+      if (count >= 9) { types[op[1]] = TypeInfo{ opcode, { op[3], op[8], 0 } }; }
+      break;
+    case OpTypeSampler:
+    case OpTypeSampledImage:
+    case OpTypeStruct:
+      types[op[1]] = TypeInfo{ opcode, { 0, 0, 0 } };
+      break;
+    case OpTypeArray:
+      if (count >= 4) { types[op[1]] = TypeInfo{ opcode, { op[2], op[3], 0 } }; }
+      break;
+    case OpTypeRuntimeArray:
+      if (count >= 3) { types[op[1]] = TypeInfo{ opcode, { op[2], 0, 0 } }; }
+      break;
+    case OpTypePointer:
+      if (count >= 4) { types[op[1]] = TypeInfo{ opcode, { op[2], op[3], 0 } }; }
+      break;
+    case OpConstant:
+      if (count >= 4) { constants[op[2]] = op[3]; }
+      break;
+    case OpVariable:
+      if (count >= 4) { variables.emplace_back(op[2], op[1]); }
+      break;
+    }
+    pos += count;
+  }
+
+  std::vector<DescriptorBinding> result;
+  for (const auto& v : variables)
+  {
+    auto itBinding = bindingNumbers.find(v.first);
+    auto itPointer = types.find(v.second);
+    if (itBinding == bindingNumbers.end() || itPointer == types.end() || itPointer->second.opcode != OpTypePointer)
+    {
+      continue;
+    }
+    auto storageClass = itPointer->second.operand[0];
+    auto typeId = itPointer->second.operand[1];
+
+    DescriptorBinding binding{};
+    binding.set = sets.count(v.first) ? sets[v.first] : 0;
+    binding.binding = itBinding->second;
+    binding.descriptorCount = 1;
+
+    // 配列の場合は要素の型で判定する.
+    auto it = types.find(typeId);
+    if (it != types.end() && it->second.opcode == OpTypeArray)
+    {
+      binding.descriptorCount = constants.count(it->second.operand[1]) ? constants[it->second.operand[1]] : 1;
+      typeId = it->second.operand[0];
+      it = types.find(typeId);
+    }
+    else if (it != types.end() && it->second.opcode == OpTypeRuntimeArray)
+    {
+      binding.descriptorCount = 0;
+      typeId = it->second.operand[0];
+      it = types.find(typeId);
+    }
+    if (it == types.end())
+    {
+      continue;
+    }
+
+    const auto& type = it->second;
+    switch (type.opcode)
+    {
+    case OpTypeSampledImage:
+      binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+      break;
+    case OpTypeSampler:
+      binding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+      break;
+    case OpTypeImage:
+      if (type.operand[0] == DimSubpassData)
+      {
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+      }
+      else if (type.operand[0] == DimBuffer)
+      {
+        binding.descriptorType = type.operand[1] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+      }
+      else
+      {
+        binding.descriptorType = type.operand[1] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+      }
+      break;
+    case OpTypeStruct:
+      if (storageClass == StorageClassStorageBuffer ||
+        (storageClass == StorageClassUniform && blockKinds[typeId] == DecorationBufferBlock))
+      {
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      }
+      else
+      {
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+      }
+      break;
+    default:
+      continue;
+    }
+    result.push_back(binding);
+  }
+  std::sort(result.begin(), result.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+    return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+  });
+  return result;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// シェーダーモジュールの管理.
+// SPIR-V ファイルはメモリマップして読み込み、内容のハッシュが同じものは 1 つのモジュールを共有する.
+// モジュールは Release を呼ぶまで保持するので、パイプライン生成ごとに破棄する必要はない.
+class ShaderLibrary
+{
+public:
+  // SPIR-V から取り出したディスクリプタの情報.
+  struct DescriptorBinding
+  {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorType descriptorType;
+    uint32_t descriptorCount;
+  };
+
+  struct Statistics
+  {
+    uint32_t loadRequests;    // Load の呼び出し数.
+    uint32_t filesMapped;     // 実際に読み込んだファイル数.
+    uint32_t modulesCreated;  // vkCreateShaderModule の呼び出し数.
+    double loadMs;            // 読み込みとモジュール生成にかかった時間の合計.
+  };
+
+  explicit ShaderLibrary(VkDevice device);
+  ~ShaderLibrary();
+
+  // ファイル名で既に読み込み済みであれば、ファイルを開かずにそのモジュールを返す.
+  VkPipelineShaderStageCreateInfo Load(const char* fileName, VkShaderStageFlagBits stage);
+
+  // module のディスクリプタバインディング一覧. このライブラリで作成したモジュールのみ対象.
+  const std::vector<DescriptorBinding>& GetBindings(VkShaderModule module) const;
+
+  // シェーダーが参照するバインディングがレイアウトに含まれるか(種類とステージを含めて)確認する.
+  // 不一致はデバッグ出力へ書き出し、false を返す.
+  bool ValidateLayout(
+    const VkPipelineShaderStageCreateInfo* stages, uint32_t stageCount,
+    uint32_t set, const VkDescriptorSetLayoutBinding* bindings, uint32_t bindingCount) const;
+
+  // 保持しているモジュールを全て破棄する. パイプライン生成が一通り終わった後に呼ぶ.
+  void Release();
+
+  const Statistics& GetStatistics() const { return m_stats; }
+  void ResetStatistics() { m_stats = Statistics{}; }
+
+  static std::vector<DescriptorBinding> Reflect(const uint32_t* code, size_t wordCount);
+
+private:
+  struct Module
+  {
+    VkShaderModule module;
+    std::vector<DescriptorBinding> bindings;
+  };
+
+  VkDevice m_device;
+  std::unordered_map<uint64_t, Module> m_modules;           // 内容のハッシュ -> モジュール.
+  std::unordered_map<std::string, uint64_t> m_fileHashes;   // ファイル名 -> 内容のハッシュ.
+  Statistics m_stats;
+};
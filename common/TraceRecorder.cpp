@@ -0,0 +1,145 @@
+#include "TraceRecorder.h"
+
+#include <fstream>
+
+// 1 フレームあたりの区間数の目安. 記録中の再確保を減らすために使う.
+static const size_t ExpectedEventsPerFrame = 16;
+
+static void WriteEscaped(std::ofstream& outfile, const std::string& text)
+{
+  for (auto c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      outfile << '\\';
+    }
+    outfile << c;
+  }
+}
+
+TraceRecorder::TraceRecorder()
+  : m_calibration(), m_calibrationOffsetUs(0.0), m_capturingFrames(0), m_drainingFrames(0), m_latencyFrames(0), m_frameIndex(0)
+{
+}
+
+void TraceRecorder::Start(const char* fileName, uint32_t frameCount, uint32_t latencyFrames, const ClockCalibration& calibration)
+{
+  m_fileName = fileName;
+  m_origin = Clock::now();
+  m_calibration = calibration;
+  m_calibrationOffsetUs = std::chrono::duration<double, std::micro>(calibration.cpuTime - m_origin).count();
+  m_capturingFrames = frameCount;
+  m_drainingFrames = 0;
+  m_latencyFrames = latencyFrames;
+  m_frameIndex = 0;
+  m_events.clear();
+  m_events.reserve(size_t(frameCount + latencyFrames) * ExpectedEventsPerFrame);
+}
+
+void TraceRecorder::AddCpuEvent(const char* name, Clock::time_point begin, Clock::time_point end)
+{
+  if (!IsCapturing())
+  {
+    return;
+  }
+  auto beginUs = std::chrono::duration<double, std::micro>(begin - m_origin).count();
+  auto durationUs = std::chrono::duration<double, std::micro>(end - begin).count();
+  AddEvent(name, beginUs, durationUs, Track_Cpu);
+}
+
+void TraceRecorder::AddGpuEvent(const char* name, uint64_t beginTicks, uint64_t endTicks)
+{
+  if (!IsActive())
+  {
+    return;
+  }
+  // 基準のタイムスタンプより前の値もあるため符号付きで差を取る.
+  auto usPerTick = m_calibration.nanosecondsPerTick / 1000.0;
+  auto beginUs = m_calibrationOffsetUs + double(int64_t(beginTicks - m_calibration.gpuTicks)) * usPerTick;
+  auto durationUs = double(endTicks - beginTicks) * usPerTick;
+  AddEvent(name, beginUs, durationUs, Track_Gpu);
+}
+
+void TraceRecorder::AddEvent(const std::string& name, double beginUs, double durationUs, Track track)
+{
+  if (beginUs < 0.0)
+  {
+    return;
+  }
+  m_events.push_back(Event{ name, beginUs, durationUs, track, m_frameIndex });
+}
+
+bool TraceRecorder::EndFrame()
+{
+  if (m_capturingFrames > 0)
+  {
+    m_frameIndex++;
+    if (--m_capturingFrames == 0)
+    {
+      m_drainingFrames = m_latencyFrames;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  else if (m_drainingFrames > 0)
+  {
+    m_drainingFrames--;
+  }
+  else
+  {
+    return false;
+  }
+  if (m_drainingFrames > 0)
+  {
+    return false;
+  }
+  return Write();
+}
+
+bool TraceRecorder::Finish()
+{
+  if (!IsActive())
+  {
+    return false;
+  }
+  m_capturingFrames = 0;
+  m_drainingFrames = 0;
+  return Write();
+}
+
+bool TraceRecorder::Write() const
+{
+  std::ofstream outfile(m_fileName);
+  if (!outfile)
+  {
+    return false;
+  }
+  // ts/dur はマイクロ秒. 指数表記にならないよう固定小数点で出力する.
+  outfile << std::fixed;
+  outfile.precision(3);
+  outfile << "{\"traceEvents\":[" << std::endl;
+  outfile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Track_Cpu << ",\"args\":{\"name\":\"CPU\"}}," << std::endl;
+  outfile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Track_Gpu << ",\"args\":{\"name\":\"GPU\"}}";
+  for (const auto& e : m_events)
+  {
+    outfile << "," << std::endl << "{\"name\":\"";
+    WriteEscaped(outfile, e.name);
+    outfile << "\",\"cat\":\"" << (e.track == Track_Cpu ? "cpu" : "gpu") << "\",\"ph\":\"X\""
+      << ",\"ts\":" << e.beginUs << ",\"dur\":" << e.durationUs
+      << ",\"pid\":1,\"tid\":" << e.track;
+    if (e.track == Track_Cpu)
+    {
+      outfile << ",\"args\":{\"frame\":" << e.frame << "}";
+    }
+    outfile << "}";
+  }
+  outfile << std::endl << "]," << std::endl;
+  outfile << "\"displayTimeUnit\":\"ms\"," << std::endl;
+  outfile << "\"otherData\":{\"gpuClock\":\"" << (m_calibration.isCalibrated ? "calibrated" : "estimated")
+    << "\",\"maxDeviationUs\":" << m_calibration.maxDeviationUs
+    << ",\"frames\":" << m_frameIndex << "}" << std::endl;
+  outfile << "}" << std::endl;
+  return bool(outfile);
+}
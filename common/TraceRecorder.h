@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+// CPU のフェーズと GPU の計測区間を 1 本の時間軸に並べ、Chrome の trace_event 形式(JSON)で書き出す.
+// GPU のタイムスタンプは ClockCalibration で CPU の時刻へ変換する.
+// GPU の結果は処理中のフレーム数だけ遅れて届くため、記録の終了後もその分待ってから書き出す.
+class TraceRecorder
+{
+public:
+  // 計測中に時刻が戻らないよう steady_clock を使う. CpuProfiler::Clock と同じであること.
+  using Clock = std::chrono::steady_clock;
+
+  // GPU のタイムスタンプ gpuTicks が CPU の時刻 cpuTime に対応する.
+  struct ClockCalibration
+  {
+    Clock::time_point cpuTime;
+    uint64_t gpuTicks;
+    double nanosecondsPerTick;
+    double maxDeviationUs;  // 対応付けの誤差の上限.
+    bool isCalibrated;      // false の場合は発行と完了の時刻からの推定.
+  };
+
+  TraceRecorder();
+
+  // frameCount フレームの間 CPU の区間を記録する. GPU の区間はさらに latencyFrames フレームの間受け付ける.
+  void Start(const char* fileName, uint32_t frameCount, uint32_t latencyFrames, const ClockCalibration& calibration);
+  // CPU の区間を受け付けている間は true.
+  bool IsCapturing() const { return m_capturingFrames > 0; }
+  // GPU の区間を受け付けている間は true.
+  bool IsActive() const { return m_capturingFrames > 0 || m_drainingFrames > 0; }
+
+  // 記録開始より前に始まった区間は捨てる.
+  void AddCpuEvent(const char* name, Clock::time_point begin, Clock::time_point end);
+  void AddGpuEvent(const char* name, uint64_t beginTicks, uint64_t endTicks);
+  // フレームの終わりに呼ぶ. 待ち終えてファイルへ書き出した場合は true.
+  bool EndFrame();
+  // 待たずにここまでの内容を書き出す.
+  bool Finish();
+
+  const std::string& GetFileName() const { return m_fileName; }
+  size_t GetEventCount() const { return m_events.size(); }
+  uint32_t GetFrameIndex() const { return m_frameIndex; }
+
+private:
+  enum Track
+  {
+    Track_Cpu = 1,
+    Track_Gpu = 2,
+  };
+  struct Event
+  {
+    std::string name;
+    double beginUs;   // 記録開始からの時間.
+    double durationUs;
+    Track track;
+    uint32_t frame;   // CPU の区間のみ.
+  };
+  void AddEvent(const std::string& name, double beginUs, double durationUs, Track track);
+  bool Write() const;
+
+  std::string m_fileName;
+  Clock::time_point m_origin;
+  ClockCalibration m_calibration;
+  double m_calibrationOffsetUs;   // m_origin から m_calibration.cpuTime までの時間.
+  uint32_t m_capturingFrames;
+  uint32_t m_drainingFrames;
+  uint32_t m_latencyFrames;
+  uint32_t m_frameIndex;
+  std::vector<Event> m_events;
+};
@@ -0,0 +1,31 @@
+#include "UniformRingBuffer.h"
+#include "VulkanBookUtil.h"
+#include <algorithm>
+
+UniformRingBuffer::UniformRingBuffer(VkBuffer buffer, void* mapped, VkDeviceSize alignment, uint32_t frameCount, VkDeviceSize frameSize)
+  : m_buffer(buffer), m_mapped(static_cast<char*>(mapped)),
+  m_alignment(std::max<VkDeviceSize>(alignment, 1)), m_frameCount(frameCount),
+  m_frameSize(frameSize), m_frameBegin(0), m_cursor(0), m_peakUsage(0)
+{
+}
+
+void UniformRingBuffer::BeginFrame(uint32_t frameIndex)
+{
+  m_frameBegin = m_frameSize * (frameIndex % m_frameCount);
+  m_cursor = m_frameBegin;
+  m_frameRanges.clear();
+}
+
+UniformRingBuffer::Slice UniformRingBuffer::Allocate(VkDeviceSize size)
+{
+  auto offset = (m_cursor + m_alignment - 1) / m_alignment * m_alignment;
+  if (offset + size > m_frameBegin + m_frameSize)
+  {
+    throw book_util::VulkanException("UniformRingBuffer: frame capacity exceeded.");
+  }
+  m_cursor = offset + size;
+  m_peakUsage = std::max(m_peakUsage, m_cursor - m_frameBegin);
+  m_frameRanges.push_back(Range{ m_mapped + offset, size });
+
+  return Slice{ m_mapped + offset, uint32_t(offset) };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstring>
+#include <vector>
+
+// フレーム単位の線形アロケータ.
+// 永続マップされた 1 つの大きなユニフォームバッファをフレーム数で分割し、
+// 各フレームの領域から minUniformBufferOffsetAlignment 単位で切り出して使う.
+// 切り出した領域は VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC のダイナミックオフセットで参照する.
+class UniformRingBuffer
+{
+public:
+  struct Slice
+  {
+    void* mapped;
+    uint32_t offset;  // バッファ先頭からのオフセット(ダイナミックオフセット値).
+  };
+  struct Range
+  {
+    const void* data;
+    VkDeviceSize size;
+  };
+
+  // mapped はバッファ先頭を指す CPU 側ポインタ.
+  // 非コヒーレントなメモリの場合、alignment は nonCoherentAtomSize の倍数とし、提出前に GetFrameBegin/GetFrameUsage の範囲を Flush すること.
+  UniformRingBuffer(VkBuffer buffer, void* mapped, VkDeviceSize alignment, uint32_t frameCount, VkDeviceSize frameSize);
+
+  // 描画フレームの開始. 該当フレームの GPU 処理が完了してから呼ぶこと.
+  void BeginFrame(uint32_t frameIndex);
+
+  Slice Allocate(VkDeviceSize size);
+
+  // データを書き込んでダイナミックオフセットを返す.
+  template<class T>
+  uint32_t Push(const T& data)
+  {
+    auto slice = Allocate(sizeof(T));
+    memcpy(slice.mapped, &data, sizeof(T));
+    return slice.offset;
+  }
+
+  VkBuffer GetBuffer() const { return m_buffer; }
+  VkDeviceSize GetFrameSize() const { return m_frameSize; }
+  VkDeviceSize GetAlignment() const { return m_alignment; }
+  // 現在のフレームで切り出した領域(確保順、アライメントのパディングは含まない). フレームの記録に使う.
+  const std::vector<Range>& GetFrameRanges() const { return m_frameRanges; }
+  // 現在のフレームで切り出した範囲(バッファ先頭からのオフセットと、パディング込みの大きさ).
+  VkDeviceSize GetFrameBegin() const { return m_frameBegin; }
+  VkDeviceSize GetFrameUsage() const { return m_cursor - m_frameBegin; }
+  // これまでの 1 フレームあたりの最大使用量.
+  VkDeviceSize GetPeakUsage() const { return m_peakUsage; }
+
+private:
+  VkBuffer m_buffer;
+  char* m_mapped;
+  VkDeviceSize m_alignment;
+  uint32_t m_frameCount;
+  VkDeviceSize m_frameSize;
+
+  VkDeviceSize m_frameBegin;
+  VkDeviceSize m_cursor;
+  VkDeviceSize m_peakUsage;
+  std::vector<Range> m_frameRanges;
+};
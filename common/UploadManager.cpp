@@ -0,0 +1,513 @@
+#include "UploadManager.h"
+#include "VulkanBookUtil.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  // VkBufferImageCopy::bufferOffset はテクセルサイズ(圧縮形式ならブロックサイズ)の倍数が必要.
+  const VkDeviceSize StagingAlignment = 16;
+
+  // 頂点/インデックス/ユニフォームとしての読み込み.
+  const VkAccessFlags BufferReadAccess =
+    VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+  VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+}
+
+UploadManager::UploadManager(
+  VkDevice device, DeviceMemoryAllocator* allocator,
+  VkQueue queue, uint32_t queueFamilyIndex,
+  VkQueue graphicsQueue, uint32_t graphicsFamilyIndex,
+  VkDeviceSize stagingSize)
+  : m_device(device), m_allocator(allocator), m_queue(queue), m_graphicsQueue(graphicsQueue),
+  m_queueFamilyIndex(queueFamilyIndex), m_graphicsFamilyIndex(graphicsFamilyIndex),
+  m_acquireCommandPool(VK_NULL_HANDLE),
+  m_ringSize(stagingSize), m_head(0), m_tail(0), m_used(0),
+  m_recording(false), m_current(), m_lastSubmitted(0), m_lastCompleted(0),
+  m_postImageStages(0), m_hasBufferUploads(false), m_stats()
+{
+  VkCommandPoolCreateInfo cmdPoolCI{
+    VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    nullptr,
+    VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+    queueFamilyIndex
+  };
+  auto result = vkCreateCommandPool(m_device, &cmdPoolCI, nullptr, &m_commandPool);
+  ThrowIfFailed(result, "vkCreateCommandPool Failed.");
+  if (IsOwnershipTransferRequired())
+  {
+    cmdPoolCI.queueFamilyIndex = m_graphicsFamilyIndex;
+    result = vkCreateCommandPool(m_device, &cmdPoolCI, nullptr, &m_acquireCommandPool);
+    ThrowIfFailed(result, "vkCreateCommandPool Failed.");
+  }
+
+  m_ring = CreateStagingBuffer(m_ringSize);
+}
+
+UploadManager::~UploadManager()
+{
+  while (!m_inFlight.empty())
+  {
+    Wait(m_inFlight.back().token);
+  }
+  for (auto& staging : m_current.temporaries)
+  {
+    DestroyStagingBuffer(staging);
+  }
+  for (auto fence : m_freeFences)
+  {
+    vkDestroyFence(m_device, fence, nullptr);
+  }
+  for (auto semaphore : m_freeSemaphores)
+  {
+    vkDestroySemaphore(m_device, semaphore, nullptr);
+  }
+  DestroyStagingBuffer(m_ring);
+  // コマンドバッファはプールと共に解放される.
+  vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+  if (m_acquireCommandPool != VK_NULL_HANDLE)
+  {
+    vkDestroyCommandPool(m_device, m_acquireCommandPool, nullptr);
+  }
+}
+
+void UploadManager::UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+{
+  Begin();
+  VkBuffer src;
+  VkDeviceSize srcOffset;
+  Stage(&data, 1, size, src, srcOffset);
+
+  VkBufferCopy region{ srcOffset, dstOffset, size };
+  vkCmdCopyBuffer(m_current.command, src, dst, 1, &region);
+  if (IsOwnershipTransferRequired())
+  {
+    VkBufferMemoryBarrier bmb{
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_TRANSFER_WRITE_BIT, BufferReadAccess,
+      m_queueFamilyIndex, m_graphicsFamilyIndex,
+      dst, dstOffset, size
+    };
+    m_postBufferBarriers.push_back(bmb);
+  }
+  else
+  {
+    m_hasBufferUploads = true;
+  }
+
+  m_stats.uploadCount++;
+  m_stats.bytesUploaded += size;
+}
+
+void UploadManager::UploadImage(
+  VkImage dst, VkExtent3D extent,
+  uint32_t layerCount, const void* const* layerData, VkDeviceSize layerSize,
+  VkImageLayout finalLayout, VkPipelineStageFlags dstStage)
+{
+  Begin();
+  VkBuffer src;
+  VkDeviceSize srcOffset;
+  Stage(layerData, layerCount, layerSize, src, srcOffset);
+
+  VkImageMemoryBarrier imb{
+    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+    0, VK_ACCESS_TRANSFER_WRITE_BIT,
+    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+    dst,
+    { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layerCount }
+  };
+  vkCmdPipelineBarrier(m_current.command,
+    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+    0, 0, nullptr,
+    0, nullptr,
+    1, &imb);
+
+  std::vector<VkBufferImageCopy> regions(layerCount);
+  for (uint32_t i = 0; i < layerCount; ++i)
+  {
+    auto& region = regions[i];
+    region = VkBufferImageCopy{};
+    region.bufferOffset = srcOffset + layerSize * i;
+    region.imageExtent = extent;
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, i, 1 };
+  }
+  vkCmdCopyBufferToImage(
+    m_current.command,
+    src, dst,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    uint32_t(regions.size()), regions.data());
+
+  imb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  imb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  imb.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  imb.newLayout = finalLayout;
+  if (IsOwnershipTransferRequired())
+  {
+    imb.srcQueueFamilyIndex = m_queueFamilyIndex;
+    imb.dstQueueFamilyIndex = m_graphicsFamilyIndex;
+  }
+  m_postImageBarriers.push_back(imb);
+  m_postImageStages |= dstStage;
+
+  m_stats.uploadCount++;
+  m_stats.bytesUploaded += layerSize * layerCount;
+}
+
+VkCommandBuffer UploadManager::GetCommandBuffer()
+{
+  Begin();
+  FlushPostBarriers();
+  return IsOwnershipTransferRequired() ? m_current.acquireCommand : m_current.command;
+}
+
+UploadManager::Token UploadManager::Submit()
+{
+  if (!m_recording)
+  {
+    return m_lastSubmitted;
+  }
+  FlushPostBarriers();
+  auto result = vkEndCommandBuffer(m_current.command);
+  ThrowIfFailed(result, "vkEndCommandBuffer Failed.");
+  if (IsOwnershipTransferRequired())
+  {
+    result = vkEndCommandBuffer(m_current.acquireCommand);
+    ThrowIfFailed(result, "vkEndCommandBuffer Failed.");
+  }
+
+  if (m_freeFences.empty())
+  {
+    VkFenceCreateInfo fenceCI{
+      VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+      nullptr, 0
+    };
+    VkFence fence;
+    result = vkCreateFence(m_device, &fenceCI, nullptr, &fence);
+    ThrowIfFailed(result, "vkCreateFence Failed.");
+    m_freeFences.push_back(fence);
+    m_stats.fenceCreations++;
+  }
+  m_current.fence = m_freeFences.back();
+  m_freeFences.pop_back();
+
+  VkSubmitInfo submitInfo{
+    VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    nullptr,
+    0, nullptr,
+    nullptr,
+    1, &m_current.command,
+    0, nullptr,
+  };
+  if (!IsOwnershipTransferRequired())
+  {
+    result = vkQueueSubmit(m_queue, 1, &submitInfo, m_current.fence);
+    ThrowIfFailed(result, "vkQueueSubmit Failed.");
+  }
+  else
+  {
+    if (m_freeSemaphores.empty())
+    {
+      VkSemaphoreCreateInfo semCI{
+        VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        nullptr, 0,
+      };
+      VkSemaphore semaphore;
+      result = vkCreateSemaphore(m_device, &semCI, nullptr, &semaphore);
+      ThrowIfFailed(result, "vkCreateSemaphore Failed.");
+      m_freeSemaphores.push_back(semaphore);
+      m_stats.semaphoreCreations++;
+    }
+    m_current.semaphore = m_freeSemaphores.back();
+    m_freeSemaphores.pop_back();
+
+    // 転送キューでの転送(と所有権の解放)の完了後に、グラフィックスキューで獲得する.
+    // フェンスは獲得側に付けるので、シグナル時には両方が完了している.
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_current.semaphore;
+    result = vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE);
+    ThrowIfFailed(result, "vkQueueSubmit Failed.");
+
+    VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo acquireSubmitInfo{
+      VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      nullptr,
+      1, &m_current.semaphore,
+      &waitStageMask,
+      1, &m_current.acquireCommand,
+      0, nullptr,
+    };
+    result = vkQueueSubmit(m_graphicsQueue, 1, &acquireSubmitInfo, m_current.fence);
+    ThrowIfFailed(result, "vkQueueSubmit Failed.");
+  }
+
+  m_current.token = ++m_lastSubmitted;
+  m_current.ringEnd = m_head;
+  m_inFlight.push_back(std::move(m_current));
+  m_current = Batch{};
+  m_recording = false;
+  m_stats.submitCount++;
+  return m_lastSubmitted;
+}
+
+bool UploadManager::IsCompleted(Token token)
+{
+  Collect();
+  return token <= m_lastCompleted;
+}
+
+void UploadManager::Wait(Token token)
+{
+  while (!m_inFlight.empty() && m_inFlight.front().token <= token)
+  {
+    auto& batch = m_inFlight.front();
+    vkWaitForFences(m_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    Retire(batch);
+    m_inFlight.pop_front();
+  }
+}
+
+void UploadManager::Collect()
+{
+  // バッチは発行順に完了するものとして先頭から調べる.
+  while (!m_inFlight.empty() && vkGetFenceStatus(m_device, m_inFlight.front().fence) == VK_SUCCESS)
+  {
+    Retire(m_inFlight.front());
+    m_inFlight.pop_front();
+  }
+}
+
+void UploadManager::Begin()
+{
+  if (m_recording)
+  {
+    return;
+  }
+  VkCommandBufferBeginInfo beginInfo{
+    VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    nullptr,
+    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+  };
+  m_current.command = AllocateCommandBuffer(m_commandPool, m_freeCommands);
+  vkBeginCommandBuffer(m_current.command, &beginInfo);
+  if (IsOwnershipTransferRequired())
+  {
+    m_current.acquireCommand = AllocateCommandBuffer(m_acquireCommandPool, m_freeAcquireCommands);
+    vkBeginCommandBuffer(m_current.acquireCommand, &beginInfo);
+  }
+  m_recording = true;
+}
+
+VkCommandBuffer UploadManager::AllocateCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList)
+{
+  if (freeList.empty())
+  {
+    VkCommandBufferAllocateInfo commandAI{
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      nullptr, pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      1
+    };
+    VkCommandBuffer command;
+    auto result = vkAllocateCommandBuffers(m_device, &commandAI, &command);
+    ThrowIfFailed(result, "vkAllocateCommandBuffers Failed.");
+    freeList.push_back(command);
+    m_stats.commandBufferAllocations++;
+  }
+  auto command = freeList.back();
+  freeList.pop_back();
+  return command;
+}
+
+void UploadManager::FlushPostBarriers()
+{
+  if (m_postImageBarriers.empty() && m_postBufferBarriers.empty() && !m_hasBufferUploads)
+  {
+    return;
+  }
+  VkPipelineStageFlags dstStage = m_postImageStages;
+  if (m_hasBufferUploads || !m_postBufferBarriers.empty())
+  {
+    dstStage |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+  }
+
+  if (!IsOwnershipTransferRequired())
+  {
+    VkMemoryBarrier memoryBarrier{
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      BufferReadAccess,
+    };
+    vkCmdPipelineBarrier(m_current.command,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+      0,
+      m_hasBufferUploads ? 1 : 0, &memoryBarrier,
+      0, nullptr,
+      uint32_t(m_postImageBarriers.size()), m_postImageBarriers.data());
+  }
+  else
+  {
+    // 転送キューで解放し、グラフィックスキューで獲得する.
+    // 解放側の dstAccessMask と獲得側の srcAccessMask は使われない.
+    std::vector<VkBufferMemoryBarrier> releaseBuffers(m_postBufferBarriers), acquireBuffers(m_postBufferBarriers);
+    std::vector<VkImageMemoryBarrier> releaseImages(m_postImageBarriers), acquireImages(m_postImageBarriers);
+    for (auto& b : releaseBuffers) { b.dstAccessMask = 0; }
+    for (auto& b : acquireBuffers) { b.srcAccessMask = 0; }
+    for (auto& b : releaseImages) { b.dstAccessMask = 0; }
+    for (auto& b : acquireImages) { b.srcAccessMask = 0; }
+
+    vkCmdPipelineBarrier(m_current.command,
+      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0, nullptr,
+      uint32_t(releaseBuffers.size()), releaseBuffers.data(),
+      uint32_t(releaseImages.size()), releaseImages.data());
+    vkCmdPipelineBarrier(m_current.acquireCommand,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage,
+      0,
+      0, nullptr,
+      uint32_t(acquireBuffers.size()), acquireBuffers.data(),
+      uint32_t(acquireImages.size()), acquireImages.data());
+  }
+
+  m_postImageBarriers.clear();
+  m_postBufferBarriers.clear();
+  m_postImageStages = 0;
+  m_hasBufferUploads = false;
+}
+
+void UploadManager::Stage(const void* const* data, uint32_t count, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset)
+{
+  auto totalSize = size * count;
+  char* dst = nullptr;
+  Allocation* allocation = nullptr;
+  if (AllocateFromRing(totalSize, offset))
+  {
+    buffer = m_ring.buffer;
+    allocation = &m_ring.allocation;
+    dst = static_cast<char*>(m_ring.allocation.mapped) + offset;
+  }
+  else
+  {
+    // リングに収まらない場合は、このバッチの完了で破棄する一時バッファを使う.
+    m_current.temporaries.push_back(CreateStagingBuffer(totalSize));
+    auto& staging = m_current.temporaries.back();
+    buffer = staging.buffer;
+    allocation = &staging.allocation;
+    offset = 0;
+    dst = static_cast<char*>(staging.allocation.mapped);
+    m_stats.overflowCount++;
+  }
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    memcpy(dst + size * i, data[i], size_t(size));
+  }
+  m_allocator->Flush(*allocation, offset, totalSize);
+}
+
+bool UploadManager::AllocateFromRing(VkDeviceSize size, VkDeviceSize& offset)
+{
+  if (size > m_ringSize)
+  {
+    return false;
+  }
+  for (int retry = 0; retry < 2; ++retry)
+  {
+    if (m_used == 0)
+    {
+      m_head = m_tail = 0;
+    }
+    auto isFull = m_used > 0 && m_head == m_tail;
+    auto begin = AlignUp(m_head, StagingAlignment);
+    auto end = begin + size;
+    if (!isFull && m_head >= m_tail)
+    {
+      if (end > m_ringSize && size <= m_tail)
+      {
+        // 先頭へ折り返す. 末尾の余りは使用済み扱いとする.
+        m_used += m_ringSize - m_head;
+        m_current.ringBytes += m_ringSize - m_head;
+        m_head = 0;
+        begin = 0;
+        end = size;
+      }
+      if (end <= m_ringSize)
+      {
+        m_used += end - m_head;
+        m_current.ringBytes += end - m_head;
+        m_head = end;
+        offset = begin;
+        return true;
+      }
+    }
+    else if (!isFull && end <= m_tail)
+    {
+      m_used += end - m_head;
+      m_current.ringBytes += end - m_head;
+      m_head = end;
+      offset = begin;
+      return true;
+    }
+    // 完了済みのバッチを回収して再試行する.
+    Collect();
+  }
+  return false;
+}
+
+UploadManager::StagingBuffer UploadManager::CreateStagingBuffer(VkDeviceSize size)
+{
+  StagingBuffer staging;
+  VkBufferCreateInfo bufferCI{
+    VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    nullptr, 0,
+    size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+    VK_SHARING_MODE_EXCLUSIVE,
+    0, nullptr
+  };
+  auto result = vkCreateBuffer(m_device, &bufferCI, nullptr, &staging.buffer);
+  ThrowIfFailed(result, "vkCreateBuffer Failed.");
+
+  VkMemoryRequirements reqs;
+  vkGetBufferMemoryRequirements(m_device, staging.buffer, &reqs);
+  auto memoryTypeIndex = m_allocator->FindMemoryTypeIndex(
+    reqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  staging.allocation = m_allocator->Allocate(reqs, memoryTypeIndex, DeviceMemoryAllocator::ResourceKind_Linear, DeviceMemoryAllocator::Category_Staging);
+  result = vkBindBufferMemory(m_device, staging.buffer, staging.allocation.memory, staging.allocation.offset);
+  ThrowIfFailed(result, "vkBindBufferMemory Failed.");
+  return staging;
+}
+
+void UploadManager::DestroyStagingBuffer(const StagingBuffer& staging)
+{
+  vkDestroyBuffer(m_device, staging.buffer, nullptr);
+  m_allocator->Free(staging.allocation);
+}
+
+void UploadManager::Retire(Batch& batch)
+{
+  vkResetFences(m_device, 1, &batch.fence);
+  m_freeFences.push_back(batch.fence);
+  vkResetCommandBuffer(batch.command, 0);
+  m_freeCommands.push_back(batch.command);
+  if (IsOwnershipTransferRequired())
+  {
+    vkResetCommandBuffer(batch.acquireCommand, 0);
+    m_freeAcquireCommands.push_back(batch.acquireCommand);
+    m_freeSemaphores.push_back(batch.semaphore);
+  }
+
+  // リングを使っていないバッチの終端は、リングの巻き戻し後には無効になっている.
+  if (batch.ringBytes > 0)
+  {
+    m_tail = batch.ringEnd;
+    m_used -= batch.ringBytes;
+  }
+  for (auto& staging : batch.temporaries)
+  {
+    DestroyStagingBuffer(staging);
+  }
+  m_lastCompleted = batch.token;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include "DeviceMemoryAllocator.h"
+
+// ステージングを経由した GPU への転送をまとめて行う.
+// 転送要求は 1 つのコマンドバッファへ記録しておき、Submit でまとめて発行する.
+// Submit は完了を待たずにトークンを返し、ステージング領域は完了を確認した時点で回収する.
+// 転送キューがグラフィックスキューと別ファミリーの場合、転送後にリソースの所有権を
+// グラフィックス側へ移し、獲得のバリアと初期化コマンドはグラフィックスキューで実行する.
+class UploadManager
+{
+public:
+  using Token = uint64_t;
+
+  struct Statistics
+  {
+    uint32_t submitCount;
+    uint32_t uploadCount;
+    VkDeviceSize bytesUploaded;
+    uint32_t overflowCount;   // リングに収まらず一時バッファを使った数.
+    uint32_t commandBufferAllocations;
+    uint32_t fenceCreations;
+    uint32_t semaphoreCreations;
+  };
+
+  UploadManager(
+    VkDevice device, DeviceMemoryAllocator* allocator,
+    VkQueue queue, uint32_t queueFamilyIndex,
+    VkQueue graphicsQueue, uint32_t graphicsFamilyIndex,
+    VkDeviceSize stagingSize);
+  ~UploadManager();
+
+  // data はこの呼び出し中にステージングへコピーされるため、戻った後は解放してよい.
+  void UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+  // イメージのミップ 0 の各レイヤーへ転送し、finalLayout へ遷移させる.
+  // layerData[i] が i 番目のレイヤーの内容(layerSize バイト).
+  void UploadImage(
+    VkImage dst, VkExtent3D extent,
+    uint32_t layerCount, const void* const* layerData, VkDeviceSize layerSize,
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+  // 転送と同じバッチで実行したい初期化コマンド(レイアウト遷移など)の記録先.
+  // ここまでに記録した転送は完了済みの状態として扱える. 常にグラフィックスキューで実行される.
+  VkCommandBuffer GetCommandBuffer();
+
+  // 記録済みのコマンドを発行する. 記録が無ければ直前のトークンを返す.
+  Token Submit();
+  bool HasPendingCommands() const { return m_recording; }
+  bool IsOwnershipTransferRequired() const { return m_queueFamilyIndex != m_graphicsFamilyIndex; }
+
+  bool IsCompleted(Token token);
+  void Wait(Token token);
+  // 完了済みのバッチを回収する.
+  void Collect();
+
+  const Statistics& GetStatistics() const { return m_stats; }
+
+private:
+  using Allocation = DeviceMemoryAllocator::Allocation;
+  struct StagingBuffer
+  {
+    VkBuffer buffer;
+    Allocation allocation;
+  };
+  struct Batch
+  {
+    Token token;
+    VkCommandBuffer command;
+    VkCommandBuffer acquireCommand; // 所有権の獲得と初期化コマンド(グラフィックスキュー).
+    VkSemaphore semaphore;          // 転送 -> 獲得の待ち合わせ.
+    VkFence fence;
+    VkDeviceSize ringEnd;     // このバッチが使用したリングの終端.
+    VkDeviceSize ringBytes;   // このバッチが使用したリングの量(パディング込み).
+    std::vector<StagingBuffer> temporaries;
+  };
+
+  void Begin();
+  VkCommandBuffer AllocateCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+  void FlushPostBarriers();
+  // ステージング領域を確保して data をコピーする.
+  void Stage(const void* const* data, uint32_t count, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset);
+  bool AllocateFromRing(VkDeviceSize size, VkDeviceSize& offset);
+  StagingBuffer CreateStagingBuffer(VkDeviceSize size);
+  void DestroyStagingBuffer(const StagingBuffer& staging);
+  void Retire(Batch& batch);
+
+  VkDevice m_device;
+  DeviceMemoryAllocator* m_allocator;
+  VkQueue m_queue;
+  VkQueue m_graphicsQueue;
+  uint32_t m_queueFamilyIndex;
+  uint32_t m_graphicsFamilyIndex;
+  VkCommandPool m_commandPool;
+  VkCommandPool m_acquireCommandPool;
+
+  StagingBuffer m_ring;
+  VkDeviceSize m_ringSize;
+  VkDeviceSize m_head, m_tail, m_used;
+
+  bool m_recording;
+  Batch m_current;
+  std::deque<Batch> m_inFlight;
+  std::vector<VkCommandBuffer> m_freeCommands;
+  std::vector<VkCommandBuffer> m_freeAcquireCommands;
+  std::vector<VkFence> m_freeFences;
+  std::vector<VkSemaphore> m_freeSemaphores;
+  Token m_lastSubmitted;
+  Token m_lastCompleted;
+
+  // 転送後のバリアは Submit 時(または GetCommandBuffer 時)にまとめて発行する.
+  std::vector<VkImageMemoryBarrier> m_postImageBarriers;
+  VkPipelineStageFlags m_postImageStages;
+  bool m_hasBufferUploads;
+  // 所有権の移動にはバッファ単位のバリアが必要となる.
+  std::vector<VkBufferMemoryBarrier> m_postBufferBarriers;
+
+  Statistics m_stats;
+};
@@ -1,825 +1,2879 @@
-#include "VulkanAppBase.h"
-#include "VulkanBookUtil.h"
-
-#include "imgui.h"
-#include "examples/imgui_impl_vulkan.h"
-#include "examples/imgui_impl_glfw.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-
-#include <vector>
-#include <sstream>
-
-
-static VkBool32 VKAPI_CALL DebugReportCallback(
-  VkDebugReportFlagsEXT flags,
-  VkDebugReportObjectTypeEXT objactTypes,
-  uint64_t object,
-  size_t	location,
-  int32_t messageCode,
-  const char* pLayerPrefix,
-  const char* pMessage,
-  void* pUserData)
-{
-  VkBool32 ret = VK_FALSE;
-  if (flags & VK_DEBUG_REPORT_INFORMATION_BIT_EXT ||
-    flags & VK_DEBUG_REPORT_DEBUG_BIT_EXT)
-  {
-    ret = VK_TRUE;
-  }
-  std::stringstream ss;
-  if (pLayerPrefix)
-  {
-    ss << "[" << pLayerPrefix << "] ";
-  }
-  ss << pMessage << std::endl;
-
-  OutputDebugStringA(ss.str().c_str());
-
-  return ret;
-}
-
-
-bool VulkanAppBase::OnSizeChanged(uint32_t width, uint32_t height)
-{
-  m_isMinimizedWindow = (width == 0 || height == 0);
-  if (m_isMinimizedWindow)
-  {
-    return false;
-  }
-  vkDeviceWaitIdle(m_device);
-
-  auto format = m_swapchain->GetSurfaceFormat().format;
-  // Xbv`FC蒼.
-  m_swapchain->Prepare(m_physicalDevice, m_gfxQueueIndex, width, height, format);
-  return true;
-}
-
-bool VulkanAppBase::OnMouseButtonDown(int button)
-{
-  return ImGui::GetIO().WantCaptureMouse;
-}
-
-bool VulkanAppBase::OnMouseButtonUp(int button)
-{
-  return ImGui::GetIO().WantCaptureMouse;
-}
-
-bool VulkanAppBase::OnMouseMove(int dx, int dy)
-{
-  return ImGui::GetIO().WantCaptureMouse;
-}
-
-
-uint32_t VulkanAppBase::GetMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestProps) const
-{
-  uint32_t result = ~0u;
-  for (uint32_t i = 0; i < m_physicalMemProps.memoryTypeCount; ++i)
-  {
-    if (requestBits & 1)
-    {
-      const auto& types = m_physicalMemProps.memoryTypes[i];
-      if ((types.propertyFlags & requestProps) == requestProps)
-      {
-        result = i;
-        break;
-      }
-    }
-    requestBits >>= 1;
-  }
-  return result;
-}
-
-void VulkanAppBase::SwitchFullscreen(GLFWwindow* window)
-{
-  static int lastWindowPosX, lastWindowPosY;
-  static int lastWindowSizeW, lastWindowSizeH;
-
-  auto monitor = glfwGetPrimaryMonitor();
-  const auto mode = glfwGetVideoMode(monitor);
-
-#if 1 // ݂̃j^[ɍ킹TCY֕ύX.
-  if (!m_isFullscreen)
-  {
-    // to fullscreen
-    glfwGetWindowPos(window, &lastWindowPosX, &lastWindowPosY);
-    glfwGetWindowSize(window, &lastWindowSizeW, &lastWindowSizeH);
-    glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
-  }
-  else
-  {
-    // to windowmode
-    glfwSetWindowMonitor(window, nullptr, lastWindowPosX, lastWindowPosY, lastWindowSizeW, lastWindowSizeH, mode->refreshRate);
-  }
-#else
-  // w肳ꂽ𑜓xփj^[ύX.
-  if (!m_isFullscreen)
-  {
-    // to fullscreen
-    glfwGetWindowPos(window, &lastWindowPosX, &lastWindowPosY);
-    glfwGetWindowSize(window, &lastWindowSizeW, &lastWindowSizeH);
-    glfwSetWindowMonitor(window, monitor, 0, 0, lastWindowSizeW, lastWindowSizeH, mode->refreshRate);
-  }
-  else
-  {
-    // to windowmode
-    glfwSetWindowMonitor(window, nullptr, lastWindowPosX, lastWindowPosY, lastWindowSizeW, lastWindowSizeH, mode->refreshRate);
-  }
-#endif
-  m_isFullscreen = !m_isFullscreen;
-}
-
-void VulkanAppBase::Initialize(GLFWwindow* window, VkFormat format, bool isFullscreen)
-{
-  m_window = window;
-  CreateInstance();
-
-  // foCX̑I.
-  uint32_t count;
-  vkEnumeratePhysicalDevices(m_vkInstance, &count, nullptr);
-  std::vector<VkPhysicalDevice> physicalDevices(count);
-  vkEnumeratePhysicalDevices(m_vkInstance, &count, physicalDevices.data());
-  // ŏ̃foCXgp.
-  m_physicalDevice = physicalDevices[0];
-  vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_physicalMemProps);
-
-  // OtBbNX̃L[CfbNX擾.
-  SelectGraphicsQueue();
-
-#ifdef _DEBUG
-  EnableDebugReport();
-#endif
-  // _foCX̐.
-  CreateDevice();
-
-  // R}hv[̐.
-  CreateCommandPool();
-
-  VkSurfaceKHR surface;
-  auto result = glfwCreateWindowSurface(m_vkInstance, window, nullptr, &surface);
-  ThrowIfFailed(result, "glfwCreateWindowSurface Failed.");
-
-  // Xbv`FC̐.
-  m_swapchain = std::make_unique<Swapchain>(m_vkInstance, m_device, surface);
-
-  int width, height;
-  glfwGetWindowSize(window, &width, &height);
-  m_swapchain->Prepare(
-    m_physicalDevice, m_gfxQueueIndex,
-    uint32_t(width), uint32_t(height),
-    format
-  );
-  auto imageCount = m_swapchain->GetImageCount();
-  auto extent = m_swapchain->GetSurfaceExtent();
-
-  VkSemaphoreCreateInfo semCI{
-    VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-    nullptr, 0,
-  };
-
-  vkCreateSemaphore(m_device, &semCI, nullptr, &m_renderCompletedSem);
-  vkCreateSemaphore(m_device, &semCI, nullptr, &m_presentCompletedSem);
-
-  // fBXNv^v[̐.
-  CreateDescriptorPool();
-
-  m_renderPassStore = std::make_unique<RenderPassRegistry>([&](VkRenderPass renderPass) { vkDestroyRenderPass(m_device, renderPass, nullptr); });
-  m_descriptorSetLayoutStore = std::make_unique<DescriptorSetLayoutManager>([&](VkDescriptorSetLayout layout) { vkDestroyDescriptorSetLayout(m_device, layout, nullptr); });
-  m_pipelineLayoutStore = std::make_unique<PipelineLayoutManager>([&](VkPipelineLayout layout) { vkDestroyPipelineLayout(m_device, layout, nullptr); });
-
-  Prepare();
-
-  PrepareImGui();
-}
-
-void VulkanAppBase::Terminate()
-{
-  if (m_device != VK_NULL_HANDLE)
-  {
-    vkDeviceWaitIdle(m_device);
-  }
-  Cleanup();
-
-  CleanupImGui();
-
-  if (m_swapchain)
-  {
-    m_swapchain->Cleanup();
-  }
-#ifdef _DEBUG
-  DisableDebugReport();
-#endif
-
-  m_renderPassStore->Cleanup();
-  m_descriptorSetLayoutStore->Cleanup();
-  m_pipelineLayoutStore->Cleanup();
-
-  vkDestroySemaphore(m_device, m_renderCompletedSem, nullptr);
-  vkDestroySemaphore(m_device, m_presentCompletedSem, nullptr);
-
-  vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
-  vkDestroyCommandPool(m_device, m_commandPool, nullptr);
-  vkDestroyDevice(m_device, nullptr);
-  vkDestroyInstance(m_vkInstance, nullptr);
-  m_commandPool = VK_NULL_HANDLE;
-  m_device = VK_NULL_HANDLE;
-  m_vkInstance = VK_NULL_HANDLE;
-}
-
-VulkanAppBase::BufferObject VulkanAppBase::CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
-{
-  BufferObject obj;
-  VkBufferCreateInfo bufferCI{
-    VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-    nullptr, 0,
-    size, usage,
-    VK_SHARING_MODE_EXCLUSIVE,
-    0, nullptr
-  };
-  auto result = vkCreateBuffer(m_device, &bufferCI, nullptr, &obj.buffer);
-  ThrowIfFailed(result, "vkCreateBuffer Failed.");
-
-  // ʂ̎Zo.
-  VkMemoryRequirements reqs;
-  vkGetBufferMemoryRequirements(m_device, obj.buffer, &reqs);
-  VkMemoryAllocateInfo info{
-    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    nullptr,
-    reqs.size,
-    GetMemoryTypeIndex(reqs.memoryTypeBits, props)
-  };
-  vkAllocateMemory(m_device, &info, nullptr, &obj.memory);
-  vkBindBufferMemory(m_device, obj.buffer, obj.memory, 0);
-  return obj;
-}
-
-VulkanAppBase::ImageObject VulkanAppBase::CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage)
-{
-  ImageObject obj;
-  VkImageCreateInfo imageCI{
-    VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-    nullptr, 0,
-    VK_IMAGE_TYPE_2D,
-    format, { width, height, 1 },
-    1, 1, VK_SAMPLE_COUNT_1_BIT,
-    VK_IMAGE_TILING_OPTIMAL,
-    usage,
-    VK_SHARING_MODE_EXCLUSIVE,
-    0, nullptr,
-    VK_IMAGE_LAYOUT_UNDEFINED
-  };
-  auto result = vkCreateImage(m_device, &imageCI, nullptr, &obj.image);
-  ThrowIfFailed(result, "vkCreateImage Failed.");
-
-  // ʂ̎Zo.
-  VkMemoryRequirements reqs;
-  vkGetImageMemoryRequirements(m_device, obj.image, &reqs);
-  VkMemoryAllocateInfo info{
-    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    nullptr,
-    reqs.size,
-    GetMemoryTypeIndex(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-  };
-  result = vkAllocateMemory(m_device, &info, nullptr, &obj.memory);
-  ThrowIfFailed(result, "vkAllocateMemory Failed.");
-  vkBindImageMemory(m_device, obj.image, obj.memory, 0);
-
-  VkImageAspectFlags imageAspect = VK_IMAGE_ASPECT_COLOR_BIT;
-  if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
-  {
-    imageAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-  }
-
-  VkImageViewCreateInfo viewCI{
-    VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-    nullptr, 0,
-    obj.image,
-    VK_IMAGE_VIEW_TYPE_2D,
-    imageCI.format,
-    book_util::DefaultComponentMapping(),
-    { imageAspect, 0, 1, 0, 1}
-  };
-  result = vkCreateImageView(m_device, &viewCI, nullptr, &obj.view);
-  ThrowIfFailed(result, "vkCreateImageView Failed.");
-  return obj;
-}
-
-void VulkanAppBase::DestroyBuffer(BufferObject bufferObj)
-{
-  vkDestroyBuffer(m_device, bufferObj.buffer, nullptr);
-  vkFreeMemory(m_device, bufferObj.memory, nullptr);
-}
-
-void VulkanAppBase::DestroyImage(ImageObject imageObj)
-{
-  vkDestroyImage(m_device, imageObj.image, nullptr);
-  vkFreeMemory(m_device, imageObj.memory, nullptr);
-  if (imageObj.view != VK_NULL_HANDLE)
-  {
-    vkDestroyImageView(m_device, imageObj.view, nullptr);
-  }
-}
-
-VkFramebuffer VulkanAppBase::CreateFramebuffer(
-  VkRenderPass renderPass, uint32_t width, uint32_t height, uint32_t viewCount, VkImageView* views)
-{
-  VkFramebufferCreateInfo fbCI{
-    VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-    nullptr, 0,
-    renderPass,
-    viewCount, views,
-    width, height,
-    1,
-  };
-  VkFramebuffer framebuffer;
-  auto result = vkCreateFramebuffer(m_device, &fbCI, nullptr, &framebuffer);
-  ThrowIfFailed(result, "vkCreateFramebuffer Failed.");
-  return framebuffer;
-}
-void VulkanAppBase::DestroyFramebuffers(uint32_t count, VkFramebuffer* framebuffers)
-{
-  for (uint32_t i = 0; i < count; ++i)
-  {
-    vkDestroyFramebuffer(m_device, framebuffers[i], nullptr);
-  }
-}
-VkFence VulkanAppBase::CreateFence()
-{
-  VkFenceCreateInfo fenceCI{
-    VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-    nullptr,
-    VK_FENCE_CREATE_SIGNALED_BIT
-  };
-  VkFence fence;
-  auto result = vkCreateFence(m_device, &fenceCI, nullptr, &fence);
-  ThrowIfFailed(result, "vkCreateFence Failed.");
-  return fence;
-}
-void VulkanAppBase::DestroyFence(VkFence fence)
-{
-  vkDestroyFence(m_device, fence, nullptr);
-}
-
-VkDescriptorSet VulkanAppBase::AllocateDescriptorSet(VkDescriptorSetLayout dsLayout)
-{
-  VkDescriptorSetAllocateInfo descriptorSetAI{
-    VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-    nullptr, m_descriptorPool,
-    1, &dsLayout
-  };
-
-  VkDescriptorSet ds;
-  auto result = vkAllocateDescriptorSets(m_device, &descriptorSetAI, &ds);
-  ThrowIfFailed(result, "vkAllocateDescriptorSets Failed.");
-  return ds;
-}
-void VulkanAppBase::DeallocateDescriptorSet(VkDescriptorSet descriptorSet)
-{
-  vkFreeDescriptorSets(m_device, m_descriptorPool, 1, &descriptorSet);
-}
-
-
-VkCommandBuffer VulkanAppBase::CreateCommandBuffer(bool bBegin)
-{
-  VkCommandBufferAllocateInfo commandAI{
-     VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-    nullptr, m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-    1
-  };
-  VkCommandBufferBeginInfo beginInfo{
-    VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-  };
-
-  VkCommandBuffer command;
-  vkAllocateCommandBuffers(m_device, &commandAI, &command);
-  if (bBegin)
-  {
-    vkBeginCommandBuffer(command, &beginInfo);
-  }
-  return command;
-}
-
-void VulkanAppBase::FinishCommandBuffer(VkCommandBuffer command)
-{
-  auto result = vkEndCommandBuffer(command);
-  ThrowIfFailed(result, "vkEndCommandBuffer Failed.");
-  VkFence fence;
-  VkFenceCreateInfo fenceCI{
-    VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-    nullptr, 0
-  };
-  result = vkCreateFence(m_device, &fenceCI, nullptr, &fence);
-
-  VkSubmitInfo submitInfo{
-    VK_STRUCTURE_TYPE_SUBMIT_INFO,
-    nullptr,
-    0, nullptr,
-    nullptr,
-    1, &command,
-    0, nullptr,
-  };
-  vkQueueSubmit(m_deviceQueue, 1, &submitInfo, fence);
-  vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
-  vkDestroyFence(m_device, fence, nullptr);
-}
-
-void VulkanAppBase::DestroyCommandBuffer(VkCommandBuffer command)
-{
-  vkFreeCommandBuffers(m_device, m_commandPool, 1, &command);
-}
-
-VkRect2D VulkanAppBase::GetSwapchainRenderArea() const
-{
-  return VkRect2D{
-    VkOffset2D{0,0},
-    m_swapchain->GetSurfaceExtent()
-  };
-}
-
-std::vector<VulkanAppBase::BufferObject> VulkanAppBase::CreateUniformBuffers(uint32_t bufferSize, uint32_t imageCount)
-{
-  std::vector<BufferObject> buffers(imageCount);
-  for (auto& b : buffers)
-  {
-    VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    b = CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, props);
-  }
-  return buffers;
-}
-
-void VulkanAppBase::WriteToHostVisibleMemory(VkDeviceMemory memory, uint32_t size, const void* pData)
-{
-  void* p;
-  vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &p);
-  memcpy(p, pData, size);
-  vkUnmapMemory(m_device, memory);
-}
-
-void VulkanAppBase::AllocateCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands)
-{
-  VkCommandBufferAllocateInfo commandAI{
-    VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-    nullptr, m_commandPool,
-    VK_COMMAND_BUFFER_LEVEL_SECONDARY, count
-  };
-  auto result = vkAllocateCommandBuffers(m_device, &commandAI, pCommands);
-  ThrowIfFailed(result, "vkAllocateCommandBuffers Faield.");
-}
-
-void VulkanAppBase::FreeCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands)
-{
-  vkFreeCommandBuffers(m_device, m_commandPool, count, pCommands);
-}
-
-void VulkanAppBase::TransferStageBufferToImage(
-  const BufferObject& srcBuffer, const ImageObject& dstImage, const VkBufferImageCopy* region)
-{ 
-  VkImageMemoryBarrier imb{
-    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
-    0, VK_ACCESS_TRANSFER_WRITE_BIT,
-    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-    dstImage.image,
-    { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
-  };
-
-  // Staging ].
-  auto command = CreateCommandBuffer();
-  vkCmdPipelineBarrier(command,
-    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-    0, 0, nullptr,
-    0, nullptr, 1, &imb);
-
-  vkCmdCopyBufferToImage(
-    command, 
-    srcBuffer.buffer, dstImage.image,
-    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, region);
-  imb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  imb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  imb.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-  imb.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  vkCmdPipelineBarrier(command,
-    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-    0, 0, nullptr,
-    0, nullptr,
-    1, &imb);
-  FinishCommandBuffer(command);
-  DestroyCommandBuffer(command);
-}
-
-
-VkRenderPass VulkanAppBase::CreateRenderPass(VkFormat colorFormat, VkFormat depthFormat, VkImageLayout layoutColor)
-{
-  VkRenderPass renderPass;
-
-  std::vector<VkAttachmentDescription> attachments;
-
-  if (colorFormat == VK_FORMAT_UNDEFINED)
-  {
-    colorFormat = m_swapchain->GetSurfaceFormat().format;
-  }
-
-  VkAttachmentDescription colorTarget, depthTarget;
-  colorTarget = VkAttachmentDescription{
-    0,  // Flags
-    colorFormat,
-    VK_SAMPLE_COUNT_1_BIT,
-    VK_ATTACHMENT_LOAD_OP_CLEAR,
-    VK_ATTACHMENT_STORE_OP_STORE,
-    VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-    VK_ATTACHMENT_STORE_OP_DONT_CARE,
-    VK_IMAGE_LAYOUT_UNDEFINED,
-    layoutColor
-  };
-  depthTarget = VkAttachmentDescription{
-    0,
-    depthFormat,
-    VK_SAMPLE_COUNT_1_BIT,
-    VK_ATTACHMENT_LOAD_OP_CLEAR,
-    VK_ATTACHMENT_STORE_OP_STORE,
-    VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-    VK_ATTACHMENT_STORE_OP_DONT_CARE,
-    VK_IMAGE_LAYOUT_UNDEFINED,
-    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-  };
-
-  VkAttachmentReference colorRef{
-    0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-  };
-  VkAttachmentReference depthRef{
-    1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-  };
-
-  VkSubpassDescription subpassDesc{
-    0, // Flags
-    VK_PIPELINE_BIND_POINT_GRAPHICS,
-    0, nullptr, // InputAttachments
-    1, &colorRef, // ColorAttachments
-    nullptr,    // ResolveAttachments
-    nullptr,    // DepthStencilAttachments
-    0, nullptr, // PreserveAttachments
-  };
-
-  attachments.push_back(colorTarget);
-  if (depthFormat != VK_FORMAT_UNDEFINED)
-  {
-    attachments.push_back(depthTarget);
-    subpassDesc.pDepthStencilAttachment = &depthRef;
-  }
-
-  VkRenderPassCreateInfo rpCI{
-    VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-    nullptr, 0,
-    uint32_t(attachments.size()), attachments.data(),
-    1, &subpassDesc,
-    0, nullptr, // Dependency
-  };
-  auto result = vkCreateRenderPass(m_device, &rpCI, nullptr, &renderPass);
-  ThrowIfFailed(result, "vkCreateRenderPass Failed.");
-  return renderPass;
-}
-
-
-void VulkanAppBase::PrepareImGui()
-{
-  // ImGui
-  IMGUI_CHECKVERSION();
-  ImGui::CreateContext();
-  ImGui_ImplGlfw_InitForVulkan(m_window, true);
-
-  ImGui_ImplVulkan_InitInfo info{};
-  info.Instance = m_vkInstance;
-  info.PhysicalDevice = m_physicalDevice;
-  info.Device = m_device;
-  info.QueueFamily = m_gfxQueueIndex;
-  info.Queue = m_deviceQueue;
-  info.DescriptorPool = m_descriptorPool;
-  info.MinImageCount = m_swapchain->GetImageCount();
-  info.ImageCount = m_swapchain->GetImageCount();
-  ImGui_ImplVulkan_Init(&info, GetRenderPass("default"));
-
-  // tHgeNX`].
-  VkCommandBufferAllocateInfo commandAI{
-   VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-    nullptr, m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1
-  };
-  VkCommandBufferBeginInfo beginInfo{
-    VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-  };
-
-  VkCommandBuffer command;
-  vkAllocateCommandBuffers(m_device, &commandAI, &command);
-  vkBeginCommandBuffer(command, &beginInfo);
-  ImGui_ImplVulkan_CreateFontsTexture(command);
-  vkEndCommandBuffer(command);
-
-  VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO, nullptr };
-  submitInfo.pCommandBuffers = &command;
-  submitInfo.commandBufferCount = 1;
-  vkQueueSubmit(m_deviceQueue, 1, &submitInfo, VK_NULL_HANDLE);
-
-  // tHgeNX`]̊҂.
-  vkDeviceWaitIdle(m_device);
-  vkFreeCommandBuffers(m_device, m_commandPool, 1, &command);
-}
-
-void VulkanAppBase::CleanupImGui()
-{
-  ImGui_ImplVulkan_Shutdown();
-  ImGui_ImplGlfw_Shutdown();
-  ImGui::DestroyContext();
-}
-
-
-void VulkanAppBase::CreateInstance()
-{
-  VkApplicationInfo appinfo{};
-  appinfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-  appinfo.pApplicationName = "VulkanBook2";
-  appinfo.pEngineName = "VulkanBook2";
-  appinfo.apiVersion = VK_API_VERSION_1_1;
-  appinfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-
-  // g̎擾.
-  uint32_t count;
-  vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
-  std::vector<VkExtensionProperties> props(count);
-  vkEnumerateInstanceExtensionProperties(nullptr, &count, props.data());
-  std::vector<const char*> extensions;
-  extensions.reserve(count);
-  for (const auto& v : props)
-  {
-    extensions.push_back(v.extensionName);
-  }
-
-  VkInstanceCreateInfo instanceCI{};
-  instanceCI.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-  instanceCI.enabledExtensionCount = count;
-  instanceCI.ppEnabledExtensionNames = extensions.data();
-  instanceCI.pApplicationInfo = &appinfo;
-#ifdef _DEBUG
-  // fobOrhɂ͌؃C[L
-  const char* layers[] = { "VK_LAYER_LUNARG_standard_validation" };
-  instanceCI.enabledLayerCount = 1;
-  instanceCI.ppEnabledLayerNames = layers;
-#endif
-  auto result = vkCreateInstance(&instanceCI, nullptr, &m_vkInstance);
-  ThrowIfFailed(result, "vkCreateInstance Failed.");
-}
-
-void VulkanAppBase::SelectGraphicsQueue()
-{
-  // OtBbNXL[̃CfbNXl擾.
-  uint32_t queuePropCount;
-  vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queuePropCount, nullptr);
-  std::vector<VkQueueFamilyProperties> queueFamilyProps(queuePropCount);
-  vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queuePropCount, queueFamilyProps.data());
-  uint32_t graphicsQueue = ~0u;
-  for (uint32_t i = 0; i < queuePropCount; ++i)
-  {
-    if (queueFamilyProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
-    {
-      graphicsQueue = i; break;
-    }
-  }
-  m_gfxQueueIndex = graphicsQueue;
-}
-
-void VulkanAppBase::CreateDevice()
-{
-  const float defaultQueuePriority(1.0f);
-  VkDeviceQueueCreateInfo devQueueCI{
-    VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-    nullptr, 0,
-    m_gfxQueueIndex,
-    1, &defaultQueuePriority
-  };
-  uint32_t count;
-  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &count, nullptr);
-  std::vector<VkExtensionProperties> deviceExtensions(count);
-  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &count, deviceExtensions.data());
-
-  std::vector<const char*> extensions;
-  extensions.reserve(count);
-  for (const auto& v : deviceExtensions)
-  {
-    extensions.push_back(v.extensionName);
-  }
-
-  VkPhysicalDeviceFeatures features{};
-  vkGetPhysicalDeviceFeatures(m_physicalDevice, &features);
-
-  VkDeviceCreateInfo deviceCI{
-    VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-    nullptr, 0,
-    1, &devQueueCI,
-    0, nullptr,
-    count, extensions.data(),
-    &features
-  };
-  auto result = vkCreateDevice(m_physicalDevice, &deviceCI, nullptr, &m_device);
-  ThrowIfFailed(result, "vkCreateDevice Failed.");
-
-  vkGetDeviceQueue(m_device, m_gfxQueueIndex, 0, &m_deviceQueue);
-}
-
-void VulkanAppBase::CreateCommandPool()
-{
-  VkCommandPoolCreateInfo cmdPoolCI{
-    VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-    nullptr,
-    VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-    m_gfxQueueIndex
-  };
-  auto result = vkCreateCommandPool(m_device, &cmdPoolCI, nullptr, &m_commandPool);
-  ThrowIfFailed(result, "vkCreateCommandPool Failed.");
-}
-
-void VulkanAppBase::CreateDescriptorPool()
-{
-  VkResult result;
-  VkDescriptorPoolSize poolSize[] = {
-    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
-    { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000 },
-  };
-  VkDescriptorPoolCreateInfo descPoolCI{
-    VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-    nullptr,  VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
-    1000 * _countof(poolSize), // maxSets
-    _countof(poolSize), poolSize,
-  };
-  result = vkCreateDescriptorPool(m_device, &descPoolCI, nullptr, &m_descriptorPool);
-  ThrowIfFailed(result, "vkCreateDescriptorPool Failed.");
-}
-
-VkDeviceMemory VulkanAppBase::AllocateMemory(VkBuffer buffer, VkMemoryPropertyFlags memProps)
-{
-  VkDeviceMemory memory;
-  VkMemoryRequirements reqs;
-  vkGetBufferMemoryRequirements(m_device, buffer, &reqs);
-  VkMemoryAllocateInfo info{
-    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    nullptr,
-    reqs.size,
-    GetMemoryTypeIndex(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-  };
-  auto result = vkAllocateMemory(m_device, &info, nullptr, &memory);
-  ThrowIfFailed(result, "vkAllocateMemory Failed.");
-  return memory;
-}
-
-VkDeviceMemory VulkanAppBase::AllocateMemory(VkImage image, VkMemoryPropertyFlags memProps)
-{
-  VkDeviceMemory memory;
-  VkMemoryRequirements reqs;
-  vkGetImageMemoryRequirements(m_device, image, &reqs);
-  VkMemoryAllocateInfo info{
-    VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-    nullptr,
-    reqs.size,
-    GetMemoryTypeIndex(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-  };
-  auto result = vkAllocateMemory(m_device, &info, nullptr, &memory);
-  ThrowIfFailed(result, "vkAllocateMemory Failed.");
-  return memory;
-}
-
-
-#define GetInstanceProcAddr(FuncName) \
-  m_##FuncName = reinterpret_cast<PFN_##FuncName>(vkGetInstanceProcAddr(m_vkInstance, #FuncName))
-
-void VulkanAppBase::EnableDebugReport()
-{
-  GetInstanceProcAddr(vkCreateDebugReportCallbackEXT);
-  GetInstanceProcAddr(vkDebugReportMessageEXT);
-  GetInstanceProcAddr(vkDestroyDebugReportCallbackEXT);
-
-  VkDebugReportFlagsEXT flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT;
-
-  VkDebugReportCallbackCreateInfoEXT drcCI{};
-  drcCI.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
-  drcCI.flags = flags;
-  drcCI.pfnCallback = &DebugReportCallback;
-  auto result = m_vkCreateDebugReportCallbackEXT(m_vkInstance, &drcCI, nullptr, &m_debugReport);
-  ThrowIfFailed(result, "vkCreateDebugReportCallback Failed.");
-}
-
-void VulkanAppBase::DisableDebugReport()
-{
-  if (m_vkDestroyDebugReportCallbackEXT)
-  {
-    m_vkDestroyDebugReportCallbackEXT(m_vkInstance, m_debugReport, nullptr);
-  }
-}
-
-void VulkanAppBase::MsgLoopMinimizedWindow()
-{
-  int width, height;
-  do
-  {
-    glfwGetWindowSize(m_window, &width, &height);
-    glfwWaitEvents();
-  } while (width == 0 || height == 0);
-}
+#include "VulkanAppBase.h"
+#include "VulkanBookUtil.h"
+
+#include "imgui.h"
+#include "examples/imgui_impl_vulkan.h"
+#include "examples/imgui_impl_glfw.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+
+// ステージング用リングバッファのサイズ.
+static const VkDeviceSize StagingBufferSize = 16 * 1024 * 1024;
+// 再利用リストが空のときにまとめて確保するコマンドバッファの数.
+static const uint32_t CommandBufferAllocationBatch = 8;
+// フレーム統計を出力する間隔(フレーム数).
+static const uint32_t FrameStatisticsInterval = 600;
+// パイプラインキャッシュの保存先(作業ディレクトリ).
+static const char* PipelineCacheFileName = "pipeline_cache.bin";
+// CPU フェーズ計測の出力先(終了時に書き出す).
+static const char* CpuPhaseJsonFileName = "cpu_phases.json";
+static const char* CpuPhaseCsvFileName = "cpu_phases.csv";
+// HUD からのメモリレポートの出力先.
+static const char* MemoryReportFileName = "memory_report.txt";
+// ImGui 用のディスクリプタプールのセット数.
+static const uint32_t ImGuiDescriptorSets = 16;
+// HUD からのトレースの出力先と記録するフレーム数.
+static const char* TraceFileName = "trace.json";
+static const uint32_t TraceCaptureFrames = 120;
+// ベンチマークでディスクリプタの更新を比べるセット数.
+static const uint32_t DescriptorUpdateBenchmarkSets = 4096;
+// オブジェクト検索のベンチマークで繰り返すフレーム数.
+static const uint32_t ObjectLookupBenchmarkFrames = 100000;
+// ユニフォーム更新のベンチマークで繰り返すフレーム数.
+static const uint32_t UniformUpdateBenchmarkFrames = 10000;
+// バインドレスの配列の要素数. デバイスの上限の方が小さければそちらに合わせる.
+static const uint32_t BindlessMaxTextures = 1024;
+static const uint32_t BindlessMaxBuffers = 256;
+// 使用する物理デバイスを番号または名前の一部で指定する環境変数.
+static const char* PreferredDeviceEnvName = "VULKAN_BOOK_DEVICE";
+// ヘッドレス実行時に用意するオフスクリーンイメージの数.
+static const uint32_t HeadlessImageCount = 2;
+
+// ホストの時間領域の現在値. vkGetCalibratedTimestampsEXT が返す値と同じ単位(QPC はカウント、それ以外はナノ秒).
+static uint64_t GetHostTimestamp(VkTimeDomainEXT domain)
+{
+#if defined(_WIN32)
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return uint64_t(counter.QuadPart);
+#else
+  timespec ts;
+  clock_gettime(domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT ? CLOCK_MONOTONIC_RAW : CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+#endif
+}
+
+// ホストの時間領域の値 1 あたりのナノ秒.
+static double GetHostNanosecondsPerTick(VkTimeDomainEXT domain)
+{
+#if defined(_WIN32)
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  return 1.0e9 / double(frequency.QuadPart);
+#else
+  return 1.0;
+#endif
+}
+
+static bool HasExtension(const std::vector<VkExtensionProperties>& props, const char* name)
+{
+  return std::any_of(props.begin(), props.end(),
+    [&](const VkExtensionProperties& v) { return strcmp(v.extensionName, name) == 0; });
+}
+
+// 必須の拡張や機能のうち、デバイスが対応していない最初のもの. 全て対応していれば空.
+static std::string FindUnsupportedCapability(VkPhysicalDevice physDev, const VulkanAppBase::CapabilityProfile& profile)
+{
+  uint32_t count = 0;
+  vkEnumerateDeviceExtensionProperties(physDev, nullptr, &count, nullptr);
+  std::vector<VkExtensionProperties> props(count);
+  vkEnumerateDeviceExtensionProperties(physDev, nullptr, &count, props.data());
+  for (auto name : profile.deviceExtensions)
+  {
+    if (!HasExtension(props, name))
+    {
+      return std::string("extension ") + name;
+    }
+  }
+
+  // VkPhysicalDeviceFeatures は VkBool32 の並びとして比較する.
+  VkPhysicalDeviceFeatures supported{};
+  vkGetPhysicalDeviceFeatures(physDev, &supported);
+  auto requested = reinterpret_cast<const VkBool32*>(&profile.features);
+  auto available = reinterpret_cast<const VkBool32*>(&supported);
+  for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); ++i)
+  {
+    if (requested[i] && !available[i])
+    {
+      return "feature VkPhysicalDeviceFeatures[" + std::to_string(i) + "]";
+    }
+  }
+  return std::string();
+}
+
+static VkBool32 VKAPI_CALL DebugReportCallback(
+  VkDebugReportFlagsEXT flags,
+  VkDebugReportObjectTypeEXT objactTypes,
+  uint64_t object,
+  size_t	location,
+  int32_t messageCode,
+  const char* pLayerPrefix,
+  const char* pMessage,
+  void* pUserData)
+{
+  VkBool32 ret = VK_FALSE;
+  if (flags & VK_DEBUG_REPORT_INFORMATION_BIT_EXT ||
+    flags & VK_DEBUG_REPORT_DEBUG_BIT_EXT)
+  {
+    ret = VK_TRUE;
+  }
+  std::stringstream ss;
+  if (pLayerPrefix)
+  {
+    ss << "[" << pLayerPrefix << "] ";
+  }
+  ss << pMessage << std::endl;
+
+  book_util::WriteLog(ss.str().c_str());
+
+  return ret;
+}
+
+
+bool VulkanAppBase::OnSizeChanged(uint32_t width, uint32_t height)
+{
+  m_isMinimizedWindow = (width == 0 || height == 0);
+  if (m_isMinimizedWindow)
+  {
+    return false;
+  }
+  vkDeviceWaitIdle(m_device);
+
+  auto format = m_swapchain->GetSurfaceFormat().format;
+  // スワップチェインを作り直す.
+  m_swapchain->Prepare(m_physicalDevice, m_gfxQueueIndex, width, height, format);
+  return true;
+}
+
+bool VulkanAppBase::OnMouseButtonDown(int button)
+{
+  return ImGui::GetIO().WantCaptureMouse;
+}
+
+bool VulkanAppBase::OnMouseButtonUp(int button)
+{
+  return ImGui::GetIO().WantCaptureMouse;
+}
+
+bool VulkanAppBase::OnMouseMove(int dx, int dy)
+{
+  return ImGui::GetIO().WantCaptureMouse;
+}
+
+
+uint32_t VulkanAppBase::GetMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestProps) const
+{
+  uint32_t result = ~0u;
+  for (uint32_t i = 0; i < m_physicalMemProps.memoryTypeCount; ++i)
+  {
+    if (requestBits & 1)
+    {
+      const auto& types = m_physicalMemProps.memoryTypes[i];
+      if ((types.propertyFlags & requestProps) == requestProps)
+      {
+        result = i;
+        break;
+      }
+    }
+    requestBits >>= 1;
+  }
+  return result;
+}
+
+void VulkanAppBase::SwitchFullscreen(GLFWwindow* window)
+{
+  static int lastWindowPosX, lastWindowPosY;
+  static int lastWindowSizeW, lastWindowSizeH;
+
+  auto monitor = glfwGetPrimaryMonitor();
+  const auto mode = glfwGetVideoMode(monitor);
+
+#if 1 // 現在のモニターに合わせたサイズへ変更.
+  if (!m_isFullscreen)
+  {
+    // to fullscreen
+    glfwGetWindowPos(window, &lastWindowPosX, &lastWindowPosY);
+    glfwGetWindowSize(window, &lastWindowSizeW, &lastWindowSizeH);
+    glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
+  }
+  else
+  {
+    // to windowmode
+    glfwSetWindowMonitor(window, nullptr, lastWindowPosX, lastWindowPosY, lastWindowSizeW, lastWindowSizeH, mode->refreshRate);
+  }
+#else
+  // 指定された解像度へモニターを変更.
+  if (!m_isFullscreen)
+  {
+    // to fullscreen
+    glfwGetWindowPos(window, &lastWindowPosX, &lastWindowPosY);
+    glfwGetWindowSize(window, &lastWindowSizeW, &lastWindowSizeH);
+    glfwSetWindowMonitor(window, monitor, 0, 0, lastWindowSizeW, lastWindowSizeH, mode->refreshRate);
+  }
+  else
+  {
+    // to windowmode
+    glfwSetWindowMonitor(window, nullptr, lastWindowPosX, lastWindowPosY, lastWindowSizeW, lastWindowSizeH, mode->refreshRate);
+  }
+#endif
+  m_isFullscreen = !m_isFullscreen;
+}
+
+void VulkanAppBase::Initialize(GLFWwindow* window, VkFormat format, bool isFullscreen)
+{
+  m_window = window;
+  m_isHeadless = false;
+  InitializeDevice();
+
+  VkSurfaceKHR surface;
+  auto result = glfwCreateWindowSurface(m_vkInstance, window, nullptr, &surface);
+  ThrowIfFailed(result, "glfwCreateWindowSurface Failed.");
+
+  // スワップチェインの生成.
+  m_swapchain = std::make_unique<Swapchain>(m_vkInstance, m_device, surface);
+
+  int width, height;
+  glfwGetWindowSize(window, &width, &height);
+  m_swapchain->Prepare(
+    m_physicalDevice, m_gfxQueueIndex,
+    uint32_t(width), uint32_t(height),
+    format
+  );
+  LapStartupStage("Swapchain");
+
+  InitializeResources();
+}
+
+void VulkanAppBase::InitializeHeadless(uint32_t width, uint32_t height, VkFormat format)
+{
+  m_window = nullptr;
+  m_isHeadless = true;
+  InitializeDevice();
+
+  // スワップチェインの代わりにオフスクリーンのカラーイメージを用意する.
+  // 描画後に読み戻せるよう転送元としても使用可能にしておく.
+  std::vector<VkImage> images;
+  std::vector<VkImageView> views;
+  for (uint32_t i = 0; i < HeadlessImageCount; ++i)
+  {
+    auto image = CreateTexture(width, height, format,
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    images.push_back(image.image);
+    views.push_back(image.view);
+    m_offscreenImages.push_back(image);
+  }
+  m_offscreenImageFences.assign(HeadlessImageCount, VK_NULL_HANDLE);
+  m_swapchain = std::make_unique<Swapchain>(m_vkInstance, m_device, VkSurfaceKHR(VK_NULL_HANDLE));
+  m_swapchain->PrepareOffscreen(width, height, format, images, views);
+  LapStartupStage("Swapchain");
+
+  InitializeResources();
+}
+
+void VulkanAppBase::InitializeDevice()
+{
+  m_startupTimings.clear();
+  m_startupLap = std::chrono::high_resolution_clock::now();
+  m_capabilityProfile = GetCapabilityProfile();
+
+  CreateInstance();
+  LapStartupStage("Instance");
+
+  // 物理デバイスの選択.
+  uint32_t count;
+  vkEnumeratePhysicalDevices(m_vkInstance, &count, nullptr);
+  std::vector<VkPhysicalDevice> physicalDevices(count);
+  vkEnumeratePhysicalDevices(m_vkInstance, &count, physicalDevices.data());
+  m_physicalDevice = SelectPhysicalDevice(physicalDevices);
+  vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_physicalMemProps);
+  vkGetPhysicalDeviceProperties(m_physicalDevice, &m_physicalDeviceProps);
+
+  // グラフィックス/転送/コンピュートのキューインデックス取得.
+  SelectQueueFamilies();
+
+#ifdef _DEBUG
+  EnableDebugReport();
+#endif
+  // 論理デバイスの生成.
+  CreateDevice();
+  LapStartupStage("Device");
+
+  // 前回の実行で保存したパイプラインキャッシュを読み込む.
+  CreatePipelineCache();
+  m_shaderLibrary = std::make_unique<ShaderLibrary>(m_device);
+  LapStartupStage("PipelineCache");
+
+  // デバイスメモリのサブアロケータ.
+  m_memoryAllocator = std::make_unique<DeviceMemoryAllocator>(
+    m_device, m_physicalMemProps, m_physicalDeviceProps.limits.nonCoherentAtomSize);
+
+  // コマンドプールの生成.
+  CreateCommandPool();
+
+  // ステージングを経由した転送の管理.
+  // 転送専用キューがあればそちらで転送し、所有権をグラフィックスキューへ移す.
+  m_uploadManager = std::make_unique<UploadManager>(
+    m_device, m_memoryAllocator.get(),
+    m_transferQueue, m_transferQueueIndex,
+    m_deviceQueue, m_gfxQueueIndex,
+    StagingBufferSize);
+  LapStartupStage("Allocators");
+}
+
+void VulkanAppBase::InitializeResources()
+{
+  m_traceRecorder = std::make_unique<TraceRecorder>();
+  m_cpuProfiler = std::make_unique<CpuProfiler>();
+  m_cpuProfiler->SetTraceRecorder(m_traceRecorder.get());
+
+  // 同時に処理するフレーム分の同期オブジェクトとコマンドバッファ.
+  CreateFrameContexts();
+  LapStartupStage("FrameContexts");
+
+  // ディスクリプタプールの生成.
+  CreateDescriptorPool();
+  LapStartupStage("DescriptorPool");
+
+  m_renderPassStore = std::make_unique<RenderPassRegistry>(m_device, vkDestroyRenderPass);
+  m_descriptorSetLayoutStore = std::make_unique<DescriptorSetLayoutManager>(m_device, vkDestroyDescriptorSetLayout);
+  m_pipelineLayoutStore = std::make_unique<PipelineLayoutManager>(m_device, vkDestroyPipelineLayout);
+  m_descriptorUpdateTemplateStore = std::make_unique<DescriptorUpdateTemplateManager>(m_device, vkDestroyDescriptorUpdateTemplate);
+
+  m_driverObjectStats = DriverObjectStatistics{};
+  auto uploadStats = m_uploadManager->GetStatistics();
+
+  auto prepareBegin = std::chrono::high_resolution_clock::now();
+  Prepare();
+  LapStartupStage("Prepare");
+  PrepareImGui();
+  LapStartupStage("ImGui");
+  auto prepareEnd = std::chrono::high_resolution_clock::now();
+  ReportPipelineCacheStatistics(std::chrono::duration<double, std::milli>(prepareEnd - prepareBegin).count());
+  ReportShaderStatistics();
+
+  // パイプラインの生成が済んだのでシェーダーモジュールは不要.
+  m_shaderLibrary->Release();
+
+  // Prepare と ImGui の準備で積まれた転送をまとめて発行する.
+  m_uploadManager->Submit();
+  LapStartupStage("Upload");
+  ReportStartupTimings();
+  ReportMemoryStatistics();
+  ReportUploadStatistics();
+  ReportDriverObjectStatistics(uploadStats);
+  ReportDescriptorStatistics();
+  ReportObjectStores();
+}
+
+void VulkanAppBase::LapStartupStage(const char* name)
+{
+  auto now = std::chrono::high_resolution_clock::now();
+  m_startupTimings.emplace_back(name, std::chrono::duration<double, std::milli>(now - m_startupLap).count());
+  m_startupLap = now;
+}
+
+void VulkanAppBase::ReportStartupTimings()
+{
+  // 表示の処理は次の区切りに含まれないよう、ここでの出力は最後に行う.
+  double totalMs = 0.0;
+  std::stringstream ss;
+  ss << "[Startup]";
+  for (const auto& stage : m_startupTimings)
+  {
+    ss << " " << stage.first << ": " << stage.second << "ms,";
+    totalMs += stage.second;
+  }
+  ss << " total: " << totalMs << "ms" << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+VkPhysicalDevice VulkanAppBase::SelectPhysicalDevice(const std::vector<VkPhysicalDevice>& physicalDevices)
+{
+  if (physicalDevices.empty())
+  {
+    throw book_util::VulkanException("No Vulkan physical device found.");
+  }
+
+  // 指定はコマンドラインを優先し、無ければ環境変数を使う.
+  auto preferred = m_preferredDevice;
+  const char* source = "command line";
+  if (preferred.empty())
+  {
+    preferred = book_util::GetEnvironmentValue(PreferredDeviceEnvName);
+    if (!preferred.empty())
+    {
+      source = PreferredDeviceEnvName;
+    }
+  }
+
+  // 数字のみの場合は番号とみなす.
+  auto isIndex = !preferred.empty() && std::all_of(preferred.begin(), preferred.end(), [](char c) { return c >= '0' && c <= '9'; });
+
+  std::stringstream log;
+  log << "[Device] candidates:" << std::endl;
+  int bestScore = -1;
+  uint32_t bestIndex = 0;
+  int preferredIndex = -1;
+  std::string preferredReason;
+  for (uint32_t i = 0; i < uint32_t(physicalDevices.size()); ++i)
+  {
+    std::string reason;
+    auto score = ScorePhysicalDevice(physicalDevices[i], reason);
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physicalDevices[i], &props);
+    log << "  " << i << ": " << props.deviceName << " score " << score << " (" << reason << ")" << std::endl;
+
+    if (!preferred.empty() && preferredIndex < 0 &&
+      (isIndex ? preferred == std::to_string(i) : strstr(props.deviceName, preferred.c_str()) != nullptr))
+    {
+      preferredIndex = int(i);
+      if (score < 0)
+      {
+        preferredReason = reason;
+      }
+    }
+    if (score > bestScore)
+    {
+      bestScore = score;
+      bestIndex = i;
+    }
+  }
+
+  if (!preferred.empty() && preferredIndex < 0)
+  {
+    book_util::WriteLog(log.str().c_str());
+    throw book_util::VulkanException("No physical device matches \"" + preferred + "\" (" + source + ").");
+  }
+  if (!preferred.empty() && !preferredReason.empty())
+  {
+    // 使えないデバイスのまま進めると、後の作成処理で分かりにくい失敗となるためここで弾く.
+    // コマンドラインでの指定はエラーとし、環境変数での指定は無視して最も良いデバイスを選ぶ.
+    log << "[Device] " << preferredIndex << " (" << source << " \"" << preferred << "\") is not usable: " << preferredReason << std::endl;
+    if (source != PreferredDeviceEnvName)
+    {
+      book_util::WriteLog(log.str().c_str());
+      throw book_util::VulkanException("Physical device \"" + preferred + "\" (" + source + ") is not usable: " + preferredReason + ".");
+    }
+    preferredIndex = -1;
+  }
+
+  if (preferredIndex >= 0)
+  {
+    bestIndex = uint32_t(preferredIndex);
+    log << "[Device] selected " << bestIndex << " by " << source << " \"" << preferred << "\"" << std::endl;
+  }
+  else if (bestScore < 0)
+  {
+    book_util::WriteLog(log.str().c_str());
+    throw book_util::VulkanException("No physical device supports the capability profile.");
+  }
+  else
+  {
+    log << "[Device] selected " << bestIndex << " by highest score" << std::endl;
+  }
+  book_util::WriteLog(log.str().c_str());
+  return physicalDevices[bestIndex];
+}
+
+int VulkanAppBase::ScorePhysicalDevice(VkPhysicalDevice physDev, std::string& reason)
+{
+  VkPhysicalDeviceProperties props;
+  vkGetPhysicalDeviceProperties(physDev, &props);
+  if (props.apiVersion < VK_API_VERSION_1_1)
+  {
+    reason = "Vulkan 1.1 not supported";
+    return -1;
+  }
+  reason = FindUnsupportedCapability(physDev, m_capabilityProfile);
+  if (!reason.empty())
+  {
+    reason = "missing " + reason;
+    return -1;
+  }
+
+  uint32_t queueCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physDev, &queueCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueProps(queueCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physDev, &queueCount, queueProps.data());
+  bool hasGraphics = false, hasAsyncCompute = false, hasTransfer = false;
+  for (const auto& q : queueProps)
+  {
+    hasGraphics |= (q.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+    if (!(q.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+    {
+      hasAsyncCompute |= (q.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+      hasTransfer |= (q.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(q.queueFlags & VK_QUEUE_COMPUTE_BIT);
+    }
+  }
+  if (!hasGraphics)
+  {
+    reason = "no graphics queue";
+    return -1;
+  }
+
+  // 種類を最も重く見て、同じ種類ならデバイスローカルのヒープが大きいものを選ぶ.
+  int score = 0;
+  std::stringstream ss;
+  switch (props.deviceType)
+  {
+  case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 10000; ss << "discrete"; break;
+  case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 5000; ss << "integrated"; break;
+  case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 2000; ss << "virtual"; break;
+  case VK_PHYSICAL_DEVICE_TYPE_CPU: score += 1000; ss << "cpu"; break;
+  default: ss << "other"; break;
+  }
+
+  VkPhysicalDeviceMemoryProperties memProps;
+  vkGetPhysicalDeviceMemoryProperties(physDev, &memProps);
+  VkDeviceSize localBytes = 0;
+  for (uint32_t i = 0; i < memProps.memoryHeapCount; ++i)
+  {
+    if (memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+    {
+      localBytes = (std::max)(localBytes, memProps.memoryHeaps[i].size);
+    }
+  }
+  auto localMB = int((std::min)(localBytes / (1024 * 1024), VkDeviceSize(64 * 1024)));
+  score += localMB / 64;
+  ss << ", " << localMB << "MB local";
+
+  if (hasAsyncCompute)
+  {
+    score += 100;
+    ss << ", async compute";
+  }
+  if (hasTransfer)
+  {
+    score += 100;
+    ss << ", transfer queue";
+  }
+  if (props.limits.timestampComputeAndGraphics)
+  {
+    score += 10;
+    ss << ", timestamps";
+  }
+  reason = ss.str();
+  return score;
+}
+
+VulkanAppBase::CapabilityProfile VulkanAppBase::GetCapabilityProfile()
+{
+  CapabilityProfile profile{};
+  if (!m_isHeadless)
+  {
+    uint32_t count = 0;
+    auto names = glfwGetRequiredInstanceExtensions(&count);
+    profile.instanceExtensions.assign(names, names + count);
+    profile.deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+  }
+#ifdef _DEBUG
+  profile.instanceExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+  profile.features.robustBufferAccess = VK_TRUE;
+#endif
+  profile.optionalDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  // トレースで GPU のタイムスタンプを CPU の時刻へ変換する.
+  profile.optionalDeviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+  // GPU プロファイラのパイプライン統計.
+  profile.optionalFeatures.pipelineStatisticsQuery = VK_TRUE;
+  return profile;
+}
+
+void VulkanAppBase::Terminate()
+{
+  if (m_device != VK_NULL_HANDLE)
+  {
+    vkDeviceWaitIdle(m_device);
+  }
+  if (m_traceRecorder && m_traceRecorder->IsActive())
+  {
+    // 記録の途中で終了した場合は、完了済みの GPU の結果を取り込んでから書き出す.
+    m_gpuProfiler->CollectAll();
+    ReportTraceCapture(m_traceRecorder->Finish());
+  }
+  if (m_frameRecorder)
+  {
+    ReportFrameRecorderStatistics();
+    m_frameRecorder.reset();
+  }
+  Cleanup();
+
+  if (m_cpuProfiler)
+  {
+    ReportCpuPhaseStatistics();
+    m_cpuProfiler->ExportJson(CpuPhaseJsonFileName);
+    m_cpuProfiler->ExportCsv(CpuPhaseCsvFileName);
+  }
+
+  if (m_uniformRing)
+  {
+    m_uniformRing.reset();
+    DestroyBuffer(m_uniformRingBuffer);
+  }
+
+  CleanupImGui();
+
+  if (m_swapchain)
+  {
+    m_swapchain->Cleanup();
+  }
+  for (auto& image : m_offscreenImages)
+  {
+    DestroyImage(image);
+  }
+  m_offscreenImages.clear();
+  m_offscreenImageFences.clear();
+#ifdef _DEBUG
+  DisableDebugReport();
+#endif
+
+  m_renderPassStore->Cleanup();
+  m_descriptorUpdateTemplateStore->Cleanup();
+  m_descriptorUpdateTemplates.clear();
+  m_descriptorSetLayoutStore->Cleanup();
+  m_pipelineLayoutStore->Cleanup();
+
+  DestroyFrameContexts();
+
+  // 次回の起動のためにパイプラインキャッシュを書き出す.
+  SavePipelineCache();
+  vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+  m_pipelineCache = VK_NULL_HANDLE;
+
+  m_bindlessTable.reset();
+  m_renderGraphs.clear();
+  m_descriptorAllocator.reset();
+  vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+  for (auto fence : m_freeFences)
+  {
+    vkDestroyFence(m_device, fence, nullptr);
+  }
+  m_freeFences.clear();
+  // 再利用待ちのコマンドバッファはプールと共に解放される.
+  m_freeCommandBuffers.clear();
+  vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+  vkDestroyCommandPool(m_device, m_computeCommandPool, nullptr);
+  m_uploadManager.reset();
+  m_shaderLibrary.reset();
+  m_memoryAllocator.reset();
+  vkDestroyDevice(m_device, nullptr);
+  vkDestroyInstance(m_vkInstance, nullptr);
+  m_commandPool = VK_NULL_HANDLE;
+  m_computeCommandPool = VK_NULL_HANDLE;
+  m_device = VK_NULL_HANDLE;
+  m_vkInstance = VK_NULL_HANDLE;
+}
+
+VulkanAppBase::BufferObject VulkanAppBase::CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
+{
+  return CreateBuffer(size, usage, props, GetBufferCategory(usage));
+}
+
+VulkanAppBase::BufferObject VulkanAppBase::CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, MemoryCategory category)
+{
+  BufferObject obj;
+  VkBufferCreateInfo bufferCI{
+    VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+    nullptr, 0,
+    size, usage,
+    VK_SHARING_MODE_EXCLUSIVE,
+    0, nullptr
+  };
+  auto result = vkCreateBuffer(m_device, &bufferCI, nullptr, &obj.buffer);
+  ThrowIfFailed(result, "vkCreateBuffer Failed.");
+
+  obj.allocation = AllocateMemory(obj.buffer, props, category);
+  result = vkBindBufferMemory(m_device, obj.buffer, obj.allocation.memory, obj.allocation.offset);
+  ThrowIfFailed(result, "vkBindBufferMemory Failed.");
+  return obj;
+}
+
+VulkanAppBase::ImageObject VulkanAppBase::CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage)
+{
+  ImageObject obj;
+  VkImageCreateInfo imageCI{
+    VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    nullptr, 0,
+    VK_IMAGE_TYPE_2D,
+    format, { width, height, 1 },
+    1, 1, VK_SAMPLE_COUNT_1_BIT,
+    VK_IMAGE_TILING_OPTIMAL,
+    usage,
+    VK_SHARING_MODE_EXCLUSIVE,
+    0, nullptr,
+    VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  auto result = vkCreateImage(m_device, &imageCI, nullptr, &obj.image);
+  ThrowIfFailed(result, "vkCreateImage Failed.");
+
+  obj.allocation = AllocateMemory(obj.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GetImageCategory(usage));
+  result = vkBindImageMemory(m_device, obj.image, obj.allocation.memory, obj.allocation.offset);
+  ThrowIfFailed(result, "vkBindImageMemory Failed.");
+
+  VkImageAspectFlags imageAspect = VK_IMAGE_ASPECT_COLOR_BIT;
+  if (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+  {
+    imageAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+  }
+
+  VkImageViewCreateInfo viewCI{
+    VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+    nullptr, 0,
+    obj.image,
+    VK_IMAGE_VIEW_TYPE_2D,
+    imageCI.format,
+    book_util::DefaultComponentMapping(),
+    { imageAspect, 0, 1, 0, 1}
+  };
+  result = vkCreateImageView(m_device, &viewCI, nullptr, &obj.view);
+  ThrowIfFailed(result, "vkCreateImageView Failed.");
+  return obj;
+}
+
+void VulkanAppBase::DestroyBuffer(BufferObject bufferObj)
+{
+  vkDestroyBuffer(m_device, bufferObj.buffer, nullptr);
+  FreeMemory(bufferObj.allocation);
+  InvalidateDescriptorCache(bufferObj.buffer);
+}
+
+void VulkanAppBase::DestroyImage(ImageObject imageObj)
+{
+  vkDestroyImage(m_device, imageObj.image, nullptr);
+  FreeMemory(imageObj.allocation);
+  if (imageObj.view != VK_NULL_HANDLE)
+  {
+    vkDestroyImageView(m_device, imageObj.view, nullptr);
+    InvalidateDescriptorCache(imageObj.view);
+  }
+}
+
+VkFramebuffer VulkanAppBase::CreateFramebuffer(
+  VkRenderPass renderPass, uint32_t width, uint32_t height, uint32_t viewCount, VkImageView* views)
+{
+  VkFramebufferCreateInfo fbCI{
+    VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+    nullptr, 0,
+    renderPass,
+    viewCount, views,
+    width, height,
+    1,
+  };
+  VkFramebuffer framebuffer;
+  auto result = vkCreateFramebuffer(m_device, &fbCI, nullptr, &framebuffer);
+  ThrowIfFailed(result, "vkCreateFramebuffer Failed.");
+  return framebuffer;
+}
+void VulkanAppBase::DestroyFramebuffers(uint32_t count, VkFramebuffer* framebuffers)
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    vkDestroyFramebuffer(m_device, framebuffers[i], nullptr);
+  }
+}
+VkFence VulkanAppBase::CreateFence()
+{
+  VkFenceCreateInfo fenceCI{
+    VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    nullptr,
+    VK_FENCE_CREATE_SIGNALED_BIT
+  };
+  VkFence fence;
+  auto result = vkCreateFence(m_device, &fenceCI, nullptr, &fence);
+  ThrowIfFailed(result, "vkCreateFence Failed.");
+  m_driverObjectStats.fenceRequests++;
+  m_driverObjectStats.fenceCreations++;
+  return fence;
+}
+void VulkanAppBase::DestroyFence(VkFence fence)
+{
+  vkDestroyFence(m_device, fence, nullptr);
+}
+
+VkDescriptorSet VulkanAppBase::AllocateDescriptorSet(VkDescriptorSetLayout dsLayout)
+{
+  return m_descriptorAllocator->Allocate(dsLayout);
+}
+
+VkDescriptorSet VulkanAppBase::AllocateFrameDescriptorSet(VkDescriptorSetLayout dsLayout)
+{
+  return m_descriptorAllocator->AllocateFrame(dsLayout);
+}
+
+VkDescriptorSet VulkanAppBase::GetDescriptorSet(VkDescriptorSetLayout dsLayout, const std::vector<VkWriteDescriptorSet>& writes)
+{
+  return m_descriptorAllocator->GetOrCreate(dsLayout, writes);
+}
+
+VulkanAppBase::DescriptorUpdateTemplateHandle VulkanAppBase::RegisterDescriptorUpdateTemplate(const std::string& layoutName, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+  DescriptorUpdateTemplateInfo info{};
+  info.entries = book_util::CreateDescriptorUpdateTemplateEntries(bindings);
+  for (const auto& e : info.entries)
+  {
+    info.dataSize = (std::max)(info.dataSize, e.offset + e.stride * e.descriptorCount);
+  }
+
+  VkDescriptorUpdateTemplateCreateInfo templateCI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO, nullptr, 0,
+    uint32_t(info.entries.size()), info.entries.data(),
+    VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+    GetDescriptorSetLayout(layoutName),
+    VK_PIPELINE_BIND_POINT_GRAPHICS, VK_NULL_HANDLE, 0
+  };
+  VkDescriptorUpdateTemplate updateTemplate;
+  auto result = vkCreateDescriptorUpdateTemplate(m_device, &templateCI, nullptr, &updateTemplate);
+  ThrowIfFailed(result, "vkCreateDescriptorUpdateTemplate Failed.");
+  info.updateTemplate = m_descriptorUpdateTemplateStore->Register(layoutName, updateTemplate);
+  info.setLayout = FindDescriptorSetLayout(layoutName);
+  auto handle = info.updateTemplate;
+  m_descriptorUpdateTemplates.resize(m_descriptorUpdateTemplateStore->GetCount());
+  m_descriptorUpdateTemplates[handle.index] = std::move(info);
+  return handle;
+}
+
+const VulkanAppBase::DescriptorUpdateTemplateInfo& VulkanAppBase::GetDescriptorUpdateTemplateInfo(DescriptorUpdateTemplateHandle updateTemplate, const void* data, size_t dataSize)
+{
+  if (updateTemplate.index >= m_descriptorUpdateTemplates.size())
+  {
+    throw book_util::VulkanException("DescriptorUpdateTemplate is not registered.");
+  }
+  // 構造体の並びがバインディングと食い違っていないか、大きさだけは確かめる.
+  auto& info = m_descriptorUpdateTemplates[updateTemplate.index];
+  if (info.dataSize != dataSize)
+  {
+    throw book_util::VulkanException("DescriptorUpdateTemplate data size mismatch.");
+  }
+  auto bytes = static_cast<const uint8_t*>(data);
+  info.lastData.assign(bytes, bytes + dataSize);
+  return info;
+}
+
+void VulkanAppBase::UpdateDescriptorSetWithTemplate(VkDescriptorSet descriptorSet, DescriptorUpdateTemplateHandle updateTemplate, const void* data, size_t dataSize)
+{
+  const auto& info = GetDescriptorUpdateTemplateInfo(updateTemplate, data, dataSize);
+  vkUpdateDescriptorSetWithTemplate(m_device, descriptorSet, m_descriptorUpdateTemplateStore->Get(info.updateTemplate), data);
+}
+
+VkDescriptorSet VulkanAppBase::GetDescriptorSetWithTemplate(DescriptorUpdateTemplateHandle updateTemplate, const void* data, size_t dataSize)
+{
+  const auto& info = GetDescriptorUpdateTemplateInfo(updateTemplate, data, dataSize);
+  return m_descriptorAllocator->GetOrCreate(
+    GetDescriptorSetLayout(info.setLayout), m_descriptorUpdateTemplateStore->Get(info.updateTemplate), info.entries, data);
+}
+
+
+VkCommandBuffer VulkanAppBase::CreateCommandBuffer(bool bBegin)
+{
+  m_driverObjectStats.commandBufferRequests++;
+  if (m_freeCommandBuffers.empty())
+  {
+    // 1 つずつではなくまとめて確保しておく.
+    VkCommandBufferAllocateInfo commandAI{
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      nullptr, m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      CommandBufferAllocationBatch
+    };
+    m_freeCommandBuffers.resize(CommandBufferAllocationBatch);
+    auto result = vkAllocateCommandBuffers(m_device, &commandAI, m_freeCommandBuffers.data());
+    ThrowIfFailed(result, "vkAllocateCommandBuffers Failed.");
+    m_driverObjectStats.commandBufferAllocateCalls++;
+  }
+  auto command = m_freeCommandBuffers.back();
+  m_freeCommandBuffers.pop_back();
+
+  VkCommandBufferBeginInfo beginInfo{
+    VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+  };
+  if (bBegin)
+  {
+    vkBeginCommandBuffer(command, &beginInfo);
+  }
+  return command;
+}
+
+void VulkanAppBase::FinishCommandBuffer(VkCommandBuffer command)
+{
+  // 積まれている転送を先に発行し、キュー上の順序を保つ.
+  m_uploadManager->Submit();
+
+  auto result = vkEndCommandBuffer(command);
+  ThrowIfFailed(result, "vkEndCommandBuffer Failed.");
+
+  // 完了待ち用のフェンスは使い回す.
+  m_driverObjectStats.fenceRequests++;
+  if (m_freeFences.empty())
+  {
+    VkFenceCreateInfo fenceCI{
+      VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+      nullptr, 0
+    };
+    VkFence fence;
+    result = vkCreateFence(m_device, &fenceCI, nullptr, &fence);
+    ThrowIfFailed(result, "vkCreateFence Failed.");
+    m_freeFences.push_back(fence);
+    m_driverObjectStats.fenceCreations++;
+  }
+  auto fence = m_freeFences.back();
+  m_freeFences.pop_back();
+
+  VkSubmitInfo submitInfo{
+    VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    nullptr,
+    0, nullptr,
+    nullptr,
+    1, &command,
+    0, nullptr,
+  };
+  result = vkQueueSubmit(m_deviceQueue, 1, &submitInfo, fence);
+  ThrowIfFailed(result, "vkQueueSubmit Failed.");
+  vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
+  vkResetFences(m_device, 1, &fence);
+  m_freeFences.push_back(fence);
+}
+
+void VulkanAppBase::DestroyCommandBuffer(VkCommandBuffer command)
+{
+  // プールへは返さず、リセットして再利用する.
+  vkResetCommandBuffer(command, 0);
+  m_freeCommandBuffers.push_back(command);
+}
+
+VkCommandBuffer VulkanAppBase::CreateComputeCommandBuffer()
+{
+  VkCommandBufferAllocateInfo commandAI{
+    VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    nullptr, m_computeCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    1
+  };
+  VkCommandBuffer command;
+  auto result = vkAllocateCommandBuffers(m_device, &commandAI, &command);
+  ThrowIfFailed(result, "vkAllocateCommandBuffers Failed.");
+  return command;
+}
+
+void VulkanAppBase::DestroyComputeCommandBuffer(VkCommandBuffer command)
+{
+  vkFreeCommandBuffers(m_device, m_computeCommandPool, 1, &command);
+}
+
+void VulkanAppBase::CreateFrameContexts()
+{
+  VkSemaphoreCreateInfo semCI{
+    VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+    nullptr, 0,
+  };
+  VkCommandPoolCreateInfo cmdPoolCI{
+    VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    nullptr,
+    VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+    m_gfxQueueIndex
+  };
+  VkResult result;
+  m_frames.resize(m_framesInFlight);
+  for (auto& frame : m_frames)
+  {
+    result = vkCreateSemaphore(m_device, &semCI, nullptr, &frame.presentCompleted);
+    ThrowIfFailed(result, "vkCreateSemaphore Failed.");
+    result = vkCreateSemaphore(m_device, &semCI, nullptr, &frame.renderCompleted);
+    ThrowIfFailed(result, "vkCreateSemaphore Failed.");
+    frame.fence = CreateFence();
+
+    // フレームごとのプールは、完了を待った後にまとめてリセットする.
+    result = vkCreateCommandPool(m_device, &cmdPoolCI, nullptr, &frame.commandPool);
+    ThrowIfFailed(result, "vkCreateCommandPool Failed.");
+    VkCommandBufferAllocateInfo commandAI{
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      nullptr, frame.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      1
+    };
+    result = vkAllocateCommandBuffers(m_device, &commandAI, &frame.commandBuffer);
+    ThrowIfFailed(result, "vkAllocateCommandBuffers Failed.");
+  }
+  m_frameIndex = 0;
+  m_frameStats = FrameStatistics{};
+
+  // 区間はグラフィックスとコンピュートのキューで記録するため、有効なビットの少ない方に合わせる.
+  // タイムスタンプに対応していないコンピュートキューでは区間を記録しない(GetComputeProfiler).
+  auto timestampValidBits = m_gfxTimestampValidBits;
+  if (m_computeTimestampValidBits != 0)
+  {
+    timestampValidBits = (std::min)(timestampValidBits, m_computeTimestampValidBits);
+  }
+  m_gpuProfiler = std::make_unique<GpuProfiler>(
+    m_device, m_physicalDeviceProps.limits.timestampPeriod,
+    timestampValidBits,
+    m_framesInFlight,
+    GpuProfiler::GetStatisticsFlags(m_enabledFeatures));
+  m_gpuProfiler->SetTraceRecorder(m_traceRecorder.get());
+  m_lastFrameTime = TraceRecorder::Clock::now();
+}
+
+void VulkanAppBase::DestroyFrameContexts()
+{
+  for (auto& frame : m_frames)
+  {
+    vkDestroySemaphore(m_device, frame.presentCompleted, nullptr);
+    vkDestroySemaphore(m_device, frame.renderCompleted, nullptr);
+    DestroyFence(frame.fence);
+    vkDestroyCommandPool(m_device, frame.commandPool, nullptr);
+  }
+  m_frames.clear();
+  m_gpuProfiler.reset();
+}
+
+VulkanAppBase::FrameContext& VulkanAppBase::BeginFrame()
+{
+  using namespace std::chrono;
+  auto& frame = m_frames[m_frameIndex];
+  if (m_traceRequestFrames > 0)
+  {
+    // 対応付けはフレームの外で行い、その時間を記録に含めない.
+    m_traceRecorder->Start(m_traceRequestFile.c_str(), m_traceRequestFrames, m_framesInFlight, CalibrateGpuClock());
+    m_traceRequestFrames = 0;
+  }
+  m_cpuProfiler->NewFrame();
+
+  // このスロットを前回使ったフレーム(N フレーム前)の完了を待つ.
+  // トレースと同じ時計で測る.
+  auto waitBegin = TraceRecorder::Clock::now();
+  vkWaitForFences(m_device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+  auto waitEnd = TraceRecorder::Clock::now();
+  m_cpuProfiler->Lap(CpuProfiler::Phase_FenceWait);
+
+  auto result = vkResetCommandPool(m_device, frame.commandPool, 0);
+  ThrowIfFailed(result, "vkResetCommandPool Failed.");
+  m_descriptorAllocator->BeginFrame(m_frameIndex);
+  m_gpuProfiler->NewFrame(m_frameIndex);
+
+  // 前回の BeginFrame からの経過時間と、そのうち GPU 待ちで止まっていた時間.
+  m_frameStats.frameCount++;
+  m_frameStats.cpuFrameMs += duration<double, std::milli>(waitEnd - m_lastFrameTime).count();
+  m_frameStats.fenceWaitMs += duration<double, std::milli>(waitEnd - waitBegin).count();
+  m_lastFrameTime = waitEnd;
+  if (m_frameStats.frameCount == FrameStatisticsInterval)
+  {
+    ReportFrameStatistics();
+    m_frameStats = FrameStatistics{};
+  }
+
+  if (m_frameRecorder && m_frameRecorder->BeginFrame())
+  {
+    auto archive = m_frameRecorder->GetInputArchive();
+    SerializeFrameInputs(archive);
+  }
+  return frame;
+}
+
+VkResult VulkanAppBase::AcquireNextImage(FrameContext& frame, uint32_t* pImageIndex)
+{
+  auto result = m_swapchain->AcquireNextImage(pImageIndex, frame.presentCompleted);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR && m_frameRecorder)
+  {
+    // このフレームは描画されずに終わるため、記録しない(再生時は次のフレームで同じ入力を使う).
+    m_frameRecorder->DiscardFrame();
+  }
+  if (m_isHeadless)
+  {
+    // オフスクリーンのイメージは順番に使い回すだけなので、前にこのイメージへ描画したフレーム
+    // (読み戻しやテクスチャとしての参照を含む)の完了を待ってから使う.
+    auto fence = m_offscreenImageFences[*pImageIndex];
+    if (fence != VK_NULL_HANDLE && fence != frame.fence)
+    {
+      vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
+    }
+  }
+  m_cpuProfiler->Lap(CpuProfiler::Phase_Acquire);
+  return result;
+}
+
+void VulkanAppBase::SubmitFrame(
+  uint32_t imageIndex,
+  uint32_t extraWaitCount, const VkSemaphore* extraWaits, const VkPipelineStageFlags* extraWaitStages,
+  uint32_t extraSignalCount, const VkSemaphore* extraSignals)
+{
+  auto& frame = m_frames[m_frameIndex];
+  m_cpuProfiler->Lap(CpuProfiler::Phase_Record);
+
+  // このフレームでリングへ書き込んだ範囲を GPU から見えるようにする. コヒーレントなメモリでは何もしない.
+  if (m_uniformRing && m_uniformRing->GetFrameUsage() > 0)
+  {
+    m_memoryAllocator->Flush(m_uniformRingBuffer.allocation, m_uniformRing->GetFrameBegin(), m_uniformRing->GetFrameUsage());
+  }
+
+  if (m_frameRecorder)
+  {
+    // リングは切り出した領域だけを確保順に記録する. パディングは前のフレームの値が残るため含めない.
+    if (m_uniformRing)
+    {
+      for (const auto& range : m_uniformRing->GetFrameRanges())
+      {
+        m_frameRecorder->AddUniformData(range.data, size_t(range.size));
+      }
+    }
+    m_frameRecorder->EndFrame();
+  }
+
+  // ヘッドレス時は取得/表示が無いため、それらとの同期も行わない.
+  std::vector<VkSemaphore> waitSemaphores;
+  std::vector<VkPipelineStageFlags> waitStageMask;
+  std::vector<VkSemaphore> signalSemaphores;
+  if (!m_isHeadless)
+  {
+    waitSemaphores.push_back(frame.presentCompleted);
+    waitStageMask.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    signalSemaphores.push_back(frame.renderCompleted);
+  }
+  waitSemaphores.insert(waitSemaphores.end(), extraWaits, extraWaits + extraWaitCount);
+  waitStageMask.insert(waitStageMask.end(), extraWaitStages, extraWaitStages + extraWaitCount);
+  signalSemaphores.insert(signalSemaphores.end(), extraSignals, extraSignals + extraSignalCount);
+
+  VkSubmitInfo submitInfo{
+    VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    nullptr,
+    uint32_t(waitSemaphores.size()), waitSemaphores.data(), // WaitSemaphore
+    waitStageMask.data(), // DstStageMask
+    1, &frame.commandBuffer, // CommandBuffer
+    uint32_t(signalSemaphores.size()), signalSemaphores.data(), // SignalSemaphore
+  };
+  vkResetFences(m_device, 1, &frame.fence);
+  auto result = vkQueueSubmit(m_deviceQueue, 1, &submitInfo, frame.fence);
+  ThrowIfFailed(result, "vkQueueSubmit Failed.");
+  m_cpuProfiler->Lap(CpuProfiler::Phase_Submit);
+  if (m_isHeadless)
+  {
+    m_offscreenImageFences[imageIndex] = frame.fence;
+  }
+
+  if (!m_isHeadless)
+  {
+    m_swapchain->QueuePresent(m_deviceQueue, imageIndex, frame.renderCompleted);
+  }
+  m_cpuProfiler->Lap(CpuProfiler::Phase_Present);
+  m_lastImageIndex = imageIndex;
+  if (m_traceRecorder->EndFrame())
+  {
+    ReportTraceCapture(true);
+  }
+
+  m_frameIndex = (m_frameIndex + 1) % m_framesInFlight;
+}
+
+void VulkanAppBase::RunHeadless(uint32_t frameCount, const char* readbackFile)
+{
+  for (uint32_t i = 0; i < frameCount; ++i)
+  {
+    Render();
+  }
+  vkDeviceWaitIdle(m_device);
+
+  if (readbackFile != nullptr)
+  {
+    auto extent = m_swapchain->GetSurfaceExtent();
+    auto pixels = ReadbackSwapchainImage(m_lastImageIndex);
+    if (!WriteImageFile(readbackFile, extent.width, extent.height, pixels))
+    {
+      book_util::WriteLog("[Headless] failed to write the readback image.\n");
+    }
+  }
+}
+
+std::vector<VulkanAppBase::BenchmarkVariant> VulkanAppBase::GetBenchmarkVariants()
+{
+  return { BenchmarkVariant{ "default", []() {} } };
+}
+
+void VulkanAppBase::RunBenchmark(const BenchmarkOptions& options)
+{
+  using namespace std::chrono;
+  std::stringstream report;
+  report << "{" << std::endl;
+  report << "  \"app\": \"" << options.appName << "\"," << std::endl;
+  report << "  \"device\": \"" << m_physicalDeviceProps.deviceName << "\"," << std::endl;
+  report << "  \"warmupFrames\": " << options.warmupFrames << "," << std::endl;
+  report << "  \"measuredFrames\": " << options.measuredFrames << "," << std::endl;
+  WriteDescriptorUpdateBenchmark(report);
+  WriteObjectLookupBenchmark(report);
+  WriteUniformUpdateBenchmark(report);
+  report << "  \"variants\": [" << std::endl;
+
+  auto variants = GetBenchmarkVariants();
+  for (size_t v = 0; v < variants.size(); ++v)
+  {
+    variants[v].apply();
+    for (uint32_t i = 0; i < options.warmupFrames; ++i)
+    {
+      SetBenchmarkPose(float(i) / float(options.warmupFrames));
+      Render();
+    }
+    vkDeviceWaitIdle(m_device);
+    m_gpuProfiler->CollectAll();
+    m_gpuProfiler->ResetTimings();
+    m_cpuProfiler = std::make_unique<CpuProfiler>();
+    m_cpuProfiler->SetTraceRecorder(m_traceRecorder.get());
+
+    // 計測するフレームは毎回同じ経路をたどる.
+    auto begin = high_resolution_clock::now();
+    for (uint32_t i = 0; i < options.measuredFrames; ++i)
+    {
+      SetBenchmarkPose(float(i) / float(options.measuredFrames));
+      Render();
+    }
+    vkDeviceWaitIdle(m_device);
+    auto wallMs = duration<double, std::milli>(high_resolution_clock::now() - begin).count();
+    m_gpuProfiler->CollectAll();
+
+    report << "    {" << std::endl;
+    report << "      \"name\": \"" << variants[v].name << "\"," << std::endl;
+    report << "      \"wallMs\": " << wallMs << "," << std::endl;
+    report << "      \"fps\": " << (wallMs > 0.0 ? options.measuredFrames * 1000.0 / wallMs : 0.0) << "," << std::endl;
+    report << "      \"cpu\": {";
+    for (int i = 0; i < CpuProfiler::Phase_Count; ++i)
+    {
+      auto p = m_cpuProfiler->ComputePercentiles(CpuProfiler::Phase(i));
+      report << (i > 0 ? ", " : " ") << "\"" << CpuProfiler::GetPhaseName(CpuProfiler::Phase(i)) << "\": { "
+        << "\"p50\": " << p.p50 << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99 << " }";
+    }
+    report << " }," << std::endl;
+    report << "      \"gpu\": {";
+    const auto& timings = m_gpuProfiler->GetTimings();
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+      const auto& t = timings[i];
+      report << (i > 0 ? ", " : " ") << "\"" << t.name << "\": { "
+        << "\"avg\": " << (t.sampleCount > 0 ? t.totalMs / t.sampleCount : 0.0)
+        << ", \"min\": " << t.minMs << ", \"max\": " << t.maxMs;
+      if (t.hasStatistics && t.statisticsSampleCount > 0)
+      {
+        // 1 フレームあたりの平均.
+        report << ", \"stats\": {";
+        for (int s = 0; s < GpuProfiler::Statistic_Count; ++s)
+        {
+          report << (s > 0 ? ", " : " ") << "\"" << GpuProfiler::GetStatisticName(GpuProfiler::Statistic(s)) << "\": "
+            << t.totalStatistics[s] / t.statisticsSampleCount;
+        }
+        report << " }";
+      }
+      report << " }";
+    }
+    report << " }" << std::endl;
+    report << "    }" << (v + 1 < variants.size() ? "," : "") << std::endl;
+  }
+  report << "  ]" << std::endl;
+  report << "}" << std::endl;
+
+  book_util::WriteLog(report.str().c_str());
+  if (!options.reportFile.empty())
+  {
+    std::ofstream outfile(options.reportFile);
+    outfile << report.str();
+  }
+}
+
+void VulkanAppBase::WriteDescriptorUpdateBenchmark(std::ostream& report)
+{
+  using namespace std::chrono;
+  report << "  \"descriptorUpdates\": {";
+  auto isFirst = true;
+  const auto& names = m_descriptorUpdateTemplateStore->GetNames();
+  for (const auto& info : m_descriptorUpdateTemplates)
+  {
+    const auto& name = names[info.updateTemplate.index];
+    if (info.lastData.empty())
+    {
+      continue;
+    }
+    // 計測用のセットは専用のアロケータから確保し、終わればプールごと破棄する.
+    DescriptorAllocator allocator(m_device);
+    auto dsLayout = GetDescriptorSetLayout(info.setLayout);
+    std::vector<VkDescriptorSet> descriptorSets(DescriptorUpdateBenchmarkSets);
+    for (auto& ds : descriptorSets)
+    {
+      ds = allocator.Allocate(dsLayout);
+    }
+
+    // 従来の経路: セットごとに書き込みの配列を作って vkUpdateDescriptorSets.
+    auto begin = high_resolution_clock::now();
+    for (auto ds : descriptorSets)
+    {
+      auto writes = book_util::CreateWriteDescriptorSets(ds, info.entries, info.lastData.data());
+      vkUpdateDescriptorSets(m_device, uint32_t(writes.size()), writes.data(), 0, nullptr);
+    }
+    auto writeArrayMs = duration<double, std::milli>(high_resolution_clock::now() - begin).count();
+
+    auto updateTemplate = m_descriptorUpdateTemplateStore->Get(info.updateTemplate);
+    begin = high_resolution_clock::now();
+    for (auto ds : descriptorSets)
+    {
+      vkUpdateDescriptorSetWithTemplate(m_device, ds, updateTemplate, info.lastData.data());
+    }
+    auto templateMs = duration<double, std::milli>(high_resolution_clock::now() - begin).count();
+
+    report << (isFirst ? " " : ", ") << "\"" << name << "\": { "
+      << "\"sets\": " << DescriptorUpdateBenchmarkSets
+      << ", \"writeArrayMs\": " << writeArrayMs
+      << ", \"templateMs\": " << templateMs << " }";
+    isFirst = false;
+
+    std::stringstream ss;
+    ss << "[DescriptorUpdate] " << name << ": " << DescriptorUpdateBenchmarkSets << " sets, "
+      << "write array " << writeArrayMs * 1000.0 / DescriptorUpdateBenchmarkSets << " us/set, "
+      << "template " << templateMs * 1000.0 / DescriptorUpdateBenchmarkSets << " us/set" << std::endl;
+    book_util::WriteLog(ss.str().c_str());
+  }
+  report << " }," << std::endl;
+}
+
+void VulkanAppBase::WriteObjectLookupBenchmark(std::ostream& report)
+{
+  using namespace std::chrono;
+  // 1 フレームで登録済みのレンダーパスとパイプラインレイアウトを 1 回ずつ引くものとする.
+  // 描画コードと同じく、名前は文字列リテラルから毎回 std::string を作って渡す.
+  std::vector<const char*> renderPassNames, layoutNames;
+  std::vector<RenderPassHandle> renderPassHandles;
+  std::vector<PipelineLayoutHandle> layoutHandles;
+  for (const auto& name : m_renderPassStore->GetNames())
+  {
+    renderPassNames.push_back(name.c_str());
+    renderPassHandles.push_back(FindRenderPass(name));
+  }
+  for (const auto& name : m_pipelineLayoutStore->GetNames())
+  {
+    layoutNames.push_back(name.c_str());
+    layoutHandles.push_back(FindPipelineLayout(name));
+  }
+  auto lookups = uint64_t(renderPassNames.size() + layoutNames.size()) * ObjectLookupBenchmarkFrames;
+  if (lookups == 0)
+  {
+    report << "  \"objectLookups\": { }," << std::endl;
+    return;
+  }
+
+  // 結果を捨てると最適化で消えるため、ハンドルの値を混ぜて残す.
+  uint64_t checksum = 0;
+  auto begin = high_resolution_clock::now();
+  for (uint32_t i = 0; i < ObjectLookupBenchmarkFrames; ++i)
+  {
+    for (auto name : renderPassNames)
+    {
+      checksum ^= uint64_t(GetRenderPass(name));
+    }
+    for (auto name : layoutNames)
+    {
+      checksum ^= uint64_t(GetPipelineLayout(name));
+    }
+  }
+  auto nameMs = duration<double, std::milli>(high_resolution_clock::now() - begin).count();
+
+  begin = high_resolution_clock::now();
+  for (uint32_t i = 0; i < ObjectLookupBenchmarkFrames; ++i)
+  {
+    for (auto handle : renderPassHandles)
+    {
+      checksum ^= uint64_t(GetRenderPass(handle));
+    }
+    for (auto handle : layoutHandles)
+    {
+      checksum ^= uint64_t(GetPipelineLayout(handle));
+    }
+  }
+  auto handleMs = duration<double, std::milli>(high_resolution_clock::now() - begin).count();
+
+  report << "  \"objectLookups\": { "
+    << "\"frames\": " << ObjectLookupBenchmarkFrames
+    << ", \"lookupsPerFrame\": " << lookups / ObjectLookupBenchmarkFrames
+    << ", \"nameMs\": " << nameMs
+    << ", \"handleMs\": " << handleMs << " }," << std::endl;
+
+  std::stringstream ss;
+  ss << "[ObjectLookup] " << lookups << " lookups, "
+    << "name " << nameMs * 1000000.0 / lookups << " ns/lookup, "
+    << "handle " << handleMs * 1000000.0 / lookups << " ns/lookup"
+    << " (checksum " << std::hex << checksum << ")" << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+uint32_t VulkanAppBase::RunRegression(const RegressionOptions& options)
+{
+  using namespace std::chrono;
+  auto extent = m_swapchain->GetSurfaceExtent();
+  auto prefix = options.referenceDir + "/" + options.appName;
+  auto baselineFile = prefix + "_baseline.txt";
+  book_util::CreateDirectoryIfMissing(options.referenceDir);
+
+  // 基準時間は "<設定名> <平均フレーム時間(ms)>" の行.
+  std::unordered_map<std::string, double> baseline;
+  if (!options.updateReference)
+  {
+    std::ifstream infile(baselineFile);
+    std::string name;
+    double frameMs;
+    while (infile >> name >> frameMs)
+    {
+      baseline[name] = frameMs;
+    }
+  }
+
+  m_isProfilerHudVisible = false;
+  uint32_t failures = 0;
+  std::stringstream log;
+  std::stringstream measured;
+  log << "[Regression] " << options.appName << " on " << m_physicalDeviceProps.deviceName << std::endl;
+
+  auto variants = GetBenchmarkVariants();
+  for (const auto& variant : variants)
+  {
+    variant.apply();
+
+    // 画像: 経路の始点で全スロットを一巡させ、フレーム間の状態を揃えてから読み戻す.
+    for (uint32_t i = 0; i <= m_framesInFlight; ++i)
+    {
+      SetBenchmarkPose(0.0f);
+      Render();
+    }
+    vkDeviceWaitIdle(m_device);
+    auto pixels = ReadbackSwapchainImage(m_lastImageIndex);
+
+    auto imageFile = prefix + "_" + variant.name + ".ppm";
+    uint32_t refWidth = 0, refHeight = 0;
+    std::vector<uint8_t> reference;
+    if (options.updateReference || !ReadImageFile(imageFile.c_str(), &refWidth, &refHeight, reference))
+    {
+      WriteImageFile(imageFile.c_str(), extent.width, extent.height, pixels);
+      log << "  " << variant.name << " image: recorded " << imageFile << std::endl;
+    }
+    else if (refWidth != extent.width || refHeight != extent.height)
+    {
+      failures++;
+      log << "  " << variant.name << " image: FAIL size " << refWidth << "x" << refHeight
+        << " expected " << extent.width << "x" << extent.height << std::endl;
+    }
+    else
+    {
+      auto psnr = ComputePsnr(reference, pixels);
+      auto passed = psnr >= options.minPsnr;
+      failures += passed ? 0 : 1;
+      log << "  " << variant.name << " image: " << (passed ? "ok" : "FAIL")
+        << " psnr " << psnr << " dB (min " << options.minPsnr << ")" << std::endl;
+      if (!passed)
+      {
+        WriteImageFile((prefix + "_" + variant.name + "_actual.ppm").c_str(), extent.width, extent.height, pixels);
+      }
+    }
+
+    // 時間: ベンチマークと同じ経路で平均フレーム時間を測る.
+    for (uint32_t i = 0; i < options.warmupFrames; ++i)
+    {
+      SetBenchmarkPose(float(i) / float(options.warmupFrames));
+      Render();
+    }
+    vkDeviceWaitIdle(m_device);
+    auto begin = high_resolution_clock::now();
+    for (uint32_t i = 0; i < options.measuredFrames; ++i)
+    {
+      SetBenchmarkPose(float(i) / float(options.measuredFrames));
+      Render();
+    }
+    vkDeviceWaitIdle(m_device);
+    auto wallMs = duration<double, std::milli>(high_resolution_clock::now() - begin).count();
+    auto frameMs = options.measuredFrames > 0 ? wallMs / options.measuredFrames : 0.0;
+    measured << variant.name << " " << frameMs << std::endl;
+
+    auto it = baseline.find(variant.name);
+    if (it == baseline.end() || it->second <= 0.0)
+    {
+      log << "  " << variant.name << " time: recorded " << frameMs << " ms" << std::endl;
+      continue;
+    }
+    auto slowdown = (frameMs / it->second - 1.0) * 100.0;
+    auto passed = slowdown <= options.maxSlowdownPercent;
+    failures += passed ? 0 : 1;
+    log << "  " << variant.name << " time: " << (passed ? "ok" : "FAIL")
+      << " " << frameMs << " ms (baseline " << it->second << " ms, " << slowdown
+      << "%, max " << options.maxSlowdownPercent << "%)" << std::endl;
+  }
+  m_isProfilerHudVisible = true;
+
+  // 基準が無かった場合と更新を指定した場合のみ書き出す. 既存の基準は比較で上書きしない.
+  if (options.updateReference || baseline.empty())
+  {
+    std::ofstream outfile(baselineFile);
+    outfile << measured.str();
+  }
+  log << "[Regression] " << (failures == 0 ? "passed" : "failed") << " (" << failures << " failures)" << std::endl;
+  book_util::WriteLog(log.str().c_str());
+  std::ofstream report(prefix + "_regression.txt");
+  report << log.str();
+  return failures;
+}
+
+void VulkanAppBase::StartRecording(const char* fileName, const std::string& appName)
+{
+  auto extent = m_swapchain->GetSurfaceExtent();
+  m_frameRecorder = std::make_unique<FrameRecorder>(fileName, FrameRecorder::Mode_Record, appName, extent.width, extent.height);
+}
+
+uint32_t VulkanAppBase::StartReplay(const char* fileName, const std::string& appName)
+{
+  auto extent = m_swapchain->GetSurfaceExtent();
+  m_frameRecorder = std::make_unique<FrameRecorder>(fileName, FrameRecorder::Mode_Replay, appName, extent.width, extent.height);
+  return m_frameRecorder->GetRecordedFrameCount();
+}
+
+void VulkanAppBase::ReportFrameRecorderStatistics()
+{
+  const auto& stats = m_frameRecorder->GetStatistics();
+  std::stringstream ss;
+  if (m_frameRecorder->GetMode() == FrameRecorder::Mode_Record)
+  {
+    ss << "[Capture] recorded " << stats.frameCount << " frames, uniforms: " << stats.uniformBytes / 1024 << "KB" << std::endl;
+  }
+  else
+  {
+    // ユニフォームが一致しなければ、入力以外(時刻等)に依存する処理があり再現できていない.
+    ss << "[Replay] " << stats.frameCount << "/" << m_frameRecorder->GetRecordedFrameCount() << " frames"
+      << ", uniform mismatches: " << stats.uniformMismatches;
+    if (stats.uniformMismatches > 0)
+    {
+      ss << " (first at frame " << stats.firstMismatchFrame << ")";
+    }
+    ss << std::endl;
+  }
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::StartTraceCapture(const std::string& fileName, uint32_t frameCount)
+{
+  if (m_traceRecorder && m_traceRecorder->IsActive())
+  {
+    return;
+  }
+  m_traceRequestFile = fileName;
+  m_traceRequestFrames = frameCount;
+}
+
+void VulkanAppBase::ReportTraceCapture(bool isWritten)
+{
+  std::stringstream ss;
+  ss << "[Trace] ";
+  if (isWritten)
+  {
+    ss << m_traceRecorder->GetFileName() << ": " << m_traceRecorder->GetFrameIndex() << " frames, "
+      << m_traceRecorder->GetEventCount() << " events";
+  }
+  else
+  {
+    ss << "cannot write " << m_traceRecorder->GetFileName();
+  }
+  ss << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+TraceRecorder::ClockCalibration VulkanAppBase::CalibrateGpuClock()
+{
+  using namespace std::chrono;
+  using Clock = TraceRecorder::Clock;
+  TraceRecorder::ClockCalibration calibration{};
+  calibration.nanosecondsPerTick = m_physicalDeviceProps.limits.timestampPeriod;
+
+  // 計測区間の値と同じく、タイムスタンプの有効なビットより上は使わない.
+  auto tickMask = m_gpuProfiler->GetTimestampMask();
+
+  if (m_vkGetCalibratedTimestampsEXT)
+  {
+    // デバイスとホストの時刻を 1 回の呼び出しで同時に取得する. 誤差はドライバの返す maxDeviation.
+    VkCalibratedTimestampInfoEXT infos[] = {
+      { VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, nullptr, VK_TIME_DOMAIN_DEVICE_EXT },
+      { VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, nullptr, m_hostTimeDomain },
+    };
+    uint64_t timestamps[2] = {};
+    uint64_t maxDeviation = 0;
+    auto result = m_vkGetCalibratedTimestampsEXT(m_device, 2, infos, timestamps, &maxDeviation);
+    if (result == VK_SUCCESS)
+    {
+      // ホストの時間領域から Clock への換算. 両方を続けて読み、その間隔も誤差に含める.
+      auto before = Clock::now();
+      auto hostNow = GetHostTimestamp(m_hostTimeDomain);
+      auto after = Clock::now();
+      auto hostElapsedNs = double(int64_t(hostNow - timestamps[1])) * GetHostNanosecondsPerTick(m_hostTimeDomain);
+      calibration.cpuTime = before + (after - before) / 2
+        - duration_cast<Clock::duration>(duration<double, std::nano>(hostElapsedNs));
+      calibration.gpuTicks = timestamps[0] & tickMask;
+      calibration.maxDeviationUs = double(maxDeviation) / 1000.0 + duration<double, std::micro>(after - before).count() / 2.0;
+      calibration.isCalibrated = true;
+      return calibration;
+    }
+  }
+
+  calibration.cpuTime = Clock::now();
+  if (!m_gpuProfiler->IsSupported())
+  {
+    return calibration;
+  }
+  // タイムスタンプは発行から完了までの間に書かれるため、その中間の時刻とみなす.
+  // 処理中のフレームの後ろに並ぶと完了が遅れて中間の時刻がずれるため、先に GPU の完了を待つ.
+  vkDeviceWaitIdle(m_device);
+  VkQueryPoolCreateInfo poolCI{
+    VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+    nullptr, 0,
+    VK_QUERY_TYPE_TIMESTAMP,
+    1, 0
+  };
+  VkQueryPool pool;
+  auto result = vkCreateQueryPool(m_device, &poolCI, nullptr, &pool);
+  ThrowIfFailed(result, "vkCreateQueryPool Failed.");
+
+  auto command = CreateCommandBuffer();
+  vkCmdResetQueryPool(command, pool, 0, 1);
+  vkCmdWriteTimestamp(command, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, 0);
+  auto submitTime = Clock::now();
+  FinishCommandBuffer(command);
+  auto completeTime = Clock::now();
+  DestroyCommandBuffer(command);
+
+  uint64_t ticks = 0;
+  vkGetQueryPoolResults(m_device, pool, 0, 1, sizeof(ticks), &ticks, sizeof(ticks), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+  vkDestroyQueryPool(m_device, pool, nullptr);
+
+  calibration.cpuTime = submitTime + (completeTime - submitTime) / 2;
+  calibration.gpuTicks = ticks & tickMask;
+  calibration.maxDeviationUs = duration<double, std::micro>(completeTime - submitTime).count() / 2.0;
+  calibration.isCalibrated = false;
+  return calibration;
+}
+
+std::vector<uint8_t> VulkanAppBase::ReadbackSwapchainImage(uint32_t imageIndex)
+{
+  auto extent = m_swapchain->GetSurfaceExtent();
+  auto format = m_swapchain->GetSurfaceFormat().format;
+  auto image = m_swapchain->GetImage(imageIndex);
+  uint32_t size = extent.width * extent.height * 4;
+
+  VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  auto readback = CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, props);
+
+  // 描画パスの最終レイアウトから転送元へ移し、コピー後に戻す.
+  // ヘッドレスでは最終レイアウトが転送元なので、描画の完了を待つだけになる.
+  VkImageMemoryBarrier barrier{
+    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    nullptr,
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+    VK_ACCESS_TRANSFER_READ_BIT,
+    GetPresentLayout(),
+    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+    image,
+    { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+  };
+  VkBufferImageCopy region{};
+  region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+  region.imageExtent = { extent.width, extent.height, 1 };
+
+  auto command = CreateCommandBuffer();
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+    0, nullptr, 0, nullptr, 1, &barrier);
+  vkCmdCopyImageToBuffer(command, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region);
+  std::swap(barrier.oldLayout, barrier.newLayout);
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0,
+    0, nullptr, 0, nullptr, 1, &barrier);
+  FinishCommandBuffer(command);
+  DestroyCommandBuffer(command);
+
+  m_memoryAllocator->Invalidate(readback.allocation);
+  std::vector<uint8_t> pixels(size);
+  memcpy(pixels.data(), readback.allocation.mapped, size);
+  DestroyBuffer(readback);
+
+  // RGBA の順に揃える.
+  if (format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB)
+  {
+    for (uint32_t i = 0; i < size; i += 4)
+    {
+      std::swap(pixels[i], pixels[i + 2]);
+    }
+  }
+  return pixels;
+}
+
+bool VulkanAppBase::WriteImageFile(const char* fileName, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba)
+{
+  // 外部ライブラリを使わずに書き出せるよう PPM(P6) 形式とする.
+  std::ofstream outfile(fileName, std::ios::binary);
+  if (!outfile)
+  {
+    return false;
+  }
+  outfile << "P6\n" << width << " " << height << "\n255\n";
+  for (size_t i = 0; i + 3 < rgba.size(); i += 4)
+  {
+    outfile.write(reinterpret_cast<const char*>(&rgba[i]), 3);
+  }
+  return bool(outfile);
+}
+
+bool VulkanAppBase::ReadImageFile(const char* fileName, uint32_t* width, uint32_t* height, std::vector<uint8_t>& rgba)
+{
+  std::ifstream infile(fileName, std::ios::binary);
+  std::string magic;
+  uint32_t maxValue = 0;
+  if (!(infile >> magic >> *width >> *height >> maxValue) || magic != "P6" || maxValue != 255)
+  {
+    return false;
+  }
+  infile.get(); // ヘッダ末尾の改行.
+
+  size_t pixelCount = size_t(*width) * size_t(*height);
+  std::vector<uint8_t> rgb(pixelCount * 3);
+  if (!infile.read(reinterpret_cast<char*>(rgb.data()), rgb.size()))
+  {
+    return false;
+  }
+  rgba.resize(pixelCount * 4);
+  for (size_t i = 0; i < pixelCount; ++i)
+  {
+    rgba[i * 4 + 0] = rgb[i * 3 + 0];
+    rgba[i * 4 + 1] = rgb[i * 3 + 1];
+    rgba[i * 4 + 2] = rgb[i * 3 + 2];
+    rgba[i * 4 + 3] = 255;
+  }
+  return true;
+}
+
+double VulkanAppBase::ComputePsnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+  auto size = (std::min)(a.size(), b.size());
+  if (size == 0 || a.size() != b.size())
+  {
+    return 0.0;
+  }
+  // アルファは読み戻し時と PPM 読み込み時で一致しないため比較しない.
+  double sum = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i)
+  {
+    if ((i & 3) == 3)
+    {
+      continue;
+    }
+    double d = double(a[i]) - double(b[i]);
+    sum += d * d;
+    count++;
+  }
+  if (sum == 0.0)
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+  auto mse = sum / double(count);
+  return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+void VulkanAppBase::ReportFrameStatistics()
+{
+  const auto& stats = m_frameStats;
+  if (stats.frameCount == 0)
+  {
+    return;
+  }
+  // フェンス待ちが短いほど、CPU は GPU の完了を待たずに次のフレームを準備できている.
+  auto frameMs = stats.cpuFrameMs / stats.frameCount;
+  auto waitMs = stats.fenceWaitMs / stats.frameCount;
+  std::stringstream ss;
+  ss << "[Frame] frames in flight: " << m_framesInFlight
+    << ", frame: " << frameMs << "ms"
+    << ", fence wait: " << waitMs << "ms"
+    << ", cpu/gpu overlap: " << (frameMs > 0.0 ? 1.0 - waitMs / frameMs : 0.0)
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+VkRect2D VulkanAppBase::GetSwapchainRenderArea() const
+{
+  return VkRect2D{
+    VkOffset2D{0,0},
+    m_swapchain->GetSurfaceExtent()
+  };
+}
+
+std::vector<VulkanAppBase::BufferObject> VulkanAppBase::CreateUniformBuffers(uint32_t bufferSize, uint32_t imageCount)
+{
+  std::vector<BufferObject> buffers(imageCount);
+  for (auto& b : buffers)
+  {
+    VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    b = CreateBuffer(bufferSize, GetUniformBufferUsage(), props);
+  }
+  return buffers;
+}
+
+VkBufferUsageFlags VulkanAppBase::GetUniformBufferUsage() const
+{
+  VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+  if (m_isBindlessSupported)
+  {
+    usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  }
+  return usage;
+}
+
+UniformRingBuffer* VulkanAppBase::CreateUniformRing(uint32_t bytesPerFrame)
+{
+  // 各フレームの先頭がアライメントに沿うよう、フレームあたりのサイズを切り上げる.
+  // 非コヒーレントなメモリの場合は、フレームごとの Flush の範囲が隣のフレームに掛からないよう nonCoherentAtomSize にも揃える.
+  // どちらも 2 のべき乗なので大きい方に合わせればよい.
+  auto alignment = uint32_t((std::max)(
+    m_physicalDeviceProps.limits.minUniformBufferOffsetAlignment, m_physicalDeviceProps.limits.nonCoherentAtomSize));
+  auto frameSize = (bytesPerFrame + alignment - 1) / alignment * alignment;
+  auto frameCount = m_framesInFlight;
+  if (m_uniformRing)
+  {
+    m_uniformRing.reset();
+    DestroyBuffer(m_uniformRingBuffer);
+  }
+
+  // コヒーレントかどうかは問わない. 書き込んだ範囲は SubmitFrame で Flush する.
+  VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  m_uniformRingBuffer = CreateBuffer(frameSize * frameCount, GetUniformBufferUsage(), props);
+  m_uniformRing = std::make_unique<UniformRingBuffer>(
+    m_uniformRingBuffer.buffer, m_uniformRingBuffer.allocation.mapped,
+    alignment, frameCount, frameSize);
+  return m_uniformRing.get();
+}
+
+RenderGraph* VulkanAppBase::CreateRenderGraph(const char* name)
+{
+  m_renderGraphs.push_back(std::make_unique<RenderGraph>(name, m_device, m_memoryAllocator.get(), m_gfxQueueIndex, m_computeQueueIndex));
+  return m_renderGraphs.back().get();
+}
+
+void VulkanAppBase::WriteToHostVisibleMemory(const MemoryAllocation& allocation, uint32_t size, const void* pData)
+{
+  if (m_frameRecorder)
+  {
+    m_frameRecorder->AddUniformData(pData, size);
+  }
+  memcpy(allocation.mapped, pData, size);
+  m_memoryAllocator->Flush(allocation, 0, size);
+}
+
+void VulkanAppBase::FlushMappedMemory(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+  m_memoryAllocator->Flush(allocation, offset, size);
+}
+
+void VulkanAppBase::InvalidateMappedMemory(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+  m_memoryAllocator->Invalidate(allocation, offset, size);
+}
+
+void VulkanAppBase::WriteUniformUpdateBenchmark(std::ostream& report)
+{
+  using Clock = std::chrono::high_resolution_clock;
+  auto writeSizes = GetUniformWriteSizes();
+  if (writeSizes.empty())
+  {
+    return;
+  }
+  auto frameCount = UniformUpdateBenchmarkFrames;
+  VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  uint32_t maxSize = 0;
+  for (auto size : writeSizes)
+  {
+    maxSize = std::max(maxSize, size);
+  }
+  std::vector<char> source(maxSize, 0x7f);
+
+  // 旧方式: バッファごとに VkDeviceMemory を持ち、書き込みのたびに map/memcpy/unmap.
+  std::vector<VkBuffer> oldBuffers(writeSizes.size());
+  std::vector<VkDeviceMemory> oldMemories(writeSizes.size());
+  for (size_t i = 0; i < writeSizes.size(); ++i)
+  {
+    VkBufferCreateInfo bufferCI{
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      nullptr, 0,
+      writeSizes[i], VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+      VK_SHARING_MODE_EXCLUSIVE,
+      0, nullptr
+    };
+    auto result = vkCreateBuffer(m_device, &bufferCI, nullptr, &oldBuffers[i]);
+    ThrowIfFailed(result, "vkCreateBuffer Failed.");
+    VkMemoryRequirements reqs;
+    vkGetBufferMemoryRequirements(m_device, oldBuffers[i], &reqs);
+    VkMemoryAllocateInfo info{
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      nullptr,
+      reqs.size,
+      GetMemoryTypeIndex(reqs.memoryTypeBits, props)
+    };
+    result = vkAllocateMemory(m_device, &info, nullptr, &oldMemories[i]);
+    ThrowIfFailed(result, "vkAllocateMemory Failed.");
+    vkBindBufferMemory(m_device, oldBuffers[i], oldMemories[i], 0);
+  }
+
+  auto start = Clock::now();
+  for (uint32_t frame = 0; frame < frameCount; ++frame)
+  {
+    for (size_t i = 0; i < writeSizes.size(); ++i)
+    {
+      void* p;
+      vkMapMemory(m_device, oldMemories[i], 0, VK_WHOLE_SIZE, 0, &p);
+      memcpy(p, source.data(), writeSizes[i]);
+      vkUnmapMemory(m_device, oldMemories[i]);
+    }
+  }
+  auto oldTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+  for (size_t i = 0; i < writeSizes.size(); ++i)
+  {
+    vkDestroyBuffer(m_device, oldBuffers[i], nullptr);
+    vkFreeMemory(m_device, oldMemories[i], nullptr);
+  }
+
+  // 新方式: サブアロケートされた永続マップ領域へ memcpy のみ.
+  std::vector<BufferObject> buffers;
+  for (auto size : writeSizes)
+  {
+    buffers.push_back(CreateBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, props));
+  }
+  start = Clock::now();
+  for (uint32_t frame = 0; frame < frameCount; ++frame)
+  {
+    for (size_t i = 0; i < writeSizes.size(); ++i)
+    {
+      WriteToHostVisibleMemory(buffers[i].allocation, writeSizes[i], source.data());
+    }
+  }
+  auto newTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+  for (auto& b : buffers)
+  {
+    DestroyBuffer(b);
+  }
+
+  report << "  \"uniformUpdates\": { "
+    << "\"writes\": " << writeSizes.size()
+    << ", \"frames\": " << frameCount
+    << ", \"mapUnmapUs\": " << oldTime / frameCount
+    << ", \"persistentUs\": " << newTime / frameCount << " }," << std::endl;
+
+  std::stringstream ss;
+  ss << "[UniformUpdate] " << writeSizes.size() << " writes x " << frameCount << " frames"
+    << ", map/unmap: " << oldTime / frameCount << "us/frame"
+    << ", persistent: " << newTime / frameCount << "us/frame"
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::AllocateCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands)
+{
+  VkCommandBufferAllocateInfo commandAI{
+    VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    nullptr, m_commandPool,
+    VK_COMMAND_BUFFER_LEVEL_SECONDARY, count
+  };
+  auto result = vkAllocateCommandBuffers(m_device, &commandAI, pCommands);
+  ThrowIfFailed(result, "vkAllocateCommandBuffers Faield.");
+}
+
+void VulkanAppBase::FreeCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands)
+{
+  vkFreeCommandBuffers(m_device, m_commandPool, count, pCommands);
+}
+
+void VulkanAppBase::TransferStageBufferToImage(
+  const BufferObject& srcBuffer, const ImageObject& dstImage, const VkBufferImageCopy* region)
+{ 
+  VkImageMemoryBarrier imb{
+    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+    0, VK_ACCESS_TRANSFER_WRITE_BIT,
+    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+    dstImage.image,
+    { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+  };
+
+  // Staging から転送.
+  auto command = CreateCommandBuffer();
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+    0, 0, nullptr,
+    0, nullptr, 1, &imb);
+
+  vkCmdCopyBufferToImage(
+    command, 
+    srcBuffer.buffer, dstImage.image,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, region);
+  imb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  imb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  imb.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  imb.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  vkCmdPipelineBarrier(command,
+    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+    0, 0, nullptr,
+    0, nullptr,
+    1, &imb);
+  FinishCommandBuffer(command);
+  DestroyCommandBuffer(command);
+}
+
+
+VkRenderPass VulkanAppBase::CreateRenderPass(VkFormat colorFormat, VkFormat depthFormat, VkImageLayout layoutColor)
+{
+  VkRenderPass renderPass;
+
+  std::vector<VkAttachmentDescription> attachments;
+
+  if (colorFormat == VK_FORMAT_UNDEFINED)
+  {
+    colorFormat = m_swapchain->GetSurfaceFormat().format;
+  }
+  if (layoutColor == VK_IMAGE_LAYOUT_UNDEFINED)
+  {
+    layoutColor = GetPresentLayout();
+  }
+
+  VkAttachmentDescription colorTarget, depthTarget;
+  colorTarget = VkAttachmentDescription{
+    0,  // Flags
+    colorFormat,
+    VK_SAMPLE_COUNT_1_BIT,
+    VK_ATTACHMENT_LOAD_OP_CLEAR,
+    VK_ATTACHMENT_STORE_OP_STORE,
+    VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+    VK_ATTACHMENT_STORE_OP_DONT_CARE,
+    VK_IMAGE_LAYOUT_UNDEFINED,
+    layoutColor
+  };
+  depthTarget = VkAttachmentDescription{
+    0,
+    depthFormat,
+    VK_SAMPLE_COUNT_1_BIT,
+    VK_ATTACHMENT_LOAD_OP_CLEAR,
+    VK_ATTACHMENT_STORE_OP_STORE,
+    VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+    VK_ATTACHMENT_STORE_OP_DONT_CARE,
+    VK_IMAGE_LAYOUT_UNDEFINED,
+    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+  };
+
+  VkAttachmentReference colorRef{
+    0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+  };
+  VkAttachmentReference depthRef{
+    1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+  };
+
+  VkSubpassDescription subpassDesc{
+    0, // Flags
+    VK_PIPELINE_BIND_POINT_GRAPHICS,
+    0, nullptr, // InputAttachments
+    1, &colorRef, // ColorAttachments
+    nullptr,    // ResolveAttachments
+    nullptr,    // DepthStencilAttachments
+    0, nullptr, // PreserveAttachments
+  };
+
+  attachments.push_back(colorTarget);
+  if (depthFormat != VK_FORMAT_UNDEFINED)
+  {
+    attachments.push_back(depthTarget);
+    subpassDesc.pDepthStencilAttachment = &depthRef;
+  }
+
+  VkRenderPassCreateInfo rpCI{
+    VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+    nullptr, 0,
+    uint32_t(attachments.size()), attachments.data(),
+    1, &subpassDesc,
+    0, nullptr, // Dependency
+  };
+  auto result = vkCreateRenderPass(m_device, &rpCI, nullptr, &renderPass);
+  ThrowIfFailed(result, "vkCreateRenderPass Failed.");
+  return renderPass;
+}
+
+
+void VulkanAppBase::PrepareImGui()
+{
+  // ImGui
+  IMGUI_CHECKVERSION();
+  ImGui::CreateContext();
+  if (!m_isHeadless)
+  {
+    ImGui_ImplGlfw_InitForVulkan(m_window, true);
+  }
+
+  ImGui_ImplVulkan_InitInfo info{};
+  info.Instance = m_vkInstance;
+  info.PhysicalDevice = m_physicalDevice;
+  info.Device = m_device;
+  info.QueueFamily = m_gfxQueueIndex;
+  info.Queue = m_deviceQueue;
+  info.PipelineCache = m_pipelineCache;
+  info.DescriptorPool = m_descriptorPool;
+  // ImGui は内部の頂点バッファを ImageCount 個で使い回すため、処理中のフレーム数以上とする.
+  info.MinImageCount = m_swapchain->GetImageCount();
+  info.ImageCount = std::max(m_swapchain->GetImageCount(), m_framesInFlight);
+  ImGui_ImplVulkan_Init(&info, GetRenderPass("default"));
+
+  // フォントテクスチャの転送は他の転送と同じバッチに記録する.
+  // ImGui 側のステージングバッファは ImGui の終了時まで保持される.
+  ImGui_ImplVulkan_CreateFontsTexture(m_uploadManager->GetCommandBuffer());
+}
+
+void VulkanAppBase::CleanupImGui()
+{
+  ImGui_ImplVulkan_Shutdown();
+  if (!m_isHeadless)
+  {
+    ImGui_ImplGlfw_Shutdown();
+  }
+  ImGui::DestroyContext();
+}
+
+void VulkanAppBase::NewImGuiFrame()
+{
+  ImGui_ImplVulkan_NewFrame();
+  if (m_isHeadless)
+  {
+    // ウィンドウが無いので表示サイズと経過時間はこちらで与える.
+    auto extent = m_swapchain->GetSurfaceExtent();
+    auto& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(float(extent.width), float(extent.height));
+    io.DeltaTime = 1.0f / 60.0f;
+  }
+  else
+  {
+    ImGui_ImplGlfw_NewFrame();
+  }
+  ImGui::NewFrame();
+  if (m_isProfilerHudVisible)
+  {
+    m_gpuProfiler->DrawImGui();
+    m_cpuProfiler->DrawImGui();
+    DrawMemoryImGui();
+    DrawTraceImGui();
+  }
+}
+
+
+void VulkanAppBase::CreateInstance()
+{
+  VkApplicationInfo appinfo{};
+  appinfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  appinfo.pApplicationName = "VulkanBook2";
+  appinfo.pEngineName = "VulkanBook2";
+  appinfo.apiVersion = VK_API_VERSION_1_1;
+  appinfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+
+  // 拡張情報の取得.
+  uint32_t count;
+  vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+  std::vector<VkExtensionProperties> props(count);
+  vkEnumerateInstanceExtensionProperties(nullptr, &count, props.data());
+  // プロファイルで要求したものだけを有効化する.
+  const auto& extensions = m_capabilityProfile.instanceExtensions;
+  for (auto name : extensions)
+  {
+    if (!HasExtension(props, name))
+    {
+      throw book_util::VulkanException(std::string("Instance extension is not supported: ") + name);
+    }
+  }
+
+  VkInstanceCreateInfo instanceCI{};
+  instanceCI.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  instanceCI.enabledExtensionCount = uint32_t(extensions.size());
+  instanceCI.ppEnabledExtensionNames = extensions.data();
+  instanceCI.pApplicationInfo = &appinfo;
+#ifdef _DEBUG
+  // デバッグビルド時には検証レイヤーを有効化
+  const char* layers[] = { "VK_LAYER_LUNARG_standard_validation" };
+  instanceCI.enabledLayerCount = 1;
+  instanceCI.ppEnabledLayerNames = layers;
+#endif
+  auto result = vkCreateInstance(&instanceCI, nullptr, &m_vkInstance);
+  ThrowIfFailed(result, "vkCreateInstance Failed.");
+}
+
+void VulkanAppBase::SelectQueueFamilies()
+{
+  uint32_t queuePropCount;
+  vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queuePropCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilyProps(queuePropCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queuePropCount, queueFamilyProps.data());
+
+  // グラフィックスキューのインデックス値を取得.
+  uint32_t graphicsQueue = ~0u;
+  for (uint32_t i = 0; i < queuePropCount; ++i)
+  {
+    if (queueFamilyProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+    {
+      graphicsQueue = i; break;
+    }
+  }
+  m_gfxQueueIndex = graphicsQueue;
+
+  // 転送専用/コンピュート専用のファミリーがあれば使用し、無ければグラフィックスキューを共用する.
+  m_transferQueueIndex = m_gfxQueueIndex;
+  m_computeQueueIndex = m_gfxQueueIndex;
+  for (uint32_t i = 0; i < queuePropCount; ++i)
+  {
+    auto flags = queueFamilyProps[i].queueFlags;
+    if (flags & VK_QUEUE_GRAPHICS_BIT)
+    {
+      continue;
+    }
+    if ((flags & VK_QUEUE_COMPUTE_BIT) && m_computeQueueIndex == m_gfxQueueIndex)
+    {
+      m_computeQueueIndex = i;
+    }
+    if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT) && m_transferQueueIndex == m_gfxQueueIndex)
+    {
+      m_transferQueueIndex = i;
+    }
+  }
+  m_gfxTimestampValidBits = queueFamilyProps[m_gfxQueueIndex].timestampValidBits;
+  m_computeTimestampValidBits = queueFamilyProps[m_computeQueueIndex].timestampValidBits;
+}
+
+void VulkanAppBase::CreateDevice()
+{
+  const float defaultQueuePriority(1.0f);
+  // ファミリーごとに 1 つずつキューを生成する.
+  std::vector<VkDeviceQueueCreateInfo> devQueueCIs;
+  for (auto familyIndex : { m_gfxQueueIndex, m_transferQueueIndex, m_computeQueueIndex })
+  {
+    auto it = std::find_if(devQueueCIs.begin(), devQueueCIs.end(),
+      [&](const VkDeviceQueueCreateInfo& ci) { return ci.queueFamilyIndex == familyIndex; });
+    if (it != devQueueCIs.end())
+    {
+      continue;
+    }
+    VkDeviceQueueCreateInfo devQueueCI{
+      VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+      nullptr, 0,
+      familyIndex,
+      1, &defaultQueuePriority
+    };
+    devQueueCIs.push_back(devQueueCI);
+  }
+  uint32_t count;
+  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &count, nullptr);
+  std::vector<VkExtensionProperties> deviceExtensions(count);
+  vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &count, deviceExtensions.data());
+
+  // 必須の拡張や機能が無ければ例外とし、任意の拡張は使える場合のみ加える.
+  auto unsupported = FindUnsupportedCapability(m_physicalDevice, m_capabilityProfile);
+  if (!unsupported.empty())
+  {
+    throw book_util::VulkanException("Device does not support " + unsupported);
+  }
+  auto extensions = m_capabilityProfile.deviceExtensions;
+  for (auto name : m_capabilityProfile.optionalDeviceExtensions)
+  {
+    if (HasExtension(deviceExtensions, name))
+    {
+      extensions.push_back(name);
+    }
+  }
+  m_isMemoryBudgetSupported = std::any_of(extensions.begin(), extensions.end(),
+    [](const char* name) { return strcmp(name, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0; });
+  m_isCalibratedTimestampsSupported = false;
+  m_hostTimeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+  if (std::any_of(extensions.begin(), extensions.end(),
+    [](const char* name) { return strcmp(name, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0; }))
+  {
+    auto getTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+      vkGetInstanceProcAddr(m_vkInstance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    uint32_t domainCount = 0;
+    if (getTimeDomains && getTimeDomains(m_physicalDevice, &domainCount, nullptr) == VK_SUCCESS)
+    {
+      std::vector<VkTimeDomainEXT> domains(domainCount);
+      getTimeDomains(m_physicalDevice, &domainCount, domains.data());
+      auto hasDomain = [&](VkTimeDomainEXT domain) { return std::find(domains.begin(), domains.end(), domain) != domains.end(); };
+      // デバイスと同時に読めるホストの時間領域が必要.
+#if defined(_WIN32)
+      const VkTimeDomainEXT hostDomains[] = { VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT };
+#else
+      const VkTimeDomainEXT hostDomains[] = { VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT, VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT };
+#endif
+      auto host = std::find_if(std::begin(hostDomains), std::end(hostDomains), hasDomain);
+      if (hasDomain(VK_TIME_DOMAIN_DEVICE_EXT) && host != std::end(hostDomains))
+      {
+        m_hostTimeDomain = *host;
+        m_isCalibratedTimestampsSupported = true;
+      }
+    }
+  }
+
+  // 機能も要求したものだけを有効化する. 任意の機能は対応している場合のみ加える.
+  VkPhysicalDeviceFeatures supported{};
+  vkGetPhysicalDeviceFeatures(m_physicalDevice, &supported);
+  m_enabledFeatures = m_capabilityProfile.features;
+  auto enabled = reinterpret_cast<VkBool32*>(&m_enabledFeatures);
+  auto optional = reinterpret_cast<const VkBool32*>(&m_capabilityProfile.optionalFeatures);
+  auto available = reinterpret_cast<const VkBool32*>(&supported);
+  for (size_t i = 0; i < sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32); ++i)
+  {
+    if (optional[i] && available[i])
+    {
+      enabled[i] = VK_TRUE;
+    }
+  }
+
+  // バインドレスは拡張と必要な機能が全てそろっている場合のみ有効化する.
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{
+    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT
+  };
+  m_isBindlessSupported = false;
+  if (m_capabilityProfile.optionalBindless && HasExtension(deviceExtensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+  {
+    VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &indexingFeatures };
+    vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+    m_isBindlessSupported =
+      supported.shaderSampledImageArrayDynamicIndexing && supported.shaderStorageBufferArrayDynamicIndexing &&
+      indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound &&
+      indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+      indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+      indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+  }
+  if (m_isBindlessSupported)
+  {
+    extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    // 使う機能だけを有効化する.
+    indexingFeatures = VkPhysicalDeviceDescriptorIndexingFeaturesEXT{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT
+    };
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    m_enabledFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+    m_enabledFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+  }
+
+  VkDeviceCreateInfo deviceCI{
+    VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+    m_isBindlessSupported ? &indexingFeatures : nullptr, 0,
+    uint32_t(devQueueCIs.size()), devQueueCIs.data(),
+    0, nullptr,
+    uint32_t(extensions.size()), extensions.data(),
+    &m_enabledFeatures
+  };
+  auto result = vkCreateDevice(m_physicalDevice, &deviceCI, nullptr, &m_device);
+  ThrowIfFailed(result, "vkCreateDevice Failed.");
+
+  vkGetDeviceQueue(m_device, m_gfxQueueIndex, 0, &m_deviceQueue);
+  vkGetDeviceQueue(m_device, m_transferQueueIndex, 0, &m_transferQueue);
+  vkGetDeviceQueue(m_device, m_computeQueueIndex, 0, &m_computeQueue);
+
+  m_vkGetCalibratedTimestampsEXT = nullptr;
+  if (m_isCalibratedTimestampsSupported)
+  {
+    m_vkGetCalibratedTimestampsEXT = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+      vkGetDeviceProcAddr(m_device, "vkGetCalibratedTimestampsEXT"));
+  }
+}
+
+void VulkanAppBase::CreatePipelineCache()
+{
+  std::vector<char> data;
+  std::ifstream infile(PipelineCacheFileName, std::ios::binary);
+  if (infile)
+  {
+    data.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+  }
+  // 別のデバイスやドライバで作られたものは使わない.
+  if (!IsPipelineCacheCompatible(data))
+  {
+    data.clear();
+  }
+  m_pipelineCacheLoadedSize = data.size();
+
+  VkPipelineCacheCreateInfo cacheCI{
+    VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    nullptr, 0,
+    data.size(), data.empty() ? nullptr : data.data()
+  };
+  auto result = vkCreatePipelineCache(m_device, &cacheCI, nullptr, &m_pipelineCache);
+  ThrowIfFailed(result, "vkCreatePipelineCache Failed.");
+}
+
+bool VulkanAppBase::IsPipelineCacheCompatible(const std::vector<char>& data) const
+{
+  // VkPipelineCacheHeaderVersionOne の内容.
+  // headerSize, headerVersion, vendorID, deviceID (各 uint32_t) に続いて pipelineCacheUUID.
+  const size_t headerSize = sizeof(uint32_t) * 4 + VK_UUID_SIZE;
+  if (data.size() < headerSize)
+  {
+    return false;
+  }
+  uint32_t header[4];
+  memcpy(header, data.data(), sizeof(header));
+  if (header[0] < headerSize || header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+  {
+    return false;
+  }
+  if (header[2] != m_physicalDeviceProps.vendorID || header[3] != m_physicalDeviceProps.deviceID)
+  {
+    return false;
+  }
+  return memcmp(data.data() + sizeof(header), m_physicalDeviceProps.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void VulkanAppBase::SavePipelineCache()
+{
+  size_t size = 0;
+  auto result = vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr);
+  if (result != VK_SUCCESS || size == 0)
+  {
+    return;
+  }
+  std::vector<char> data(size);
+  result = vkGetPipelineCacheData(m_device, m_pipelineCache, &size, data.data());
+  if (result != VK_SUCCESS)
+  {
+    return;
+  }
+  std::ofstream outfile(PipelineCacheFileName, std::ios::binary | std::ios::trunc);
+  outfile.write(data.data(), std::streamsize(size));
+}
+
+void VulkanAppBase::CreateCommandPool()
+{
+  VkCommandPoolCreateInfo cmdPoolCI{
+    VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    nullptr,
+    VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+    m_gfxQueueIndex
+  };
+  auto result = vkCreateCommandPool(m_device, &cmdPoolCI, nullptr, &m_commandPool);
+  ThrowIfFailed(result, "vkCreateCommandPool Failed.");
+
+  // コンピュートキューへ発行するコマンドバッファ用.
+  cmdPoolCI.queueFamilyIndex = m_computeQueueIndex;
+  result = vkCreateCommandPool(m_device, &cmdPoolCI, nullptr, &m_computeCommandPool);
+  ThrowIfFailed(result, "vkCreateCommandPool Failed.");
+}
+
+void VulkanAppBase::CreateDescriptorPool()
+{
+  VkResult result;
+  // ImGui はセットを個別に解放することがあるため、こちらは FREE_DESCRIPTOR_SET_BIT を付ける.
+  VkDescriptorPoolSize poolSize[] = {
+    { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, ImGuiDescriptorSets },
+  };
+  VkDescriptorPoolCreateInfo descPoolCI{
+    VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+    nullptr,  VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+    ImGuiDescriptorSets, // maxSets
+    _countof(poolSize), poolSize,
+  };
+  result = vkCreateDescriptorPool(m_device, &descPoolCI, nullptr, &m_descriptorPool);
+  ThrowIfFailed(result, "vkCreateDescriptorPool Failed.");
+
+  m_descriptorAllocator = std::make_unique<DescriptorAllocator>(m_device);
+
+  if (m_isBindlessSupported)
+  {
+    // テクスチャ(+サンプラー)はサンプラーとイメージの両方の上限に数えられる.
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProps{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT
+    };
+    VkPhysicalDeviceProperties2 props2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &indexingProps };
+    vkGetPhysicalDeviceProperties2(m_physicalDevice, &props2);
+    auto maxTextures = (std::min)({
+      BindlessMaxTextures,
+      indexingProps.maxPerStageDescriptorUpdateAfterBindSamplers,
+      indexingProps.maxPerStageDescriptorUpdateAfterBindSampledImages,
+      indexingProps.maxDescriptorSetUpdateAfterBindSamplers,
+      indexingProps.maxDescriptorSetUpdateAfterBindSampledImages });
+    auto maxBuffers = (std::min)({
+      BindlessMaxBuffers,
+      indexingProps.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+      indexingProps.maxDescriptorSetUpdateAfterBindStorageBuffers });
+    m_bindlessTable = std::make_unique<BindlessDescriptorTable>(m_device, maxTextures, maxBuffers);
+  }
+}
+
+VulkanAppBase::MemoryAllocation VulkanAppBase::AllocateMemory(VkBuffer buffer, VkMemoryPropertyFlags memProps, MemoryCategory category)
+{
+  VkMemoryRequirements reqs;
+  vkGetBufferMemoryRequirements(m_device, buffer, &reqs);
+  auto memoryTypeIndex = GetMemoryTypeIndex(reqs.memoryTypeBits, memProps);
+  return m_memoryAllocator->Allocate(reqs, memoryTypeIndex, DeviceMemoryAllocator::ResourceKind_Linear, category);
+}
+
+VulkanAppBase::MemoryAllocation VulkanAppBase::AllocateMemory(VkImage image, VkMemoryPropertyFlags memProps, MemoryCategory category)
+{
+  VkMemoryRequirements reqs;
+  vkGetImageMemoryRequirements(m_device, image, &reqs);
+  auto memoryTypeIndex = GetMemoryTypeIndex(reqs.memoryTypeBits, memProps);
+  if (reqs.size >= m_memoryAllocator->GetDedicatedThreshold(memoryTypeIndex))
+  {
+    // 大きなイメージは専用割り当てとする.
+    return m_memoryAllocator->AllocateDedicated(reqs, memoryTypeIndex, image, VK_NULL_HANDLE, category);
+  }
+  return m_memoryAllocator->Allocate(reqs, memoryTypeIndex, DeviceMemoryAllocator::ResourceKind_Optimal, category);
+}
+
+VulkanAppBase::MemoryCategory VulkanAppBase::GetBufferCategory(VkBufferUsageFlags usage)
+{
+  if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+  {
+    return DeviceMemoryAllocator::Category_Vertex;
+  }
+  if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+  {
+    return DeviceMemoryAllocator::Category_Index;
+  }
+  if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+  {
+    return DeviceMemoryAllocator::Category_Uniform;
+  }
+  // 転送にしか使わないバッファはステージング(読み戻しを含む)とみなす.
+  if ((usage & ~(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)) == 0)
+  {
+    return DeviceMemoryAllocator::Category_Staging;
+  }
+  return DeviceMemoryAllocator::Category_Other;
+}
+
+VulkanAppBase::MemoryCategory VulkanAppBase::GetImageCategory(VkImageUsageFlags usage)
+{
+  // GPU が書き込むイメージはレンダーターゲットとして数える.
+  VkImageUsageFlags targetUsage =
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+  if (usage & targetUsage)
+  {
+    return DeviceMemoryAllocator::Category_RenderTarget;
+  }
+  return DeviceMemoryAllocator::Category_Texture;
+}
+
+void VulkanAppBase::FreeMemory(const MemoryAllocation& allocation)
+{
+  m_memoryAllocator->Free(allocation);
+}
+
+void VulkanAppBase::ReportUploadStatistics()
+{
+  const auto& stats = m_uploadManager->GetStatistics();
+  std::stringstream ss;
+  ss << "[Upload] submits: " << stats.submitCount
+    << ", uploads: " << stats.uploadCount
+    << ", bytes: " << stats.bytesUploaded / 1024 << "KB"
+    << ", staging overflow: " << stats.overflowCount
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportDriverObjectStatistics(const UploadManager::Statistics& uploadStatsBefore)
+{
+  // 要求数は再利用を行わない場合の生成数に相当する.
+  const auto& stats = m_driverObjectStats;
+  const auto& uploadStats = m_uploadManager->GetStatistics();
+  std::stringstream ss;
+  ss << "[DriverObjects] Prepare: command buffers requested: " << stats.commandBufferRequests
+    << " (vkAllocateCommandBuffers: " << stats.commandBufferAllocateCalls << ")"
+    << ", fences requested: " << stats.fenceRequests
+    << " (vkCreateFence: " << stats.fenceCreations << ")"
+    << ", upload command buffers: " << uploadStats.commandBufferAllocations - uploadStatsBefore.commandBufferAllocations
+    << ", upload fences: " << uploadStats.fenceCreations - uploadStatsBefore.fenceCreations
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportDescriptorStatistics()
+{
+  const auto& stats = m_descriptorAllocator->GetStatistics();
+  std::stringstream ss;
+  ss << "[Descriptor] pools: " << stats.poolCount
+    << ", persistent sets: " << stats.persistentSets
+    << ", cache hits: " << stats.cacheHits << "/" << stats.cacheHits + stats.cacheMisses
+    << ", evicted sets: " << stats.evictedSets << " (reused " << stats.reusedSets << ")"
+    << ", frame sets: " << stats.frameSets << " (peak " << stats.peakFrameSets << "/frame)"
+    << ", pool resets: " << stats.poolResets
+    << std::endl;
+  if (m_bindlessTable)
+  {
+    const auto& bindlessStats = m_bindlessTable->GetStatistics();
+    ss << "[Bindless] textures: " << bindlessStats.textures << "/" << m_bindlessTable->GetMaxTextures()
+      << ", buffers: " << bindlessStats.buffers << "/" << m_bindlessTable->GetMaxBuffers()
+      << ", descriptor writes: " << bindlessStats.descriptorWrites
+      << std::endl;
+  }
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportObjectStores()
+{
+  std::stringstream ss;
+  auto list = [&](const char* label, const std::vector<std::string>& names) {
+    ss << "[ObjectStore] " << label << ":";
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+      ss << (i == 0 ? " " : ", ") << names[i] << "#" << i;
+    }
+    ss << std::endl;
+  };
+  list("render passes", m_renderPassStore->GetNames());
+  list("pipeline layouts", m_pipelineLayoutStore->GetNames());
+  list("descriptor set layouts", m_descriptorSetLayoutStore->GetNames());
+  list("update templates", m_descriptorUpdateTemplateStore->GetNames());
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportRenderGraph(const RenderGraph* graph)
+{
+  const auto& stats = graph->GetStatistics();
+  std::stringstream ss;
+  ss << "[RenderGraph] " << graph->GetName() << ": passes " << stats.declaredPasses - stats.culledPasses << "/" << stats.declaredPasses << " (";
+  auto order = graph->GetPassOrder();
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    ss << (i == 0 ? "" : " -> ") << order[i];
+  }
+  ss << "), barriers/frame: " << stats.barrierBatches << " (" << stats.imageBarriers << " images)"
+    << ", transient: " << stats.transientImages << " images in " << stats.memorySlots << " allocations, "
+    << stats.transientBytes / 1024 << "KB (unaliased " << stats.unaliasedBytes / 1024 << "KB"
+    << ", saved " << (stats.unaliasedBytes - stats.transientBytes) / 1024 << "KB)"
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportPipelineCacheStatistics(double prepareMs)
+{
+  std::stringstream ss;
+  ss << "[PipelineCache] " << (m_pipelineCacheLoadedSize > 0 ? "warm" : "cold")
+    << " (loaded: " << m_pipelineCacheLoadedSize << "B)"
+    << ", Prepare: " << prepareMs << "ms"
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportShaderStatistics()
+{
+  const auto& stats = m_shaderLibrary->GetStatistics();
+  std::stringstream ss;
+  ss << "[Shader] loads: " << stats.loadRequests
+    << ", files mapped: " << stats.filesMapped
+    << ", modules: " << stats.modulesCreated
+    << ", time: " << stats.loadMs << "ms"
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportCpuPhaseStatistics()
+{
+  std::stringstream ss;
+  ss << "[CpuPhase] frames: " << m_cpuProfiler->GetSampleCount()
+    << ", dominant: " << CpuProfiler::GetPhaseName(m_cpuProfiler->GetDominantPhase());
+  for (int i = 0; i < CpuProfiler::Phase_Count; ++i)
+  {
+    auto p = m_cpuProfiler->ComputePercentiles(CpuProfiler::Phase(i));
+    ss << ", " << CpuProfiler::GetPhaseName(CpuProfiler::Phase(i))
+      << " " << p.p50 << "/" << p.p95 << "/" << p.p99 << "ms";
+  }
+  ss << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+}
+
+void VulkanAppBase::ReportMemoryStatistics()
+{
+  auto stats = m_memoryAllocator->GetStatistics();
+  std::stringstream ss;
+  ss << "[DeviceMemory] allocations: " << stats.allocationCount
+    << ", vkDeviceMemory: " << stats.deviceMemoryCount << " (dedicated: " << stats.dedicatedCount << ")"
+    << ", reserved: " << stats.bytesReserved / 1024 << "KB"
+    << ", used: " << stats.bytesUsed / 1024 << "KB"
+    << ", wasted: " << stats.bytesWasted << "B"
+    << ", fragmentation: " << stats.fragmentation
+    << std::endl;
+  book_util::WriteLog(ss.str().c_str());
+  book_util::WriteLog(BuildMemoryReport().c_str());
+}
+
+bool VulkanAppBase::QueryMemoryBudget(VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget)
+{
+  if (!m_isMemoryBudgetSupported)
+  {
+    return false;
+  }
+  budget = VkPhysicalDeviceMemoryBudgetPropertiesEXT{};
+  budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  VkPhysicalDeviceMemoryProperties2 memProps2{};
+  memProps2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  memProps2.pNext = &budget;
+  vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &memProps2);
+  return true;
+}
+
+std::string VulkanAppBase::BuildMemoryReport()
+{
+  std::stringstream ss;
+  ss << "[DeviceMemory] by category (live / peak):" << std::endl;
+  for (int i = 0; i < DeviceMemoryAllocator::Category_Count; ++i)
+  {
+    auto category = MemoryCategory(i);
+    auto stats = m_memoryAllocator->GetCategoryStatistics(category);
+    ss << "  " << DeviceMemoryAllocator::GetCategoryName(category)
+      << ": " << stats.allocationCount << " allocations, "
+      << stats.bytesUsed / 1024 << "KB / " << stats.peakBytes / 1024 << "KB" << std::endl;
+  }
+
+  // 使用量はドライバが数えたもので、このアプリ以外の確保も含む.
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget;
+  auto hasBudget = QueryMemoryBudget(budget);
+  for (uint32_t i = 0; i < m_physicalMemProps.memoryHeapCount; ++i)
+  {
+    const auto& heap = m_physicalMemProps.memoryHeaps[i];
+    ss << "  heap " << i << ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : " (host)")
+      << ": size " << heap.size / (1024 * 1024) << "MB";
+    if (hasBudget)
+    {
+      ss << ", usage " << budget.heapUsage[i] / (1024 * 1024) << "MB"
+        << ", budget " << budget.heapBudget[i] / (1024 * 1024) << "MB";
+    }
+    ss << std::endl;
+  }
+  if (!hasBudget)
+  {
+    ss << "  " << VK_EXT_MEMORY_BUDGET_EXTENSION_NAME << " is not supported." << std::endl;
+  }
+  return ss.str();
+}
+
+bool VulkanAppBase::DumpMemoryReport(const char* fileName)
+{
+  auto report = BuildMemoryReport();
+  book_util::WriteLog(report.c_str());
+  std::ofstream outfile(fileName);
+  if (!outfile)
+  {
+    return false;
+  }
+  outfile << report;
+  return bool(outfile);
+}
+
+void VulkanAppBase::DrawMemoryImGui()
+{
+  ImGui::Begin("GPU Memory");
+  ImGui::Columns(4, "gpu_memory");
+  ImGui::Text("Category"); ImGui::NextColumn();
+  ImGui::Text("Count"); ImGui::NextColumn();
+  ImGui::Text("Live(KB)"); ImGui::NextColumn();
+  ImGui::Text("Peak(KB)"); ImGui::NextColumn();
+  ImGui::Separator();
+  for (int i = 0; i < DeviceMemoryAllocator::Category_Count; ++i)
+  {
+    auto category = MemoryCategory(i);
+    auto stats = m_memoryAllocator->GetCategoryStatistics(category);
+    ImGui::Text("%s", DeviceMemoryAllocator::GetCategoryName(category)); ImGui::NextColumn();
+    ImGui::Text("%u", stats.allocationCount); ImGui::NextColumn();
+    ImGui::Text("%llu", (unsigned long long)(stats.bytesUsed / 1024)); ImGui::NextColumn();
+    ImGui::Text("%llu", (unsigned long long)(stats.peakBytes / 1024)); ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+  ImGui::Separator();
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget;
+  if (QueryMemoryBudget(budget))
+  {
+    for (uint32_t i = 0; i < m_physicalMemProps.memoryHeapCount; ++i)
+    {
+      if (budget.heapBudget[i] == 0)
+      {
+        continue;
+      }
+      char label[64];
+      snprintf(label, sizeof(label), "Heap%u %lluMB / %lluMB", i,
+        (unsigned long long)(budget.heapUsage[i] / (1024 * 1024)), (unsigned long long)(budget.heapBudget[i] / (1024 * 1024)));
+      ImGui::ProgressBar(float(double(budget.heapUsage[i]) / double(budget.heapBudget[i])), ImVec2(-1, 0), label);
+    }
+  }
+  else
+  {
+    ImGui::Text("VK_EXT_memory_budget is not supported.");
+  }
+  if (ImGui::Button("Dump"))
+  {
+    DumpMemoryReport(MemoryReportFileName);
+  }
+  ImGui::End();
+}
+
+void VulkanAppBase::DrawTraceImGui()
+{
+  ImGui::Begin("Trace");
+  if (IsTraceCapturing())
+  {
+    ImGui::Text("Capturing frame %u (%u events)",
+      m_traceRecorder->GetFrameIndex(), uint32_t(m_traceRecorder->GetEventCount()));
+  }
+  else if (ImGui::Button("Capture"))
+  {
+    StartTraceCapture(TraceFileName, TraceCaptureFrames);
+  }
+  ImGui::Text("GPU clock: %s", m_isCalibratedTimestampsSupported ? "VK_EXT_calibrated_timestamps" : "estimated");
+  ImGui::End();
+}
+
+
+#define GetInstanceProcAddr(FuncName) \
+  m_##FuncName = reinterpret_cast<PFN_##FuncName>(vkGetInstanceProcAddr(m_vkInstance, #FuncName))
+
+void VulkanAppBase::EnableDebugReport()
+{
+  GetInstanceProcAddr(vkCreateDebugReportCallbackEXT);
+  GetInstanceProcAddr(vkDebugReportMessageEXT);
+  GetInstanceProcAddr(vkDestroyDebugReportCallbackEXT);
+
+  VkDebugReportFlagsEXT flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT;
+
+  VkDebugReportCallbackCreateInfoEXT drcCI{};
+  drcCI.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
+  drcCI.flags = flags;
+  drcCI.pfnCallback = &DebugReportCallback;
+  auto result = m_vkCreateDebugReportCallbackEXT(m_vkInstance, &drcCI, nullptr, &m_debugReport);
+  ThrowIfFailed(result, "vkCreateDebugReportCallback Failed.");
+}
+
+void VulkanAppBase::DisableDebugReport()
+{
+  if (m_vkDestroyDebugReportCallbackEXT)
+  {
+    m_vkDestroyDebugReportCallbackEXT(m_vkInstance, m_debugReport, nullptr);
+  }
+}
+
+void VulkanAppBase::MsgLoopMinimizedWindow()
+{
+  int width, height;
+  do
+  {
+    glfwGetWindowSize(m_window, &width, &height);
+    glfwWaitEvents();
+  } while (width == 0 || height == 0);
+}
@@ -1,220 +1,647 @@
-#pragma once
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <windows.h>
-
-#include <string>
-#include <vector>
-#include <memory>
-#include <unordered_map>
-#include <functional>
-
-#define VK_USE_PLATFORM_WIN32_KHR
-#define GLFW_INCLUDE_VULKAN
-#define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3.h>
-#include <GLFW/glfw3native.h>
-#include <vulkan/vk_layer.h>
-#include <vulkan/vulkan_win32.h>
-
-#include "Swapchain.h"
-
-template<class T>
-class VulkanObjectStore
-{
-public:
-  VulkanObjectStore(std::function<void(T)> disposer) : m_disposeFunc(disposer) { }
-  void Cleanup() {
-    std::for_each(m_storeMap.begin(), m_storeMap.end(), [&](auto v) { m_disposeFunc(v.second); });
-  }
-
-  void Register(const std::string& name, T data)
-  {
-    m_storeMap[name] = data;
-  }
-  T Get(const std::string& name) const
-  {
-    auto it = m_storeMap.find(name);
-    if (it == m_storeMap.end())
-    {
-      return VK_NULL_HANDLE;
-    }
-    return it->second;
-  }
-private:
-  std::unordered_map<std::string, T> m_storeMap;
-  std::function<void(T)> m_disposeFunc;
-};
-
-class VulkanAppBase {
-public:
-  VulkanAppBase() :m_isMinimizedWindow(false), m_isFullscreen(false) { }
-  virtual ~VulkanAppBase() { }
-
-  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
-  virtual bool OnMouseButtonDown(int button);
-  virtual bool OnMouseButtonUp(int button);
-  virtual bool OnMouseMove(int dx, int dy);
-
-  uint32_t GetMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestProps) const;
-  void SwitchFullscreen(GLFWwindow* window);
-
-  void Initialize(GLFWwindow* window, VkFormat format, bool isFullscreen);
-  void Terminate();
-
-  virtual void Render() = 0;
-  virtual void Prepare() = 0;
-  virtual void Cleanup() = 0;
-
-  VkDescriptorPool GetDescriptorPool() const { return m_descriptorPool; }
-  VkDevice GetDevice() { return m_device; }
-  const Swapchain* GetSwapchain() const { return m_swapchain.get(); }
-
-  VkPipelineLayout GetPipelineLayout(const std::string& name) { return m_pipelineLayoutStore->Get(name); }
-  VkDescriptorSetLayout GetDescriptorSetLayout(const std::string& name) { return m_descriptorSetLayoutStore->Get(name); }
-  VkRenderPass GetRenderPass(const std::string& name) { return m_renderPassStore->Get(name); }
-
-  void RegisterLayout(const std::string& name, VkPipelineLayout layout) { m_pipelineLayoutStore->Register(name, layout); }
-  void RegisterLayout(const std::string& name, VkDescriptorSetLayout layout) { m_descriptorSetLayoutStore->Register(name, layout); }
-  void RegisterRenderPass(const std::string& name, VkRenderPass renderPass) { m_renderPassStore->Register(name, renderPass); }
-  struct BufferObject
-  {
-    VkBuffer buffer;
-    VkDeviceMemory memory;
-  };
-  struct ImageObject
-  {
-    VkImage image;
-    VkDeviceMemory memory;
-    VkImageView view;
-  };
-
-  BufferObject CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
-  ImageObject CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage);
-  VkFramebuffer CreateFramebuffer(VkRenderPass renderPass, uint32_t width, uint32_t height, uint32_t viewCount, VkImageView* views);
-  VkFence CreateFence();
-  VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout dsLayout);
-
-  void DestroyBuffer(BufferObject bufferObj);
-  void DestroyImage(ImageObject imageObj);
-  void DestroyFramebuffers(uint32_t count, VkFramebuffer* framebuffers);
-  void DestroyFence(VkFence fence);
-  void DeallocateDescriptorSet(VkDescriptorSet dsLayout);
-
-  VkCommandBuffer CreateCommandBuffer(bool bBegin = true);
-  void FinishCommandBuffer(VkCommandBuffer command);
-  void DestroyCommandBuffer(VkCommandBuffer command);
-
-  VkRect2D GetSwapchainRenderArea() const;
-
-  std::vector<BufferObject> CreateUniformBuffers(uint32_t size, uint32_t imageCount);
-
-  // zXg猩郁̈Ƀf[^.ȉobt@ΏۂɎgp.
-  // - Xe[WOobt@
-  // - jtH[obt@
-  void WriteToHostVisibleMemory(VkDeviceMemory memory, uint32_t size, const void* pData);
-
-  void AllocateCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands);
-  void FreeCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands);
-
-  void TransferStageBufferToImage(const BufferObject& srcBuffer, const ImageObject& dstImage, const VkBufferImageCopy* region);
-
-
-  // _[pX̐.
-  VkRenderPass CreateRenderPass(VkFormat colorFormat, VkFormat depthFormat = VK_FORMAT_UNDEFINED, VkImageLayout layoutColor = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-
-  struct ModelData
-  {
-    uint32_t indexCount;
-    uint32_t vertexCount;
-    BufferObject resVertexBuffer;
-    BufferObject resIndexBuffer;
-  };
-
-  // Pf̃f[^GPU֓].
-  template<class T>
-  ModelData CreateSimpleModel(const std::vector<T>& vertices, const std::vector<uint32_t>& indices)
-  {
-    ModelData model;
-    VkMemoryPropertyFlags srcMemoryProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    VkMemoryPropertyFlags dstMemoryProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    VkBufferUsageFlags usageVB = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-    VkBufferUsageFlags usageIB = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-    VkBufferCopy copyVB{}, copyIB{};
-
-    auto bufferSize = uint32_t(sizeof(T) * vertices.size());
-    auto uploadVB = CreateBuffer(bufferSize, usageVB, srcMemoryProps);
-    model.resVertexBuffer = CreateBuffer(bufferSize, usageVB, dstMemoryProps);
-    WriteToHostVisibleMemory(uploadVB.memory, bufferSize, vertices.data());
-    model.vertexCount = uint32_t(vertices.size());
-    copyVB.size = bufferSize;
-
-    bufferSize = uint32_t(sizeof(uint32_t) * indices.size());
-    auto uploadIB = CreateBuffer(bufferSize, usageIB, srcMemoryProps);
-    model.resIndexBuffer = CreateBuffer(bufferSize, usageIB, dstMemoryProps);
-    WriteToHostVisibleMemory(uploadIB.memory, bufferSize, indices.data());
-    model.indexCount = uint32_t(indices.size());
-    copyIB.size = bufferSize;
-
-    auto command = CreateCommandBuffer();
-    vkCmdCopyBuffer(command, uploadVB.buffer, model.resVertexBuffer.buffer, 1, &copyVB);
-    vkCmdCopyBuffer(command, uploadIB.buffer, model.resIndexBuffer.buffer, 1, &copyIB);
-    FinishCommandBuffer(command);
-
-    vkFreeCommandBuffers(m_device, m_commandPool, 1, &command);
-    DestroyBuffer(uploadVB);
-    DestroyBuffer(uploadIB);
-
-    return model;
-  }
-
- private:
-  void CreateInstance();
-  void SelectGraphicsQueue();
-  void CreateDevice();
-  void CreateCommandPool();
-
-  // fobO|[gL.
-  void EnableDebugReport();
-  void DisableDebugReport();
-  PFN_vkCreateDebugReportCallbackEXT	m_vkCreateDebugReportCallbackEXT;
-  PFN_vkDebugReportMessageEXT	m_vkDebugReportMessageEXT;
-  PFN_vkDestroyDebugReportCallbackEXT m_vkDestroyDebugReportCallbackEXT;
-  VkDebugReportCallbackEXT  m_debugReport;
-
-  void CreateDescriptorPool();
-
-  // ImGui
-  void PrepareImGui();
-  void CleanupImGui();
-protected:
-  VkDeviceMemory AllocateMemory(VkBuffer image, VkMemoryPropertyFlags memProps);
-  VkDeviceMemory AllocateMemory(VkImage image, VkMemoryPropertyFlags memProps);
-  // ŏbZ[W[v.
-  void MsgLoopMinimizedWindow();
-
-  VkDevice  m_device;
-  VkPhysicalDevice m_physicalDevice;
-  VkInstance m_vkInstance;
-
-  VkPhysicalDeviceMemoryProperties m_physicalMemProps;
-  VkQueue m_deviceQueue;
-  uint32_t  m_gfxQueueIndex;
-  VkCommandPool m_commandPool;
-
-  VkSemaphore m_renderCompletedSem, m_presentCompletedSem;
-
-  VkDescriptorPool m_descriptorPool;
-
-  bool m_isMinimizedWindow;
-  bool m_isFullscreen;
-  std::unique_ptr<Swapchain> m_swapchain;
-  GLFWwindow* m_window;
-
-  using RenderPassRegistry = VulkanObjectStore<VkRenderPass>;
-  using PipelineLayoutManager = VulkanObjectStore<VkPipelineLayout>;
-  using DescriptorSetLayoutManager = VulkanObjectStore<VkDescriptorSetLayout>;
-  std::unique_ptr<RenderPassRegistry> m_renderPassStore;
-  std::unique_ptr<PipelineLayoutManager> m_pipelineLayoutStore;
-  std::unique_ptr<DescriptorSetLayoutManager> m_descriptorSetLayoutStore;
+#pragma once
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+
+#define GLFW_INCLUDE_VULKAN
+#if defined(_WIN32)
+#define VK_USE_PLATFORM_WIN32_KHR
+#define GLFW_EXPOSE_NATIVE_WIN32
+#endif
+#include <GLFW/glfw3.h>
+#include <GLFW/glfw3native.h>
+#include <vulkan/vk_layer.h>
+#if defined(_WIN32)
+#include <vulkan/vulkan_win32.h>
+#endif
+
+#include "VulkanBookUtil.h"
+#include "Swapchain.h"
+#include "DeviceMemoryAllocator.h"
+#include "UniformRingBuffer.h"
+#include "UploadManager.h"
+#include "DescriptorAllocator.h"
+#include "BindlessDescriptorTable.h"
+#include "ShaderLibrary.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "FrameRecorder.h"
+#include "TraceRecorder.h"
+#include "RenderGraph.h"
+
+// 名前を付けて登録する Vulkan オブジェクトの置き場.
+// 名前は登録時に番号へ置き換える. 描画ループでは Handle で配列を直接引き、文字列のハッシュを避ける.
+// 名前での検索は準備処理とデバッグ表示用.
+template<class T>
+class VulkanObjectStore
+{
+public:
+  // 型ごとに別の型となるため、レンダーパスとレイアウトの取り違えはコンパイル時に分かる.
+  struct Handle
+  {
+    uint32_t index;
+    bool IsValid() const { return index != InvalidIndex; }
+  };
+  static const uint32_t InvalidIndex = ~0u;
+  typedef void (VKAPI_PTR *Disposer)(VkDevice device, T object, const VkAllocationCallbacks* pAllocator);
+
+  VulkanObjectStore(VkDevice device, Disposer disposer) : m_device(device), m_disposeFunc(disposer) { }
+  void Cleanup()
+  {
+    for (auto object : m_objects)
+    {
+      if (object != VK_NULL_HANDLE)
+      {
+        m_disposeFunc(m_device, object, nullptr);
+      }
+    }
+    m_objects.clear();
+    m_names.clear();
+    m_indices.clear();
+  }
+
+  // 登録したオブジェクトは Cleanup で破棄する. 同じ名前の登録はどちらを破棄すべきか分からないため例外とする.
+  Handle Register(const std::string& name, T data)
+  {
+    if (m_indices.find(name) != m_indices.end())
+    {
+      m_disposeFunc(m_device, data, nullptr);
+      throw book_util::VulkanException("VulkanObjectStore: \"" + name + "\" is already registered.");
+    }
+    auto index = uint32_t(m_objects.size());
+    m_objects.push_back(data);
+    m_names.push_back(name);
+    m_indices.emplace(name, index);
+    return Handle{ index };
+  }
+  Handle Find(const std::string& name) const
+  {
+    auto it = m_indices.find(name);
+    if (it == m_indices.end())
+    {
+      return Handle{ InvalidIndex };
+    }
+    return Handle{ it->second };
+  }
+  T Get(Handle handle) const
+  {
+    if (handle.index >= m_objects.size())
+    {
+      return VK_NULL_HANDLE;
+    }
+    return m_objects[handle.index];
+  }
+  T Get(const std::string& name) const { return Get(Find(name)); }
+
+  // 登録順の名前. Handle の番号と一致する.
+  const std::vector<std::string>& GetNames() const { return m_names; }
+  size_t GetCount() const { return m_objects.size(); }
+private:
+  std::vector<T> m_objects;
+  std::vector<std::string> m_names;
+  std::unordered_map<std::string, uint32_t> m_indices;
+  VkDevice m_device;
+  Disposer m_disposeFunc;
+};
+
+class VulkanAppBase {
+public:
+  VulkanAppBase() :m_isMinimizedWindow(false), m_isFullscreen(false), m_isHeadless(false), m_isProfilerHudVisible(true), m_window(nullptr), m_framesInFlight(DefaultFramesInFlight), m_frameIndex(0), m_lastImageIndex(0), m_traceRequestFrames(0) { }
+  virtual ~VulkanAppBase() { }
+
+  virtual bool OnSizeChanged(uint32_t width, uint32_t height);
+  virtual bool OnMouseButtonDown(int button);
+  virtual bool OnMouseButtonUp(int button);
+  virtual bool OnMouseMove(int dx, int dy);
+
+  uint32_t GetMemoryTypeIndex(uint32_t requestBits, VkMemoryPropertyFlags requestProps) const;
+  void SwitchFullscreen(GLFWwindow* window);
+
+  void Initialize(GLFWwindow* window, VkFormat format, bool isFullscreen);
+  // 使用する物理デバイスを番号または名前の一部で指定する. Initialize の前に呼ぶ.
+  // 空の場合は環境変数 VULKAN_BOOK_DEVICE、それも無ければ評価値の最も高いデバイスを使う.
+  void SetPreferredDevice(const std::string& device) { m_preferredDevice = device; }
+  void Terminate();
+
+  // ウィンドウを使わずに初期化する. スワップチェインの代わりにオフスクリーンのイメージへ描画する.
+  void InitializeHeadless(uint32_t width, uint32_t height, VkFormat format);
+  // frameCount 回 Render を呼び、readbackFile が指定されていれば最後のフレームを PPM で書き出す.
+  void RunHeadless(uint32_t frameCount, const char* readbackFile = nullptr);
+  bool IsHeadless() const { return m_isHeadless; }
+
+  // アプリが使用するインスタンス/デバイスの機能. 列挙したものだけを有効化する.
+  // 必須のものが使えない場合は初期化で例外とする.
+  struct CapabilityProfile
+  {
+    std::vector<const char*> instanceExtensions;
+    std::vector<const char*> deviceExtensions;
+    std::vector<const char*> optionalDeviceExtensions;  // 使える場合のみ有効化する.
+    VkPhysicalDeviceFeatures features;
+    VkPhysicalDeviceFeatures optionalFeatures;          // 使える場合のみ有効化する.
+    bool optionalBindless;  // 使える場合のみディスクリプタインデックスを有効化し、GetBindlessTable を用意する.
+  };
+
+  // ベンチマークで切り替える設定の組み合わせ.
+  struct BenchmarkVariant
+  {
+    std::string name;
+    std::function<void()> apply;
+  };
+  struct BenchmarkOptions
+  {
+    std::string appName;
+    uint32_t warmupFrames;
+    uint32_t measuredFrames;
+    std::string reportFile;
+  };
+  // ヘッドレスで初期化した後に呼ぶ. 設定ごとにウォームアップと計測を行い、JSON で結果を書き出す.
+  void RunBenchmark(const BenchmarkOptions& options);
+
+  // 出力と性能の退行検出の設定.
+  // 参照画像は <referenceDir>/<appName>_<設定名>.ppm、基準時間は <referenceDir>/<appName>_baseline.txt に置く.
+  struct RegressionOptions
+  {
+    std::string appName;
+    std::string referenceDir;
+    uint32_t warmupFrames;
+    uint32_t measuredFrames;
+    double minPsnr;             // これを下回ると画像の不一致とする(dB).
+    double maxSlowdownPercent;  // 基準時間からの増加がこれを超えると性能の劣化とする.
+    bool updateReference;       // 比較せずに参照画像と基準時間を書き直す.
+  };
+  // ヘッドレスで初期化した後に呼ぶ. 設定ごとに固定の姿勢で描画した画像と平均フレーム時間を参照と比較する.
+  // 参照が無い項目は記録のみ行う. 戻り値は不合格の項目数.
+  uint32_t RunRegression(const RegressionOptions& options);
+
+  // フレームの入力(SerializeFrameInputs)とユニフォームの内容の記録と再生. Initialize の後に呼ぶ.
+  void StartRecording(const char* fileName, const std::string& appName);
+  // 記録されたフレーム数を返す. 記録を使い切るまで、各フレームの入力は記録で上書きされる.
+  uint32_t StartReplay(const char* fileName, const std::string& appName);
+
+  // 次のフレームから frameCount フレームの CPU のフェーズと GPU の計測区間を Chrome の trace_event 形式で書き出す.
+  // 書き出しは GPU の結果が揃う(処理中のフレーム数だけ後の)フレームで行う.
+  void StartTraceCapture(const std::string& fileName, uint32_t frameCount);
+  bool IsTraceCapturing() const { return m_traceRequestFrames > 0 || (m_traceRecorder && m_traceRecorder->IsActive()); }
+
+  // 表示(ヘッドレス時は描画)済みのイメージを RGBA8 で読み戻す.
+  std::vector<uint8_t> ReadbackSwapchainImage(uint32_t imageIndex);
+  uint32_t GetLastImageIndex() const { return m_lastImageIndex; }
+  static bool WriteImageFile(const char* fileName, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba);
+  // WriteImageFile で書き出した PPM(P6) を RGBA8 で読み込む.
+  static bool ReadImageFile(const char* fileName, uint32_t* width, uint32_t* height, std::vector<uint8_t>& rgba);
+  // RGB の平均二乗誤差から求めた PSNR(dB). 一致する場合は無限大.
+  static double ComputePsnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b);
+
+  virtual void Render() = 0;
+  virtual void Prepare() = 0;
+  virtual void Cleanup() = 0;
+
+  VkDescriptorPool GetDescriptorPool() const { return m_descriptorPool; }
+  VkDevice GetDevice() { return m_device; }
+  const Swapchain* GetSwapchain() const { return m_swapchain.get(); }
+
+  // 全パイプラインの生成で使用する. 起動時にファイルから読み込み、終了時に書き出す.
+  VkPipelineCache GetPipelineCache() const { return m_pipelineCache; }
+
+  // シェーダーモジュールは Prepare の間だけ保持し、終了後にまとめて破棄する.
+  ShaderLibrary* GetShaderLibrary() { return m_shaderLibrary.get(); }
+
+  using RenderPassHandle = VulkanObjectStore<VkRenderPass>::Handle;
+  using PipelineLayoutHandle = VulkanObjectStore<VkPipelineLayout>::Handle;
+  using DescriptorSetLayoutHandle = VulkanObjectStore<VkDescriptorSetLayout>::Handle;
+  using DescriptorUpdateTemplateHandle = VulkanObjectStore<VkDescriptorUpdateTemplate>::Handle;
+
+  // 名前での取得は準備処理用. 毎フレーム引くものは Find* で得た Handle を保持して使う.
+  VkPipelineLayout GetPipelineLayout(const std::string& name) { return m_pipelineLayoutStore->Get(name); }
+  VkDescriptorSetLayout GetDescriptorSetLayout(const std::string& name) { return m_descriptorSetLayoutStore->Get(name); }
+  VkRenderPass GetRenderPass(const std::string& name) { return m_renderPassStore->Get(name); }
+  VkPipelineLayout GetPipelineLayout(PipelineLayoutHandle handle) const { return m_pipelineLayoutStore->Get(handle); }
+  VkDescriptorSetLayout GetDescriptorSetLayout(DescriptorSetLayoutHandle handle) const { return m_descriptorSetLayoutStore->Get(handle); }
+  VkRenderPass GetRenderPass(RenderPassHandle handle) const { return m_renderPassStore->Get(handle); }
+  PipelineLayoutHandle FindPipelineLayout(const std::string& name) const { return m_pipelineLayoutStore->Find(name); }
+  DescriptorSetLayoutHandle FindDescriptorSetLayout(const std::string& name) const { return m_descriptorSetLayoutStore->Find(name); }
+  RenderPassHandle FindRenderPass(const std::string& name) const { return m_renderPassStore->Find(name); }
+
+  PipelineLayoutHandle RegisterLayout(const std::string& name, VkPipelineLayout layout) { return m_pipelineLayoutStore->Register(name, layout); }
+  DescriptorSetLayoutHandle RegisterLayout(const std::string& name, VkDescriptorSetLayout layout) { return m_descriptorSetLayoutStore->Register(name, layout); }
+  RenderPassHandle RegisterRenderPass(const std::string& name, VkRenderPass renderPass) { return m_renderPassStore->Register(name, renderPass); }
+  // 登録済みのディスクリプタセットレイアウト layoutName のバインディングから更新テンプレートを作る.
+  // 以降 UpdateDescriptorSet/GetDescriptorSet にバインディング順に情報を詰めた構造体を渡して書き込める.
+  DescriptorUpdateTemplateHandle RegisterDescriptorUpdateTemplate(const std::string& layoutName, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+  DescriptorUpdateTemplateHandle FindDescriptorUpdateTemplate(const std::string& layoutName) const { return m_descriptorUpdateTemplateStore->Find(layoutName); }
+  using MemoryAllocation = DeviceMemoryAllocator::Allocation;
+  using MemoryCategory = DeviceMemoryAllocator::Category;
+  struct BufferObject
+  {
+    VkBuffer buffer;
+    MemoryAllocation allocation;
+  };
+  struct ImageObject
+  {
+    VkImage image;
+    MemoryAllocation allocation;
+    VkImageView view;
+  };
+
+  // 集計上の分類は usage から決める. 分類を明示する場合は category を指定する.
+  BufferObject CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
+  BufferObject CreateBuffer(uint32_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, MemoryCategory category);
+  ImageObject CreateTexture(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage);
+  static MemoryCategory GetBufferCategory(VkBufferUsageFlags usage);
+  static MemoryCategory GetImageCategory(VkImageUsageFlags usage);
+
+  // 分類ごとの確保量とヒープの使用量(VK_EXT_memory_budget が使える場合は予算も)を書き出す.
+  bool DumpMemoryReport(const char* fileName);
+  VkFramebuffer CreateFramebuffer(VkRenderPass renderPass, uint32_t width, uint32_t height, uint32_t viewCount, VkImageView* views);
+  VkFence CreateFence();
+  // 永続のディスクリプタセット. 個別には解放せず、終了時にまとめて破棄する.
+  VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout dsLayout);
+  // このフレームだけで使うディスクリプタセット. このスロットの次の BeginFrame で無効になる.
+  VkDescriptorSet AllocateFrameDescriptorSet(VkDescriptorSetLayout dsLayout);
+  // レイアウトと書き込む内容が同じ永続のセットを共有する. writes の dstSet は無視する.
+  VkDescriptorSet GetDescriptorSet(VkDescriptorSetLayout dsLayout, const std::vector<VkWriteDescriptorSet>& writes);
+  // 更新テンプレートでの書き込み. data は VkDescriptorBufferInfo 等をバインディング順に詰めた構造体.
+  // 名前での指定は準備処理用. 繰り返し使う場合は RegisterDescriptorUpdateTemplate の Handle を渡す.
+  template<class T>
+  void UpdateDescriptorSet(VkDescriptorSet descriptorSet, DescriptorUpdateTemplateHandle updateTemplate, const T& data)
+  {
+    UpdateDescriptorSetWithTemplate(descriptorSet, updateTemplate, &data, sizeof(T));
+  }
+  template<class T>
+  void UpdateDescriptorSet(VkDescriptorSet descriptorSet, const std::string& layoutName, const T& data)
+  {
+    UpdateDescriptorSet(descriptorSet, FindDescriptorUpdateTemplate(layoutName), data);
+  }
+  template<class T>
+  VkDescriptorSet GetDescriptorSet(DescriptorUpdateTemplateHandle updateTemplate, const T& data)
+  {
+    return GetDescriptorSetWithTemplate(updateTemplate, &data, sizeof(T));
+  }
+  template<class T>
+  VkDescriptorSet GetDescriptorSet(const std::string& layoutName, const T& data)
+  {
+    return GetDescriptorSet(FindDescriptorUpdateTemplate(layoutName), data);
+  }
+
+  void DestroyBuffer(BufferObject bufferObj);
+  void DestroyImage(ImageObject imageObj);
+  void DestroyFramebuffers(uint32_t count, VkFramebuffer* framebuffers);
+  void DestroyFence(VkFence fence);
+  // handle (バッファ、ビュー、サンプラー) を参照する GetDescriptorSet のキャッシュを外す.
+  // キーはハンドルの値なので、破棄後に同じ値で作られたリソースと取り違えないよう破棄時に呼ぶ.
+  // DestroyBuffer/DestroyImage では自動で呼ばれる. ビューやサンプラーを直接破棄した場合はアプリ側で呼ぶ.
+  template<class T>
+  void InvalidateDescriptorCache(T handle)
+  {
+    if (m_descriptorAllocator)
+    {
+      m_descriptorAllocator->Evict(handle);
+    }
+  }
+
+  // コマンドバッファとフェンスは再利用リストから取り出す.
+  // DestroyCommandBuffer はプールへ返さずリセットして再利用リストへ戻す.
+  VkCommandBuffer CreateCommandBuffer(bool bBegin = true);
+  void FinishCommandBuffer(VkCommandBuffer command);
+  void DestroyCommandBuffer(VkCommandBuffer command);
+
+  // コンピュートキューのファミリー用プールから確保する(開始状態にはしない).
+  VkCommandBuffer CreateComputeCommandBuffer();
+  void DestroyComputeCommandBuffer(VkCommandBuffer command);
+
+  // 専用のファミリーが無い場合、転送/コンピュートのキューはグラフィックスキューと同じものになる.
+  // 別ファミリーのキュー間で共有するリソースは所有権の移動(解放/獲得のバリア)が必要.
+  VkQueue GetGraphicsQueue() const { return m_deviceQueue; }
+  VkQueue GetTransferQueue() const { return m_transferQueue; }
+  VkQueue GetComputeQueue() const { return m_computeQueue; }
+  uint32_t GetGraphicsQueueFamily() const { return m_gfxQueueIndex; }
+  uint32_t GetTransferQueueFamily() const { return m_transferQueueIndex; }
+  uint32_t GetComputeQueueFamily() const { return m_computeQueueIndex; }
+  bool HasDedicatedTransferQueue() const { return m_transferQueueIndex != m_gfxQueueIndex; }
+  bool HasDedicatedComputeQueue() const { return m_computeQueueIndex != m_gfxQueueIndex; }
+  // コンピュートキューのコマンドバッファの計測区間に使う. キューがタイムスタンプに対応していない場合は null.
+  GpuProfiler* GetComputeProfiler() const { return m_computeTimestampValidBits != 0 ? m_gpuProfiler.get() : nullptr; }
+
+  VkRect2D GetSwapchainRenderArea() const;
+
+  // 同時に処理中とするフレーム数(スワップチェインのイメージ数とは独立).
+  // Initialize より前(派生クラスのコンストラクタ等)で設定する.
+  static const uint32_t DefaultFramesInFlight = 2;
+  void SetFramesInFlight(uint32_t count) { m_framesInFlight = std::max(count, 1u); }
+  uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+  // フレームごとのリソース(ユニフォームバッファ等)のインデックス.
+  uint32_t GetFrameIndex() const { return m_frameIndex; }
+
+  struct FrameContext
+  {
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    VkFence fence;
+    VkSemaphore presentCompleted; // スワップチェインイメージの取得完了.
+    VkSemaphore renderCompleted;  // 描画完了(表示の待ち合わせ).
+  };
+
+  // CPU がフェンス待ちで止まっていた時間から、CPU と GPU の並行度を見る.
+  struct FrameStatistics
+  {
+    uint32_t frameCount;
+    double cpuFrameMs;   // 合計のフレーム時間.
+    double fenceWaitMs;  // 合計のフェンス待ち時間.
+  };
+  const FrameStatistics& GetFrameStatistics() const { return m_frameStats; }
+
+  const DeviceMemoryAllocator* GetMemoryAllocator() const { return m_memoryAllocator.get(); }
+  UploadManager* GetUploadManager() { return m_uploadManager.get(); }
+
+  std::vector<BufferObject> CreateUniformBuffers(uint32_t size, uint32_t imageCount);
+  // バインドレスではユニフォームをストレージバッファとしても参照するため STORAGE_BUFFER_BIT を加える.
+  VkBufferUsageFlags GetUniformBufferUsage() const;
+
+  // CapabilityProfile::optionalBindless を指定し、デバイスが対応している場合のみ作られる. それ以外は null.
+  BindlessDescriptorTable* GetBindlessTable() { return m_bindlessTable.get(); }
+
+  // 処理中のフレーム数分の領域を持つユニフォームリングバッファを作成する.
+  // bytesPerFrame は 1 フレームで使用する最大量. 破棄は Terminate で行う.
+  UniformRingBuffer* CreateUniformRing(uint32_t bytesPerFrame);
+
+  // 描画グラフを作成する. 一時イメージはデバイスメモリアロケータから確保する. 破棄は Terminate で行う.
+  RenderGraph* CreateRenderGraph(const char* name);
+  // Compile 後のパスの並び、1 フレームのバリア数、一時イメージのメモリの共有で減った量を出力する.
+  void ReportRenderGraph(const RenderGraph* graph);
+
+  // ホストから見えるメモリ領域にデータを書き込む.以下バッファを対象に使用.
+  // - ステージングバッファ
+  // - ユニフォームバッファ
+  // メモリは確保時にマップ済みなので memcpy (+ 非コヒーレント時の Flush) のみとなる.
+  void WriteToHostVisibleMemory(const MemoryAllocation& allocation, uint32_t size, const void* pData);
+
+  // 永続マップされた領域に対する CPU 書き込みの反映/GPU 書き込みの取り込み.
+  // コヒーレントなメモリタイプでは何もしない.
+  void FlushMappedMemory(const MemoryAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+  void InvalidateMappedMemory(const MemoryAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+  void AllocateCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands);
+  void FreeCommandBufferSecondary(uint32_t count, VkCommandBuffer* pCommands);
+
+  void TransferStageBufferToImage(const BufferObject& srcBuffer, const ImageObject& dstImage, const VkBufferImageCopy* region);
+
+
+  // レンダーパスの生成. layoutColor が VK_IMAGE_LAYOUT_UNDEFINED の場合は GetPresentLayout() を使う.
+  VkRenderPass CreateRenderPass(VkFormat colorFormat, VkFormat depthFormat = VK_FORMAT_UNDEFINED, VkImageLayout layoutColor = VK_IMAGE_LAYOUT_UNDEFINED);
+  // スワップチェインのイメージへ描画した後のレイアウト.
+  // ヘッドレスでは VK_KHR_swapchain を有効にしないため PRESENT_SRC_KHR は使えない. 読み戻し用の転送元にする.
+  VkImageLayout GetPresentLayout() const { return m_isHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+
+  struct ModelData
+  {
+    uint32_t indexCount;
+    uint32_t vertexCount;
+    BufferObject resVertexBuffer;
+    BufferObject resIndexBuffer;
+  };
+
+  // 単純モデルのデータをGPUへ転送.
+  // 転送は UploadManager に積まれ、他の転送とまとめて発行される(Prepare 中のものは Initialize で発行).
+  template<class T>
+  ModelData CreateSimpleModel(const std::vector<T>& vertices, const std::vector<uint32_t>& indices)
+  {
+    ModelData model;
+    VkMemoryPropertyFlags dstMemoryProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    VkBufferUsageFlags usageVB = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    VkBufferUsageFlags usageIB = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    auto bufferSize = uint32_t(sizeof(T) * vertices.size());
+    model.resVertexBuffer = CreateBuffer(bufferSize, usageVB, dstMemoryProps);
+    m_uploadManager->UploadBuffer(model.resVertexBuffer.buffer, 0, vertices.data(), bufferSize);
+    model.vertexCount = uint32_t(vertices.size());
+
+    bufferSize = uint32_t(sizeof(uint32_t) * indices.size());
+    model.resIndexBuffer = CreateBuffer(bufferSize, usageIB, dstMemoryProps);
+    m_uploadManager->UploadBuffer(model.resIndexBuffer.buffer, 0, indices.data(), bufferSize);
+    model.indexCount = uint32_t(indices.size());
+
+    return model;
+  }
+
+ private:
+  void InitializeDevice();
+  void InitializeResources();
+  void CreateInstance();
+  VkPhysicalDevice SelectPhysicalDevice(const std::vector<VkPhysicalDevice>& physicalDevices);
+  // 使用できないデバイスは負の値. reason には評価の内訳(または使用できない理由)を入れる.
+  int ScorePhysicalDevice(VkPhysicalDevice physDev, std::string& reason);
+  void SelectQueueFamilies();
+  void CreateDevice();
+  void CreateCommandPool();
+  void CreatePipelineCache();
+  void SavePipelineCache();
+  bool IsPipelineCacheCompatible(const std::vector<char>& data) const;
+
+  // デバッグレポート有効化.
+  void EnableDebugReport();
+  void DisableDebugReport();
+  PFN_vkCreateDebugReportCallbackEXT	m_vkCreateDebugReportCallbackEXT;
+  PFN_vkDebugReportMessageEXT	m_vkDebugReportMessageEXT;
+  PFN_vkDestroyDebugReportCallbackEXT m_vkDestroyDebugReportCallbackEXT;
+  VkDebugReportCallbackEXT  m_debugReport;
+
+  void CreateDescriptorPool();
+
+  struct DescriptorUpdateTemplateInfo
+  {
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+    size_t dataSize;
+    std::vector<uint8_t> lastData;  // ベンチマークで使う、最後に書き込んだ内容.
+    VulkanObjectStore<VkDescriptorUpdateTemplate>::Handle updateTemplate;
+    DescriptorSetLayoutHandle setLayout;
+  };
+  void UpdateDescriptorSetWithTemplate(VkDescriptorSet descriptorSet, DescriptorUpdateTemplateHandle updateTemplate, const void* data, size_t dataSize);
+  VkDescriptorSet GetDescriptorSetWithTemplate(DescriptorUpdateTemplateHandle updateTemplate, const void* data, size_t dataSize);
+  const DescriptorUpdateTemplateInfo& GetDescriptorUpdateTemplateInfo(DescriptorUpdateTemplateHandle updateTemplate, const void* data, size_t dataSize);
+  // 登録済みのテンプレートごとに、書き込みの配列と更新テンプレートでの一括更新の時間を比べる.
+  void WriteDescriptorUpdateBenchmark(std::ostream& report);
+  // 登録済みのレンダーパスとパイプラインレイアウトを、名前と Handle で引く時間を比べる.
+  void WriteObjectLookupBenchmark(std::ostream& report);
+  // GetUniformWriteSizes の書き込みを、毎回 map/unmap する方式と永続マップとで比べる.
+  void WriteUniformUpdateBenchmark(std::ostream& report);
+
+  // メモリ割り当て状況の出力.
+  void ReportMemoryStatistics();
+  void ReportUploadStatistics();
+  void ReportDriverObjectStatistics(const UploadManager::Statistics& uploadStatsBefore);
+  void ReportDescriptorStatistics();
+  void ReportObjectStores();
+  void ReportFrameStatistics();
+  void ReportPipelineCacheStatistics(double prepareMs);
+  void ReportShaderStatistics();
+  void ReportCpuPhaseStatistics();
+  void ReportFrameRecorderStatistics();
+  void ReportTraceCapture(bool isWritten);
+  std::string BuildMemoryReport();
+  // 初期化の段階ごとの所要時間. 直前の区切りからの時間を name として記録する.
+  void LapStartupStage(const char* name);
+  void ReportStartupTimings();
+  // ヒープごとの予算と使用量. 拡張が無い場合は false.
+  bool QueryMemoryBudget(VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget);
+  void DrawMemoryImGui();
+  void DrawTraceImGui();
+  // GPU のタイムスタンプと CPU の時刻の対応付け.
+  // VK_EXT_calibrated_timestamps が使えない場合はタイムスタンプを書くだけのコマンドの発行と完了の時刻から推定する.
+  TraceRecorder::ClockCalibration CalibrateGpuClock();
+
+  void CreateFrameContexts();
+  void DestroyFrameContexts();
+
+  // ImGui
+  void PrepareImGui();
+  void CleanupImGui();
+protected:
+  // サブアロケータから確保する. バインドは呼び出し側で allocation.offset を指定して行う.
+  MemoryAllocation AllocateMemory(VkBuffer buffer, VkMemoryPropertyFlags memProps, MemoryCategory category);
+  MemoryAllocation AllocateMemory(VkImage image, VkMemoryPropertyFlags memProps, MemoryCategory category);
+  void FreeMemory(const MemoryAllocation& allocation);
+  // 最小化メッセージループ.
+  void MsgLoopMinimizedWindow();
+  // 既定ではウィンドウ表示(ヘッドレス時は除く)と計測に必要なものだけを要求する.
+  // robustBufferAccess はシェーダーが遅くなるためデバッグビルドでのみ有効にする.
+  // 派生クラスは基底の結果に必要な機能を追加して返す.
+  virtual CapabilityProfile GetCapabilityProfile();
+  // フレームの入力(カメラ、モード等)の保存と復元. BeginFrame から呼ばれる.
+  // 記録時は値を書き出し、再生時は同じ順序で値を上書きする.
+  virtual void SerializeFrameInputs(FrameArchive& archive) { }
+  // ベンチマークの設定一覧. 既定では現在の設定のみ.
+  virtual std::vector<BenchmarkVariant> GetBenchmarkVariants();
+  // ベンチマーク中の各フレームの前に呼ばれる. t は経路上の位置 [0, 1).
+  virtual void SetBenchmarkPose(float t) { }
+  // 1 フレームで行うユニフォームの書き込みサイズ列. ベンチマークでの更新方式の比較に使う.
+  // 既定では空で、比較は行わない.
+  virtual std::vector<uint32_t> GetUniformWriteSizes() { return {}; }
+
+  // ImGui のフレーム開始. ヘッドレス時は GLFW を使わない.
+  // GPU プロファイラのウィンドウもここで追加する.
+  void NewImGuiFrame();
+
+  // フレームの開始. このスロットを前回使ったフレームの完了を待ち、コマンドプールをリセットする.
+  // フレームのリソースへの書き込みはこの後に行い、スワップチェインイメージは frame.presentCompleted で取得する.
+  FrameContext& BeginFrame();
+  // frame.presentCompleted でスワップチェインイメージを取得する.
+  VkResult AcquireNextImage(FrameContext& frame, uint32_t* pImageIndex);
+  // frame.commandBuffer を発行して表示し、次のフレームへ進める.
+  // extraWaits/extraSignals は標準の待ち合わせ(取得完了/描画完了)に追加するもの.
+  void SubmitFrame(
+    uint32_t imageIndex,
+    uint32_t extraWaitCount = 0, const VkSemaphore* extraWaits = nullptr, const VkPipelineStageFlags* extraWaitStages = nullptr,
+    uint32_t extraSignalCount = 0, const VkSemaphore* extraSignals = nullptr);
+
+  VkDevice  m_device;
+  VkPhysicalDevice m_physicalDevice;
+  std::string m_preferredDevice;
+  VkInstance m_vkInstance;
+
+  VkPhysicalDeviceMemoryProperties m_physicalMemProps;
+  VkPhysicalDeviceProperties m_physicalDeviceProps;
+  bool m_isMemoryBudgetSupported;
+  // キューを介さずにデバイスとホストの時刻を同時に取得できる場合のみ true.
+  bool m_isCalibratedTimestampsSupported;
+  VkTimeDomainEXT m_hostTimeDomain;
+  PFN_vkGetCalibratedTimestampsEXT m_vkGetCalibratedTimestampsEXT;
+  // VK_EXT_descriptor_indexing とバインドレスに必要な機能がそろっている場合のみ true.
+  bool m_isBindlessSupported;
+  CapabilityProfile m_capabilityProfile;
+  VkPhysicalDeviceFeatures m_enabledFeatures;
+  std::chrono::high_resolution_clock::time_point m_startupLap;
+  std::vector<std::pair<const char*, double>> m_startupTimings;
+  VkQueue m_deviceQueue;
+  uint32_t  m_gfxQueueIndex;
+  VkQueue m_transferQueue;
+  uint32_t  m_transferQueueIndex;
+  VkQueue m_computeQueue;
+  uint32_t  m_computeQueueIndex;
+  // 各キューのファミリーの timestampValidBits. 0 の場合はタイムスタンプを書き込めない.
+  uint32_t m_gfxTimestampValidBits;
+  uint32_t m_computeTimestampValidBits;
+  VkCommandPool m_commandPool;
+  VkCommandPool m_computeCommandPool;
+  VkPipelineCache m_pipelineCache;
+  size_t m_pipelineCacheLoadedSize;
+
+  // 一時的な発行に使うコマンドバッファ/フェンスの再利用リスト.
+  std::vector<VkCommandBuffer> m_freeCommandBuffers;
+  std::vector<VkFence> m_freeFences;
+
+  // Prepare 中のドライバオブジェクト生成数.
+  struct DriverObjectStatistics
+  {
+    uint32_t commandBufferRequests;       // CreateCommandBuffer の呼び出し数.
+    uint32_t commandBufferAllocateCalls;  // vkAllocateCommandBuffers の呼び出し数.
+    uint32_t fenceRequests;               // CreateFence と FinishCommandBuffer で必要としたフェンス数.
+    uint32_t fenceCreations;              // vkCreateFence の呼び出し数.
+  };
+  DriverObjectStatistics m_driverObjectStats;
+
+  uint32_t m_framesInFlight;
+  uint32_t m_frameIndex;
+  uint32_t m_lastImageIndex;
+  std::vector<FrameContext> m_frames;
+  FrameStatistics m_frameStats;
+  TraceRecorder::Clock::time_point m_lastFrameTime;
+
+  // ImGui のフォント用. アプリのセットは m_descriptorAllocator から確保する.
+  VkDescriptorPool m_descriptorPool;
+  std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+  std::unique_ptr<BindlessDescriptorTable> m_bindlessTable;
+
+  std::unique_ptr<DeviceMemoryAllocator> m_memoryAllocator;
+  std::unique_ptr<UploadManager> m_uploadManager;
+  std::unique_ptr<ShaderLibrary> m_shaderLibrary;
+  // 処理中のフレーム数に合わせて CreateFrameContexts で作り直す.
+  std::unique_ptr<GpuProfiler> m_gpuProfiler;
+  // フェーズの区切りは BeginFrame/AcquireNextImage/SubmitFrame で記録する.
+  // 更新と記録の境界は各サンプルで Lap(Phase_Update) を呼ぶ.
+  std::unique_ptr<CpuProfiler> m_cpuProfiler;
+  // 記録/再生していない場合は null.
+  std::unique_ptr<FrameRecorder> m_frameRecorder;
+  // 各プロファイラから区間を受け取る. 開始の要求は次の BeginFrame で処理する.
+  std::unique_ptr<TraceRecorder> m_traceRecorder;
+  std::string m_traceRequestFile;
+  uint32_t m_traceRequestFrames;
+
+  BufferObject m_uniformRingBuffer;
+  std::unique_ptr<UniformRingBuffer> m_uniformRing;
+  std::vector<std::unique_ptr<RenderGraph>> m_renderGraphs;
+
+  bool m_isMinimizedWindow;
+  bool m_isFullscreen;
+  bool m_isHeadless;
+  // 退行検出では計測値の表示が画像を変えるため、プロファイラのウィンドウを出さない.
+  bool m_isProfilerHudVisible;
+  std::unique_ptr<Swapchain> m_swapchain;
+  GLFWwindow* m_window;
+  std::vector<ImageObject> m_offscreenImages;
+  // ヘッドレス時、オフスクリーンのイメージを最後に使ったフレームのフェンス.
+  // 取得の待ち合わせが無いため、再び使う前にこのフェンスを待つ.
+  std::vector<VkFence> m_offscreenImageFences;
+
+  using RenderPassRegistry = VulkanObjectStore<VkRenderPass>;
+  using PipelineLayoutManager = VulkanObjectStore<VkPipelineLayout>;
+  using DescriptorSetLayoutManager = VulkanObjectStore<VkDescriptorSetLayout>;
+  std::unique_ptr<RenderPassRegistry> m_renderPassStore;
+  std::unique_ptr<PipelineLayoutManager> m_pipelineLayoutStore;
+  std::unique_ptr<DescriptorSetLayoutManager> m_descriptorSetLayoutStore;
+
+  // 更新テンプレートはディスクリプタセットレイアウトと同じ名前で登録する.
+  using DescriptorUpdateTemplateManager = VulkanObjectStore<VkDescriptorUpdateTemplate>;
+  std::unique_ptr<DescriptorUpdateTemplateManager> m_descriptorUpdateTemplateStore;
+  // 更新テンプレートの Handle の番号で引く.
+  std::vector<DescriptorUpdateTemplateInfo> m_descriptorUpdateTemplates;
 };
\ No newline at end of file
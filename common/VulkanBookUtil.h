@@ -1,394 +1,672 @@
-#pragma once
-#include <vulkan/vulkan.h>
-#include <GLFW/glfw3.h>
-
-#include <fstream>
-#include <stdexcept>
-#include <functional>
-#include <vector>
-#include <array>
-
-#define STRINGFY(s)  #s
-#define TO_STRING(x) STRINGFY(x)
-#define FILE_PREFIX __FILE__ "(" TO_STRING(__LINE__) "): " 
-#define ThrowIfFailed(code, msg) book_util::CheckResultCodeVk(code, FILE_PREFIX msg)
-
-namespace book_util
-{
-  class VulkanException : public std::runtime_error
-  {
-  public:
-    VulkanException(const std::string& msg) : std::runtime_error(msg.c_str())
-    {
-    }
-  };
-
-  inline void CheckResultCodeVk(VkResult code, const std::string& errorMsg)
-  {
-    if (code != VK_SUCCESS)
-    {
-      throw VulkanException(errorMsg);
-    }
-  }
-
-  template<class T, class U>
-  void SafeDestroy(T& handle, U func)
-  {
-    if (handle != VK_NULL_HANDLE)
-    {
-      func(handle);
-    }
-    handle = VK_NULL_HANDLE;
-  }
-  
-  inline VkAttachmentDescription GetAttachmentDescription(VkFormat format, VkImageLayout before, VkImageLayout after, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT)
-  {
-    return VkAttachmentDescription{
-      0, format, samples,
-      VK_ATTACHMENT_LOAD_OP_CLEAR,
-      VK_ATTACHMENT_STORE_OP_STORE,
-      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-      VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      before,
-      after };
-  }
-
-  inline VkComponentMapping DefaultComponentMapping()
-  {
-    return VkComponentMapping{
-      VK_COMPONENT_SWIZZLE_R,VK_COMPONENT_SWIZZLE_G,VK_COMPONENT_SWIZZLE_B,VK_COMPONENT_SWIZZLE_A
-    };
-  }
-
-  inline VkPipelineColorBlendAttachmentState GetOpaqueColorBlendAttachmentState()
-  {
-    const auto colorWriteAll = \
-      VK_COLOR_COMPONENT_R_BIT | \
-      VK_COLOR_COMPONENT_G_BIT | \
-      VK_COLOR_COMPONENT_B_BIT | \
-      VK_COLOR_COMPONENT_A_BIT;
-    return VkPipelineColorBlendAttachmentState{
-      VK_TRUE, // blendEnable
-      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // color[Src/Dst] BlendFactor
-      VK_BLEND_OP_ADD,
-      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // alpha[Src/Dst] BlendFactor
-      VK_BLEND_OP_ADD,
-      colorWriteAll
-    };
-  }
-  inline VkPipelineColorBlendAttachmentState GetTransparentColorBlendAttachmentState()
-  {
-    const auto colorWriteAll = \
-      VK_COLOR_COMPONENT_R_BIT | \
-      VK_COLOR_COMPONENT_G_BIT | \
-      VK_COLOR_COMPONENT_B_BIT | \
-      VK_COLOR_COMPONENT_A_BIT;
-    return VkPipelineColorBlendAttachmentState{
-      VK_TRUE, // blendEnable
-      VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, // color[Src/Dst] BlendFactor
-      VK_BLEND_OP_ADD,
-      VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, // alpha[Src/Dst] BlendFactor
-      VK_BLEND_OP_ADD,
-      colorWriteAll
-    };
-  }
-
-  inline VkPipelineRasterizationStateCreateInfo GetDefaultRasterizerState( VkCullModeFlags cullmode = VK_CULL_MODE_NONE)
-  {
-    return VkPipelineRasterizationStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-      nullptr, 0,
-      VK_FALSE, // depthClampEnable
-      VK_FALSE, // rasterizerDiscardEnable
-      VK_POLYGON_MODE_FILL,
-      cullmode,
-      VK_FRONT_FACE_COUNTER_CLOCKWISE,
-      VK_FALSE, // depthBiasEnable
-      0.0f, 0.0f, 0.0f,
-      1.0f // lineWidth
-    };
-  }
-  inline VkPipelineDepthStencilStateCreateInfo GetDefaultDepthStencilState()
-  {
-    VkPipelineDepthStencilStateCreateInfo depthStencilCI{
-      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-      nullptr, 0,
-      VK_TRUE, // DepthTestEnable
-      VK_TRUE, // DepthWriteEnable
-      VK_COMPARE_OP_LESS_OR_EQUAL,
-      VK_FALSE,
-      VK_FALSE,
-      { VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_NEVER, 0, 0, 0 }, // front
-      { VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_NEVER, 0, 0, 0 }, // back
-      0.0f, 0.0f  // dpethBounds
-    };
-    return depthStencilCI;
-  }
-  inline VkPipelineInputAssemblyStateCreateInfo GetInputAssembly(VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
-  {
-    return VkPipelineInputAssemblyStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-      nullptr, 0, topology,
-      VK_FALSE,
-    };
-  }
-
-  inline VkPipelineMultisampleStateCreateInfo GetNoMultisampleState()
-  {
-    return VkPipelineMultisampleStateCreateInfo{
-      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-      nullptr, 0,
-      VK_SAMPLE_COUNT_1_BIT,
-      VK_FALSE, // sampleShadingEnable
-      0.0f, nullptr,
-      VK_FALSE, VK_FALSE,
-    };
-  }
-
-  inline VkPipelineShaderStageCreateInfo LoadShader(VkDevice device, const char* fileName, VkShaderStageFlagBits stage)
-  {
-    std::ifstream infile(fileName, std::ios::binary);
-    std::vector<char> code;
-    code.resize(uint32_t(infile.seekg(0, std::ifstream::end).tellg()));
-    infile.seekg(0, std::ifstream::beg).read(code.data(), code.size());
-
-    VkShaderModule module;
-    VkShaderModuleCreateInfo ci{
-      VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-      nullptr, 0,
-      code.size(),
-      reinterpret_cast<uint32_t*>(code.data()),
-    };
-    auto result = vkCreateShaderModule(device, &ci, nullptr, &module);
-    ThrowIfFailed(result, "vkCreateShaderModule Failed.");
-
-    VkPipelineShaderStageCreateInfo shaderStageCI{
-      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-      nullptr, 0,
-      stage,
-      module,
-      "main",
-      nullptr
-    };
-    return shaderStageCI;
-  }
-  
-  inline void DestroyShaderModules(VkDevice device, std::vector<VkPipelineShaderStageCreateInfo>& modules)
-  {
-    for (auto& shader : modules)
-    {
-      vkDestroyShaderModule(device, shader.module, nullptr);
-    }
-    modules.clear();
-  }
-
-  inline VkViewport GetViewportFlipped(float width, float height)
-  {
-    return VkViewport{
-      0.0f, height,
-      width, height * -1.0f,
-      0.0f, 1.0f
-    };
-  }
-
-  inline VkWriteDescriptorSet PrepareWriteDescriptorSet(
-    VkDescriptorSet descriptorSet, uint32_t dstBinding, VkDescriptorType type)
-  {
-    return VkWriteDescriptorSet{
-      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      nullptr,
-      descriptorSet,  // dstSet
-      // dstBinding, dstArrayElement, descriptorCount
-      dstBinding, 0, 1,
-      type,
-      nullptr, nullptr, nullptr,
-    };
-  }
-
-
-  inline VkRenderPass CreateRenderPass(VkDevice device, VkFormat colorFormat, VkFormat depthFormat)
-  {
-    std::array<VkAttachmentDescription, 2> attachments;
-    attachments[0] = VkAttachmentDescription{
-      0, colorFormat,
-      VK_SAMPLE_COUNT_1_BIT,
-      VK_ATTACHMENT_LOAD_OP_CLEAR,
-      VK_ATTACHMENT_STORE_OP_STORE,
-      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-      VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-    };
-    attachments[1] = VkAttachmentDescription{
-      0, depthFormat,
-      VK_SAMPLE_COUNT_1_BIT,
-      VK_ATTACHMENT_LOAD_OP_CLEAR,
-      VK_ATTACHMENT_STORE_OP_STORE,
-      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-      VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkAttachmentReference colorRef{
-      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    };
-    VkAttachmentReference depthRef{
-      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkSubpassDescription subpassDesc{
-      0, VK_PIPELINE_BIND_POINT_GRAPHICS,
-      0, nullptr, // InputAttachments
-      1, &colorRef,
-      nullptr,
-      &depthRef, 0, nullptr
-    };
-    VkRenderPassCreateInfo rpCI{
-      VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-      nullptr, 0,
-      uint32_t(attachments.size()), attachments.data(),
-      1, &subpassDesc,
-      0, nullptr,
-    };
-
-    VkRenderPass renderPass;
-    auto result = vkCreateRenderPass(device, &rpCI, nullptr, &renderPass);
-    ThrowIfFailed(result, "vkCreateRenderPass Failed.");
-    return renderPass;
-  }
-
-  inline VkRenderPass CreateRenderPassToRenderTarget(VkDevice device, VkFormat colorFormat, VkFormat depthFormat)
-  {
-    std::array<VkAttachmentDescription, 2> attachments;
-    attachments[0] = VkAttachmentDescription{
-      0, colorFormat,
-      VK_SAMPLE_COUNT_1_BIT,
-      VK_ATTACHMENT_LOAD_OP_CLEAR,
-      VK_ATTACHMENT_STORE_OP_STORE,
-      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-      VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    };
-    attachments[1] = VkAttachmentDescription{
-      0, depthFormat,
-      VK_SAMPLE_COUNT_1_BIT,
-      VK_ATTACHMENT_LOAD_OP_CLEAR,
-      VK_ATTACHMENT_STORE_OP_STORE,
-      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-      VK_ATTACHMENT_STORE_OP_DONT_CARE,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkAttachmentReference colorRef{
-      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    };
-    VkAttachmentReference depthRef{
-      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkSubpassDescription subpassDesc{
-      0, VK_PIPELINE_BIND_POINT_GRAPHICS,
-      0, nullptr, // InputAttachments
-      1, &colorRef,
-      nullptr, 
-      &depthRef, 0, nullptr
-    };
-    VkRenderPassCreateInfo rpCI{
-      VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-      nullptr, 0,
-      uint32_t(attachments.size()), attachments.data(),
-      1, &subpassDesc,
-      0, nullptr,
-    };
-
-    VkRenderPass renderPass;
-    auto result = vkCreateRenderPass(device, &rpCI, nullptr, &renderPass);
-    ThrowIfFailed(result, "vkCreateRenderPass Failed.");
-    return renderPass;
-  }
-
-  inline VkDescriptorSetAllocateInfo CreateDescriptorSetAllocateInfo(
-    VkDescriptorPool descriptorPool, VkDescriptorSetLayout layout)
-  {
-    return VkDescriptorSetAllocateInfo{
-      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-      nullptr, descriptorPool, 1, &layout
-    };
-  }
-
-  inline VkImageCreateInfo CreateEasyImageCreateInfo(
-    VkFormat format, VkExtent3D extent, VkImageUsageFlags usageFlags,
-    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT )
-  {
-    return VkImageCreateInfo{
-      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-      nullptr, 0,
-      VK_IMAGE_TYPE_2D,
-      format,
-      extent,
-      1, 1, samples,
-      VK_IMAGE_TILING_OPTIMAL,
-      usageFlags,
-      VK_SHARING_MODE_EXCLUSIVE,
-      0, nullptr,
-      VK_IMAGE_LAYOUT_UNDEFINED
-    };
-  }
-  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
-    VkDescriptorSet descriptorSet, uint32_t dstBinding, const VkDescriptorBufferInfo* pUboInfo)
-  {
-    return VkWriteDescriptorSet{
-      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      nullptr,
-      descriptorSet,
-      dstBinding, 0,
-      1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-      nullptr, pUboInfo, nullptr
-    };
-  }
-  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
-    VkDescriptorSet descriptorSet, uint32_t dstBinding, const VkDescriptorImageInfo* pImageInfo)
-  {
-    return VkWriteDescriptorSet{
-      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      nullptr,
-      descriptorSet,
-      dstBinding, 0,
-      1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-      pImageInfo, nullptr, nullptr
-    };
-  }
-  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
-    VkDescriptorSet dstSet, uint32_t dstBinding, VkDescriptorType type, const VkDescriptorBufferInfo* pBuffer)
-  {
-    return VkWriteDescriptorSet{
-      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      nullptr,
-      dstSet, dstBinding, 0,
-      1, type,
-      nullptr, pBuffer, nullptr
-    };
-  }
-  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
-    VkDescriptorSet dstSet, uint32_t dstBinding, VkDescriptorType type, const VkDescriptorImageInfo* pImageInfo)
-  {
-    return VkWriteDescriptorSet{
-      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-      nullptr,
-      dstSet, dstBinding, 0,
-      1, type,
-      pImageInfo, nullptr, nullptr
-    };
-  }
-
-
-  template<class T>
-  T* GetApplication(GLFWwindow* window)
-  {
-    return reinterpret_cast<T*>(glfwGetWindowUserPointer(window));
-  }
-
-}
+#pragma once
+#include <vulkan/vulkan.h>
+#include <GLFW/glfw3.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <functional>
+#include <vector>
+#include <array>
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifndef _countof
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+#define STRINGFY(s)  #s
+#define TO_STRING(x) STRINGFY(x)
+#define FILE_PREFIX __FILE__ "(" TO_STRING(__LINE__) "): " 
+#define ThrowIfFailed(code, msg) book_util::CheckResultCodeVk(code, FILE_PREFIX msg)
+
+namespace book_util
+{
+  class VulkanException : public std::runtime_error
+  {
+  public:
+    VulkanException(const std::string& msg) : std::runtime_error(msg.c_str())
+    {
+    }
+  };
+
+  inline void CheckResultCodeVk(VkResult code, const std::string& errorMsg)
+  {
+    if (code != VK_SUCCESS)
+    {
+      throw VulkanException(errorMsg);
+    }
+  }
+
+  // ログの出力. デバッガへの出力(Windows のみ)に加えて、コンソールでも読めるよう stream へも書き出す.
+  inline void WriteLog(const char* message, FILE* stream = stdout)
+  {
+#if defined(_WIN32)
+    OutputDebugStringA(message);
+#endif
+    fputs(message, stream);
+    fflush(stream);
+  }
+
+  // 環境変数の値. 設定されていない場合は空.
+  inline std::string GetEnvironmentValue(const char* name)
+  {
+#if defined(_WIN32)
+    char value[256];
+    auto length = GetEnvironmentVariableA(name, value, sizeof(value));
+    return (length > 0 && length < sizeof(value)) ? std::string(value, length) : std::string();
+#else
+    auto value = std::getenv(name);
+    return value != nullptr ? std::string(value) : std::string();
+#endif
+  }
+
+  // ディレクトリを作る(1 階層のみ). 既にある場合は何もしない.
+  inline void CreateDirectoryIfMissing(const std::string& path)
+  {
+#if defined(_WIN32)
+    CreateDirectoryA(path.c_str(), nullptr);
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+  }
+
+  template<class T, class U>
+  void SafeDestroy(T& handle, U func)
+  {
+    if (handle != VK_NULL_HANDLE)
+    {
+      func(handle);
+    }
+    handle = VK_NULL_HANDLE;
+  }
+  
+  inline VkAttachmentDescription GetAttachmentDescription(VkFormat format, VkImageLayout before, VkImageLayout after, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT)
+  {
+    return VkAttachmentDescription{
+      0, format, samples,
+      VK_ATTACHMENT_LOAD_OP_CLEAR,
+      VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      before,
+      after };
+  }
+
+  inline VkComponentMapping DefaultComponentMapping()
+  {
+    return VkComponentMapping{
+      VK_COMPONENT_SWIZZLE_R,VK_COMPONENT_SWIZZLE_G,VK_COMPONENT_SWIZZLE_B,VK_COMPONENT_SWIZZLE_A
+    };
+  }
+
+  inline VkPipelineColorBlendAttachmentState GetOpaqueColorBlendAttachmentState()
+  {
+    const auto colorWriteAll = \
+      VK_COLOR_COMPONENT_R_BIT | \
+      VK_COLOR_COMPONENT_G_BIT | \
+      VK_COLOR_COMPONENT_B_BIT | \
+      VK_COLOR_COMPONENT_A_BIT;
+    return VkPipelineColorBlendAttachmentState{
+      VK_TRUE, // blendEnable
+      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // color[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, // alpha[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      colorWriteAll
+    };
+  }
+  inline VkPipelineColorBlendAttachmentState GetTransparentColorBlendAttachmentState()
+  {
+    const auto colorWriteAll = \
+      VK_COLOR_COMPONENT_R_BIT | \
+      VK_COLOR_COMPONENT_G_BIT | \
+      VK_COLOR_COMPONENT_B_BIT | \
+      VK_COLOR_COMPONENT_A_BIT;
+    return VkPipelineColorBlendAttachmentState{
+      VK_TRUE, // blendEnable
+      VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, // color[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, // alpha[Src/Dst] BlendFactor
+      VK_BLEND_OP_ADD,
+      colorWriteAll
+    };
+  }
+
+  inline VkPipelineRasterizationStateCreateInfo GetDefaultRasterizerState( VkCullModeFlags cullmode = VK_CULL_MODE_NONE)
+  {
+    return VkPipelineRasterizationStateCreateInfo{
+      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+      nullptr, 0,
+      VK_FALSE, // depthClampEnable
+      VK_FALSE, // rasterizerDiscardEnable
+      VK_POLYGON_MODE_FILL,
+      cullmode,
+      VK_FRONT_FACE_COUNTER_CLOCKWISE,
+      VK_FALSE, // depthBiasEnable
+      0.0f, 0.0f, 0.0f,
+      1.0f // lineWidth
+    };
+  }
+  inline VkPipelineDepthStencilStateCreateInfo GetDefaultDepthStencilState()
+  {
+    VkPipelineDepthStencilStateCreateInfo depthStencilCI{
+      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+      nullptr, 0,
+      VK_TRUE, // DepthTestEnable
+      VK_TRUE, // DepthWriteEnable
+      VK_COMPARE_OP_LESS_OR_EQUAL,
+      VK_FALSE,
+      VK_FALSE,
+      { VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_NEVER, 0, 0, 0 }, // front
+      { VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_NEVER, 0, 0, 0 }, // back
+      0.0f, 0.0f  // dpethBounds
+    };
+    return depthStencilCI;
+  }
+  inline VkPipelineInputAssemblyStateCreateInfo GetInputAssembly(VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+  {
+    return VkPipelineInputAssemblyStateCreateInfo{
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+      nullptr, 0, topology,
+      VK_FALSE,
+    };
+  }
+
+  inline VkPipelineMultisampleStateCreateInfo GetNoMultisampleState()
+  {
+    return VkPipelineMultisampleStateCreateInfo{
+      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+      nullptr, 0,
+      VK_SAMPLE_COUNT_1_BIT,
+      VK_FALSE, // sampleShadingEnable
+      0.0f, nullptr,
+      VK_FALSE, VK_FALSE,
+    };
+  }
+
+  inline VkPipelineShaderStageCreateInfo LoadShader(VkDevice device, const char* fileName, VkShaderStageFlagBits stage)
+  {
+    std::ifstream infile(fileName, std::ios::binary);
+    std::vector<char> code;
+    code.resize(uint32_t(infile.seekg(0, std::ifstream::end).tellg()));
+    infile.seekg(0, std::ifstream::beg).read(code.data(), code.size());
+
+    VkShaderModule module;
+    VkShaderModuleCreateInfo ci{
+      VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      nullptr, 0,
+      code.size(),
+      reinterpret_cast<uint32_t*>(code.data()),
+    };
+    auto result = vkCreateShaderModule(device, &ci, nullptr, &module);
+    ThrowIfFailed(result, "vkCreateShaderModule Failed.");
+
+    VkPipelineShaderStageCreateInfo shaderStageCI{
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      nullptr, 0,
+      stage,
+      module,
+      "main",
+      nullptr
+    };
+    return shaderStageCI;
+  }
+  
+  inline void DestroyShaderModules(VkDevice device, std::vector<VkPipelineShaderStageCreateInfo>& modules)
+  {
+    for (auto& shader : modules)
+    {
+      vkDestroyShaderModule(device, shader.module, nullptr);
+    }
+    modules.clear();
+  }
+
+  inline VkViewport GetViewportFlipped(float width, float height)
+  {
+    return VkViewport{
+      0.0f, height,
+      width, height * -1.0f,
+      0.0f, 1.0f
+    };
+  }
+
+  inline VkWriteDescriptorSet PrepareWriteDescriptorSet(
+    VkDescriptorSet descriptorSet, uint32_t dstBinding, VkDescriptorType type)
+  {
+    return VkWriteDescriptorSet{
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,
+      descriptorSet,  // dstSet
+      // dstBinding, dstArrayElement, descriptorCount
+      dstBinding, 0, 1,
+      type,
+      nullptr, nullptr, nullptr,
+    };
+  }
+
+
+  // スワップチェインを使わない(ヘッドレスの)場合は layoutColor に PRESENT_SRC_KHR 以外を指定すること.
+  inline VkRenderPass CreateRenderPass(VkDevice device, VkFormat colorFormat, VkFormat depthFormat,
+    VkImageLayout layoutColor = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+  {
+    std::array<VkAttachmentDescription, 2> attachments;
+    attachments[0] = VkAttachmentDescription{
+      0, colorFormat,
+      VK_SAMPLE_COUNT_1_BIT,
+      VK_ATTACHMENT_LOAD_OP_CLEAR,
+      VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      layoutColor,
+    };
+    attachments[1] = VkAttachmentDescription{
+      0, depthFormat,
+      VK_SAMPLE_COUNT_1_BIT,
+      VK_ATTACHMENT_LOAD_OP_CLEAR,
+      VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+    };
+
+    VkAttachmentReference colorRef{
+      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+    VkAttachmentReference depthRef{
+      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+    };
+
+    VkSubpassDescription subpassDesc{
+      0, VK_PIPELINE_BIND_POINT_GRAPHICS,
+      0, nullptr, // InputAttachments
+      1, &colorRef,
+      nullptr,
+      &depthRef, 0, nullptr
+    };
+    VkRenderPassCreateInfo rpCI{
+      VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+      nullptr, 0,
+      uint32_t(attachments.size()), attachments.data(),
+      1, &subpassDesc,
+      0, nullptr,
+    };
+
+    VkRenderPass renderPass;
+    auto result = vkCreateRenderPass(device, &rpCI, nullptr, &renderPass);
+    ThrowIfFailed(result, "vkCreateRenderPass Failed.");
+    return renderPass;
+  }
+
+  inline VkRenderPass CreateRenderPassToRenderTarget(VkDevice device, VkFormat colorFormat, VkFormat depthFormat)
+  {
+    std::array<VkAttachmentDescription, 2> attachments;
+    attachments[0] = VkAttachmentDescription{
+      0, colorFormat,
+      VK_SAMPLE_COUNT_1_BIT,
+      VK_ATTACHMENT_LOAD_OP_CLEAR,
+      VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+    attachments[1] = VkAttachmentDescription{
+      0, depthFormat,
+      VK_SAMPLE_COUNT_1_BIT,
+      VK_ATTACHMENT_LOAD_OP_CLEAR,
+      VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+    };
+
+    VkAttachmentReference colorRef{
+      0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+    VkAttachmentReference depthRef{
+      1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+    };
+
+    VkSubpassDescription subpassDesc{
+      0, VK_PIPELINE_BIND_POINT_GRAPHICS,
+      0, nullptr, // InputAttachments
+      1, &colorRef,
+      nullptr, 
+      &depthRef, 0, nullptr
+    };
+    VkRenderPassCreateInfo rpCI{
+      VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+      nullptr, 0,
+      uint32_t(attachments.size()), attachments.data(),
+      1, &subpassDesc,
+      0, nullptr,
+    };
+
+    VkRenderPass renderPass;
+    auto result = vkCreateRenderPass(device, &rpCI, nullptr, &renderPass);
+    ThrowIfFailed(result, "vkCreateRenderPass Failed.");
+    return renderPass;
+  }
+
+  inline VkDescriptorSetAllocateInfo CreateDescriptorSetAllocateInfo(
+    VkDescriptorPool descriptorPool, VkDescriptorSetLayout layout)
+  {
+    return VkDescriptorSetAllocateInfo{
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      nullptr, descriptorPool, 1, &layout
+    };
+  }
+
+  inline VkImageCreateInfo CreateEasyImageCreateInfo(
+    VkFormat format, VkExtent3D extent, VkImageUsageFlags usageFlags,
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT )
+  {
+    return VkImageCreateInfo{
+      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      nullptr, 0,
+      VK_IMAGE_TYPE_2D,
+      format,
+      extent,
+      1, 1, samples,
+      VK_IMAGE_TILING_OPTIMAL,
+      usageFlags,
+      VK_SHARING_MODE_EXCLUSIVE,
+      0, nullptr,
+      VK_IMAGE_LAYOUT_UNDEFINED
+    };
+  }
+  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
+    VkDescriptorSet descriptorSet, uint32_t dstBinding, const VkDescriptorBufferInfo* pUboInfo)
+  {
+    return VkWriteDescriptorSet{
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,
+      descriptorSet,
+      dstBinding, 0,
+      1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      nullptr, pUboInfo, nullptr
+    };
+  }
+  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
+    VkDescriptorSet descriptorSet, uint32_t dstBinding, const VkDescriptorImageInfo* pImageInfo)
+  {
+    return VkWriteDescriptorSet{
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,
+      descriptorSet,
+      dstBinding, 0,
+      1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      pImageInfo, nullptr, nullptr
+    };
+  }
+  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
+    VkDescriptorSet dstSet, uint32_t dstBinding, VkDescriptorType type, const VkDescriptorBufferInfo* pBuffer)
+  {
+    return VkWriteDescriptorSet{
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,
+      dstSet, dstBinding, 0,
+      1, type,
+      nullptr, pBuffer, nullptr
+    };
+  }
+  inline VkWriteDescriptorSet CreateWriteDescriptorSet(
+    VkDescriptorSet dstSet, uint32_t dstBinding, VkDescriptorType type, const VkDescriptorImageInfo* pImageInfo)
+  {
+    return VkWriteDescriptorSet{
+      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      nullptr,
+      dstSet, dstBinding, 0,
+      1, type,
+      pImageInfo, nullptr, nullptr
+    };
+  }
+
+  inline bool IsImageDescriptor(VkDescriptorType type)
+  {
+    return type == VK_DESCRIPTOR_TYPE_SAMPLER || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+      type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+      type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+  }
+  inline bool IsTexelBufferDescriptor(VkDescriptorType type)
+  {
+    return type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER || type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+  }
+  // 更新テンプレートのデータ内で 1 つのディスクリプタが占める大きさ.
+  inline size_t GetDescriptorInfoSize(VkDescriptorType type)
+  {
+    if (IsImageDescriptor(type))
+    {
+      return sizeof(VkDescriptorImageInfo);
+    }
+    if (IsTexelBufferDescriptor(type))
+    {
+      return sizeof(VkBufferView);
+    }
+    return sizeof(VkDescriptorBufferInfo);
+  }
+
+  // レイアウトのバインディングの並びから更新テンプレートの項目を作る.
+  // データはバインディング順に VkDescriptorBufferInfo/VkDescriptorImageInfo/VkBufferView を詰めた構造体とする.
+  inline std::vector<VkDescriptorUpdateTemplateEntry> CreateDescriptorUpdateTemplateEntries(
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+  {
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+    size_t offset = 0;
+    for (const auto& b : bindings)
+    {
+      auto size = GetDescriptorInfoSize(b.descriptorType);
+      entries.push_back({ b.binding, 0, b.descriptorCount, b.descriptorType, offset, size });
+      offset += size * b.descriptorCount;
+    }
+    return entries;
+  }
+
+  // 更新テンプレートのデータと同じ内容の書き込み. pImageInfo 等は data の中を指す.
+  inline std::vector<VkWriteDescriptorSet> CreateWriteDescriptorSets(
+    VkDescriptorSet dstSet, const std::vector<VkDescriptorUpdateTemplateEntry>& entries, const void* data)
+  {
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(entries.size());
+    auto bytes = static_cast<const uint8_t*>(data);
+    for (const auto& e : entries)
+    {
+      VkWriteDescriptorSet write{
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        nullptr,
+        dstSet, e.dstBinding, e.dstArrayElement,
+        e.descriptorCount, e.descriptorType,
+        nullptr, nullptr, nullptr
+      };
+      auto p = bytes + e.offset;
+      if (IsImageDescriptor(e.descriptorType))
+      {
+        write.pImageInfo = reinterpret_cast<const VkDescriptorImageInfo*>(p);
+      }
+      else if (IsTexelBufferDescriptor(e.descriptorType))
+      {
+        write.pTexelBufferView = reinterpret_cast<const VkBufferView*>(p);
+      }
+      else
+      {
+        write.pBufferInfo = reinterpret_cast<const VkDescriptorBufferInfo*>(p);
+      }
+      writes.push_back(write);
+    }
+    return writes;
+  }
+
+
+  template<class T>
+  T* GetApplication(GLFWwindow* window)
+  {
+    return reinterpret_cast<T*>(glfwGetWindowUserPointer(window));
+  }
+
+  // ヘッドレス実行の指定. コマンドライン引数 "-headless <フレーム数> [-readback <ファイル名>]".
+  // "-benchmark <計測フレーム数> [-warmup <フレーム数>] [-report <ファイル名>]" はヘッドレスでのベンチマーク.
+  // "-regress <参照ディレクトリ> [-update] [-psnr <dB>] [-threshold <%>]" はヘッドレスでの退行検出.
+  // GPU の無い環境では lavapipe 等の CPU 実装の ICD を VK_ICD_FILENAMES で指定して実行する.
+  // "-device <番号または名前の一部>" は使用する物理デバイスの指定(ウィンドウ表示時も有効).
+  // "-record <ファイル名>" / "-replay <ファイル名>" はフレームの入力の記録と再生(ウィンドウ表示時も有効).
+  // ヘッドレスで再生する場合、フレーム数は記録されたものになる.
+  // "-trace <フレーム数> [-tracefile <ファイル名>]" は開始からのフレームの CPU/GPU の区間の書き出し(ウィンドウ表示時も有効).
+  struct HeadlessOptions
+  {
+    bool enabled;
+    uint32_t frameCount;
+    std::string readbackFile;
+    bool isBenchmark;
+    uint32_t warmupFrames;
+    std::string reportFile;
+    bool isRegression;
+    std::string referenceDir;
+    bool updateReference;
+    double minPsnr;
+    double maxSlowdownPercent;
+    std::string device;
+    std::string recordFile;
+    std::string replayFile;
+    uint32_t traceFrames;
+    std::string traceFile;
+  };
+  // コマンドラインを空白で区切る. ファイル名などは ASCII のみを想定.
+  inline std::vector<std::string> SplitCommandLine(const wchar_t* cmdLine)
+  {
+    std::vector<std::string> tokens;
+    std::wistringstream args(cmdLine != nullptr ? cmdLine : L"");
+    std::wstring arg;
+    while (args >> arg)
+    {
+      tokens.push_back(std::string(arg.begin(), arg.end()));
+    }
+    return tokens;
+  }
+
+  // オプションの値. 次の引数が '-' で始まる場合は省略されたものとして、次のオプションを読み進めない.
+  inline bool ParseOptionValue(const std::vector<std::string>& args, size_t& index, std::string& value)
+  {
+    if (index + 1 >= args.size() || args[index + 1].empty() || args[index + 1][0] == '-')
+    {
+      return false;
+    }
+    value = args[++index];
+    return true;
+  }
+  // 数値のオプションの値. 数値として読めない場合は値を省略したものとして扱う.
+  template<class T>
+  inline bool ParseOptionNumber(const std::vector<std::string>& args, size_t& index, T& number)
+  {
+    auto next = index;
+    std::string value;
+    if (!ParseOptionValue(args, next, value))
+    {
+      return false;
+    }
+    std::istringstream stream(value);
+    T parsed;
+    if (!(stream >> parsed) || !(stream >> std::ws).eof())
+    {
+      return false;
+    }
+    number = parsed;
+    index = next;
+    return true;
+  }
+
+  inline HeadlessOptions ParseHeadlessOptions(const std::vector<std::string>& args)
+  {
+    HeadlessOptions options{
+      false, 60, std::string(), false, 60, std::string("benchmark.json"),
+      false, std::string("regression"), false, 40.0, 10.0,
+      std::string(), std::string(), std::string(),
+      0, std::string("trace.json")
+    };
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+      const auto& arg = args[i];
+      if (arg == "-headless")
+      {
+        options.enabled = true;
+        ParseOptionNumber(args, i, options.frameCount);
+      }
+      else if (arg == "-benchmark")
+      {
+        options.enabled = true;
+        options.isBenchmark = true;
+        ParseOptionNumber(args, i, options.frameCount);
+      }
+      else if (arg == "-warmup")
+      {
+        ParseOptionNumber(args, i, options.warmupFrames);
+      }
+      else if (arg == "-readback")
+      {
+        ParseOptionValue(args, i, options.readbackFile);
+      }
+      else if (arg == "-report")
+      {
+        ParseOptionValue(args, i, options.reportFile);
+      }
+      else if (arg == "-regress")
+      {
+        if (ParseOptionValue(args, i, options.referenceDir))
+        {
+          options.enabled = true;
+          options.isRegression = true;
+        }
+      }
+      else if (arg == "-device")
+      {
+        ParseOptionValue(args, i, options.device);
+      }
+      else if (arg == "-record")
+      {
+        ParseOptionValue(args, i, options.recordFile);
+      }
+      else if (arg == "-replay")
+      {
+        ParseOptionValue(args, i, options.replayFile);
+      }
+      else if (arg == "-tracefile")
+      {
+        ParseOptionValue(args, i, options.traceFile);
+      }
+      else if (arg == "-trace")
+      {
+        ParseOptionNumber(args, i, options.traceFrames);
+      }
+      else if (arg == "-update")
+      {
+        options.updateReference = true;
+      }
+      else if (arg == "-psnr")
+      {
+        ParseOptionNumber(args, i, options.minPsnr);
+      }
+      else if (arg == "-threshold")
+      {
+        ParseOptionNumber(args, i, options.maxSlowdownPercent);
+      }
+    }
+    return options;
+  }
+
+}